@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cstring>
+#include "adaptive.h"
+#include "heapfile.h"
+#include "normkey.h"
+
+using namespace std;
+
+
+CrackerIndex::CrackerIndex(const AttrDesc & attrDesc, const int fileId,
+			   const int version)
+  : attrDesc(attrDesc), fileId(fileId), version(version)
+{
+}
+
+
+const AttrDesc & CrackerIndex::getAttr() const
+{
+  return attrDesc;
+}
+
+
+int CrackerIndex::getFileId() const
+{
+  return fileId;
+}
+
+
+int CrackerIndex::getVersion() const
+{
+  return version;
+}
+
+
+void CrackerIndex::setVersion(const int version)
+{
+  this->version = version;
+}
+
+
+unsigned long long CrackerIndex::makeKey(const void* value) const
+{
+  return keyPrefix((const char *)value, static_cast<Datatype>(attrDesc.attrType),
+		   attrDesc.attrLen);
+}
+
+
+void CrackerIndex::add(const char* tuple, const RID & rid)
+{
+  Entry e;
+  e.key = makeKey(tuple + attrDesc.attrOffset);
+  e.rid = rid;
+  entries.push_back(e);
+}
+
+
+// The new entry goes at the end of the last piece; for each piece, from
+// the last one back to the one it belongs in, the first entry of the
+// piece moves to the slot after its end, and the piece starts one
+// later (ripple insert).
+
+void CrackerIndex::insert(const char* tuple, const RID & rid)
+{
+  Entry e;
+  e.key = makeKey(tuple + attrDesc.attrOffset);
+  e.rid = rid;
+
+  int hole = entries.size();
+  entries.push_back(e);
+
+  map<unsigned long long, int>::reverse_iterator it;
+  for (it = pieces.rbegin(); it != pieces.rend() && it->first > e.key; ++it) {
+    entries[hole] = entries[it->second];
+    hole = it->second;
+    it->second++;
+  }
+  entries[hole] = e;
+}
+
+
+struct CrackerIndex::KeyBelow {
+  unsigned long long key;
+  bool operator()(const Entry & e) const { return e.key < key; }
+};
+
+
+// Split the piece that key falls in at key (unless it starts there) by
+// partitioning its entries, and return the position of the split.
+
+int CrackerIndex::crack(const unsigned long long key)
+{
+  map<unsigned long long, int>::iterator next = pieces.lower_bound(key);
+  if (next != pieces.end() && next->first == key)
+    return next->second;
+
+  const int end = (next == pieces.end()) ? (int)entries.size() : next->second;
+  int start = 0;
+  if (next != pieces.begin()) {
+    map<unsigned long long, int>::iterator prev = next;
+    start = (--prev)->second;
+  }
+
+  KeyBelow below;
+  below.key = key;
+  const int pos = partition(entries.begin() + start, entries.begin() + end, below)
+		  - entries.begin();
+  pieces.insert(next, make_pair(key, pos));
+  return pos;
+}
+
+
+void CrackerIndex::lookup(const Operator op, const void* attrValue,
+			  vector<RID> & rids)
+{
+  const unsigned long long key = makeKey(attrValue);
+  const bool last = (key == ~0ull);
+  int from = 0;
+  int to = entries.size();
+
+  switch (op) {
+  case LT:
+  case LTE: if (!last) to = crack(key + 1); break;
+  case GT:
+  case GTE: from = crack(key); break;
+  case EQ:  from = crack(key); if (!last) to = crack(key + 1); break;
+  default:  break;
+  }
+
+  rids.clear();
+  for (int i = from; i < to; i++)
+    rids.push_back(entries[i].rid);
+  sort(rids.begin(), rids.end());
+}
+
+
+int CrackerIndex::getRecCnt() const
+{
+  return entries.size();
+}
+
+
+int CrackerIndex::getPieceCnt() const
+{
+  return pieces.size() + 1;
+}
+
+
+// A map node holds the pair and about four pointers.
+
+int CrackerIndex::getBytes() const
+{
+  return sizeof(CrackerIndex) + entries.capacity() * sizeof(Entry)
+    + pieces.size() * (sizeof(pair<unsigned long long, int>) + 4 * sizeof(void *));
+}
+
+
+// The adaptive indexes, with the time of their last use, and the
+// # of filtered scans of each attribute ("relation.attribute").
+
+typedef struct {
+  CrackerIndex* index;
+  unsigned long lastUse;
+} ADAPTIVEINDEX;
+
+static vector<ADAPTIVEINDEX> indexes;
+static map<string, int> uses;
+static unsigned long useClock = 0;
+
+
+static bool sameAttr(const AttrDesc & a, const AttrDesc & b)
+{
+  return !strcmp(a.relName, b.relName) && a.attrOffset == b.attrOffset
+    && a.attrLen == b.attrLen && a.attrType == b.attrType;
+}
+
+
+static void dropIndex(const int i)
+{
+  delete indexes[i].index;
+  indexes.erase(indexes.begin() + i);
+}
+
+
+// Drop the least recently used indexes other than keep until all of
+// them fit in ADAPTIVEBYTES.
+
+static void dropLeastUsed(const CrackerIndex* keep)
+{
+  for (;;) {
+    int bytes = 0;
+    int victim = -1;
+    for (unsigned int i = 0; i < indexes.size(); i++) {
+      bytes += indexes[i].index->getBytes();
+      if (indexes[i].index != keep
+	  && (victim < 0 || indexes[i].lastUse < indexes[victim].lastUse))
+	victim = i;
+    }
+    if (bytes <= ADAPTIVEBYTES || victim < 0) return;
+    dropIndex(victim);
+  }
+}
+
+
+CrackerIndex* findAdaptiveIndex(const AttrDesc & attrDesc)
+{
+  for (unsigned int i = 0; i < indexes.size(); i++) {
+    if (!sameAttr(indexes[i].index->getAttr(), attrDesc)) continue;
+
+    Status status;
+    HeapFile hf(attrDesc.relName, status);
+    if (status != OK || hf.getFileId() != indexes[i].index->getFileId()
+	|| hf.getVersion() != indexes[i].index->getVersion()) {
+      dropIndex(i);
+      return NULL;
+    }
+    indexes[i].lastUse = ++useClock;
+    return indexes[i].index;
+  }
+  return NULL;
+}
+
+
+bool noteAdaptiveUse(const AttrDesc & attrDesc, const Operator op)
+{
+  if (op == NE || op == NOTSET || (op == EQ && attrDesc.indexed == 1))
+    return false;
+
+  const string name = string(attrDesc.relName) + "." + attrDesc.attrName;
+  return ++uses[name] >= ADAPTIVEUSES && !findAdaptiveIndex(attrDesc);
+}
+
+
+void addAdaptiveIndex(CrackerIndex* index)
+{
+  for (unsigned int i = 0; i < indexes.size(); i++) {
+    if (sameAttr(indexes[i].index->getAttr(), index->getAttr())) {
+      dropIndex(i);
+      break;
+    }
+  }
+
+  ADAPTIVEINDEX entry = {index, ++useClock};
+  indexes.push_back(entry);
+  dropLeastUsed(index);
+}
+
+
+void insertAdaptive(const string & relation, const char* tuple,
+		    const RID & rid, const int fileId,
+		    const int oldVersion, const int newVersion)
+{
+  for (unsigned int i = 0; i < indexes.size(); ) {
+    CrackerIndex* index = indexes[i].index;
+    if (relation != index->getAttr().relName) {
+      i++;
+    }
+    else if (index->getFileId() != fileId || index->getVersion() != oldVersion) {
+      dropIndex(i);
+    }
+    else {
+      index->insert(tuple, rid);
+      index->setVersion(newVersion);
+      i++;
+    }
+  }
+  dropLeastUsed(NULL);
+}
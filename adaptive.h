@@ -0,0 +1,96 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <map>
+#include <vector>
+#include "catalog.h"
+
+// Adaptive indexing: an attribute that filtered scans have selected on
+// ADAPTIVEUSES times gets an in-memory index, built by the next such
+// scan as it reads the relation. The indexes of all relations together
+// take at most ADAPTIVEBYTES bytes; the least recently used ones are
+// dropped to make room.
+#define ADAPTIVEUSES   3
+#define ADAPTIVEBYTES  (256 * 1024)
+
+
+// A cracker column: the key prefixes (see normkey.h) of an attribute
+// with the RIDs of their tuples, in an array that every lookup
+// partitions a little further around the values it looks up, so the
+// column becomes sorted where the queries go. pieces maps a key k to
+// the position of the first entry with a key >= k; the entries before
+// it all have smaller keys.
+//
+// A lookup returns a superset of the matches (equal prefixes of longer
+// strings are not told apart), so the predicate must be checked on the
+// tuples. The column is for the relation file getFileId() at version
+// getVersion() (see HeapFile::getFileId and HeapFile::getVersion).
+
+class CrackerIndex {
+ public:
+  CrackerIndex(const AttrDesc & attrDesc,   // the attribute
+	       const int fileId,            // id of the file of its relation
+	       const int version);          // version of its relation
+
+  const AttrDesc & getAttr() const;
+  int getFileId() const;
+  int getVersion() const;
+  void setVersion(const int version);
+
+  // add a tuple of the relation while the column is built
+  void add(const char* tuple, const RID & rid);
+
+  // add a tuple inserted into the relation, keeping the pieces
+  void insert(const char* tuple, const RID & rid);
+
+  // the RIDs of the tuples that may satisfy "attribute op attrValue",
+  // in page order; NE and NOTSET return all of them
+  void lookup(const Operator op, const void* attrValue,
+	      std::vector<RID> & rids);
+
+  int getRecCnt() const;                // # of entries
+  int getPieceCnt() const;              // # of pieces the column is in
+  int getBytes() const;                 // memory used
+
+ private:
+  typedef struct {
+    unsigned long long key;             // key prefix of the value
+    RID rid;                            // RID of its tuple
+  } Entry;
+  struct KeyBelow;                      // entries with a key below a given one
+
+  int crack(const unsigned long long key);
+  unsigned long long makeKey(const void* value) const;
+
+  AttrDesc attrDesc;
+  int fileId;
+  int version;
+  std::vector<Entry> entries;
+  std::map<unsigned long long, int> pieces;
+};
+
+
+// The adaptive index on the attribute, if there is one for the current
+// file and version of its relation; an index that is behind (or left
+// over from an earlier relation of the same name) is dropped.
+CrackerIndex* findAdaptiveIndex(const AttrDesc & attrDesc);
+
+// Count a filtered scan selecting "attribute op value". True if the scan
+// should build an adaptive index on the attribute: it has been filtered
+// on ADAPTIVEUSES times, has none yet, and op is one an index helps
+// with (a hash index already answers equalities).
+bool noteAdaptiveUse(const AttrDesc & attrDesc, const Operator op);
+
+// Keep an index that has been built (taking ownership of it), dropping
+// any other one on the attribute and the least recently used ones to
+// stay within ADAPTIVEBYTES.
+void addAdaptiveIndex(CrackerIndex* index);
+
+// Add a tuple inserted into a relation to its adaptive indexes that were
+// up to date before the insert (file fileId at oldVersion); the others
+// are dropped.
+void insertAdaptive(const string & relation, const char* tuple,
+		    const RID & rid, const int fileId,
+		    const int oldVersion, const int newVersion);
+
+#endif
@@ -0,0 +1,54 @@
+#include "catalog.h"
+#include "query.h"
+#include "exec.h"
+#include "adaptive.h"
+#include <cstring>
+
+
+/*
+ * Select using the adaptive index on the attribute of the first
+ * predicate. Looking the value up cracks the column further; the
+ * candidate records are fetched in page order and every predicate is
+ * checked on them before projecting. If the candidates are on too many
+ * pages, the relation is scanned instead.
+ */
+Status Operators::AdaptiveIndexSelect(const string& result,       // Name of the output relation
+				      const int projCnt,          // Number of attributes in the projection
+				      const AttrDesc projNames[], // Projection list (as AttrDesc)
+				      CrackerIndex &column,       // The adaptive index
+				      const int predCnt,          // Number of predicates
+				      const PredDesc preds[],     // The predicates
+				      const int reclen)           // Length of a tuple in the result relation
+{
+	Status status;
+	string relName(projNames[0].relName);
+
+	// Phase 1: collect the RIDs of the candidates, sorted by page
+	vector<RID> rids;
+	column.lookup(preds[0].op, preds[0].attrValue, rids);
+
+	int pageCnt = 0;
+	for(unsigned int i = 0; i < rids.size(); i ++){
+		if(i == 0 || rids[i].pageNo != rids[i - 1].pageNo)
+			pageCnt ++;
+	}
+
+	cout << "Adaptive index: " << rids.size() << " of " << column.getRecCnt()
+	     << " tuples, column in " << column.getPieceCnt() << " pieces" << endl;
+
+	HeapFile hf(relName, status);
+	if(status != OK) return status;
+
+	if(pageCnt > BITMAP_SCAN_THRESHOLD * hf.getPageCnt()){
+		return Operators::ConjScanSelect(result, projCnt, projNames, predCnt, preds, reclen);
+	}
+
+  	cout << "Algorithm: Adaptive Index Select" << endl;
+
+	// Phase 2: fetch the candidates, check the predicates and project
+	Iterator *fetch = new RIDScanIter(relName, rids);
+	Iterator *filter = new FilterIter(fetch, predCnt, preds);
+	ProjectIter plan(filter, projCnt, projNames, reclen);
+
+	return Operators::Drain(plan, result);
+}
@@ -0,0 +1,651 @@
+#include "catalog.h"
+#include "query.h"
+#include "sort.h"
+#include "normkey.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+int calTupleLength(const AttrDesc &attrDesc);
+
+
+/*
+ * Help function:
+ * 	compare two values of an attribute (as HeapFileScan::matchRec does)
+ *
+ * Return:
+ * 	a negative number, 0 or a positive number as the first value is
+ * 	less than, equal to or greater than the second
+ */
+static int compareValues(const char* value1, const char* value2, const AttrDesc &attrDesc)
+{
+	switch(attrDesc.attrType){
+		case INTEGER:
+			int i1, i2;
+			memcpy(&i1, value1, sizeof(int));
+			memcpy(&i2, value2, sizeof(int));
+			return (i1 > i2) - (i1 < i2);
+
+		case DOUBLE:
+			double d1, d2;
+			memcpy(&d1, value1, sizeof(double));
+			memcpy(&d2, value2, sizeof(double));
+			return (d1 > d2) - (d1 < d2);
+
+		default:
+			return strncmp(value1, value2, attrDesc.attrLen);
+	}
+}
+
+
+/*
+ * Help function:
+ * 	the value of a numeric attribute as a double
+ */
+static double numericValue(const char* value, const AttrDesc &attrDesc)
+{
+	if(attrDesc.attrType == INTEGER){
+		int i;
+		memcpy(&i, value, sizeof(int));
+		return i;
+	}
+
+	double d;
+	memcpy(&d, value, sizeof(double));
+	return d;
+}
+
+
+/*
+ * The groups of an aggregation. The key of a group, the normalized values
+ * of its grouping attributes one after the other (see normkey.h), is kept
+ * in a chained hash table with the output tuple of the group and its # of
+ * tuples. In the output tuple SUM and AVG add up the values and MIN and
+ * MAX keep the extreme one; COUNT and AVG are filled in when the tuple is
+ * written. With maxGroups 0 the table grows as needed.
+ */
+class GroupTable {
+public:
+	GroupTable(const int groupCnt, const AttrDesc groups[],
+		   const int aggCnt, const AggDesc aggs[],
+		   const int reclen, const int maxGroups, const int level);
+
+	// add a tuple to its group; false if the group is new and the
+	// table holds maxGroups groups already
+	bool add(const char* tuple);
+
+	// the partition of the last tuple add() turned away
+	int partition() const { return hashValue % AGGPARTITIONS; }
+
+	// write the output tuples of the groups to result and empty the table
+	Status write(HeapFile &result);
+
+	// bytes of memory a group takes
+	static int groupBytes(const int keyLen, const int reclen)
+		{ return keyLen + reclen + 3 * sizeof(int); }
+
+private:
+	unsigned int hash(const unsigned char* key) const;
+	int newGroup(const char* tuple);
+
+	int groupCnt;
+	const AttrDesc* groups;
+	int aggCnt;
+	const AggDesc* aggs;
+	int reclen;
+	int maxGroups;
+	int level;				// partitioning level, to seed the hash
+	int keyLen;				// length of the keys
+	int cnt;				// # of groups
+	vector<unsigned char> keys;		// the keys of the groups
+	vector<char> tuples;			// their output tuples
+	vector<int> counts;			// their # of tuples
+	vector<int> buckets;			// first group in each bucket, -1 if none
+	vector<int> chain;			// next group in the same bucket
+	vector<unsigned char> probeKey;		// key of the tuple being added
+	unsigned int hashValue;			// its hash
+};
+
+
+GroupTable::GroupTable(const int groupCnt, const AttrDesc groups[],
+		       const int aggCnt, const AggDesc aggs[],
+		       const int reclen, const int maxGroups, const int level)
+	: groupCnt(groupCnt), groups(groups), aggCnt(aggCnt), aggs(aggs),
+	  reclen(reclen), maxGroups(maxGroups), level(level), keyLen(0), cnt(0), hashValue(0)
+{
+	for(int i = 0; i < groupCnt; i ++)
+		keyLen += groups[i].attrLen;
+	probeKey.resize(keyLen + 1);
+	buckets.assign(16, -1);
+}
+
+
+/*
+ * FNV-1a over the key, seeded with the level so that the partitions of a
+ * partition do not all hash alike, and mixed so that its low bits (the
+ * partition) depend on all the bits of the key
+ */
+unsigned int GroupTable::hash(const unsigned char* key) const
+{
+	unsigned int h = 2166136261u + level * 0x9e3779b9u;
+	for(int i = 0; i < keyLen; i ++){
+		h ^= key[i];
+		h *= 16777619u;
+	}
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+
+int GroupTable::newGroup(const char* tuple)
+{
+	// one bucket per group at most
+	if(cnt == (int)buckets.size()){
+		buckets.assign(2 * buckets.size(), -1);
+		for(int g = 0; g < cnt; g ++){
+			const unsigned int b = (hash(&keys[g * keyLen]) / AGGPARTITIONS) & (buckets.size() - 1);
+			chain[g] = buckets[b];
+			buckets[b] = g;
+		}
+	}
+
+	keys.insert(keys.end(), probeKey.begin(), probeKey.begin() + keyLen);
+	counts.push_back(0);
+
+	tuples.resize((cnt + 1) * reclen);
+	char* out = &tuples[cnt * reclen];
+	memset(out, 0, reclen);
+
+	// the grouping attributes come first in the output tuple
+	int offset = 0;
+	for(int i = 0; i < groupCnt; i ++){
+		memcpy(out + offset, tuple + groups[i].attrOffset, groups[i].attrLen);
+		offset += groups[i].attrLen;
+	}
+	for(int i = 0; i < aggCnt; i ++){
+		if(aggs[i].func == AGG_MIN || aggs[i].func == AGG_MAX)
+			memcpy(out + aggs[i].offset, tuple + aggs[i].attrDesc.attrOffset, aggs[i].attrDesc.attrLen);
+	}
+
+	const unsigned int b = (hashValue / AGGPARTITIONS) & (buckets.size() - 1);
+	chain.push_back(buckets[b]);
+	buckets[b] = cnt;
+	return cnt ++;
+}
+
+
+bool GroupTable::add(const char* tuple)
+{
+	int pos = 0;
+	for(int i = 0; i < groupCnt; i ++){
+		normalizeKey(tuple + groups[i].attrOffset, static_cast<Datatype>(groups[i].attrType),
+			     groups[i].attrLen, &probeKey[pos]);
+		pos += groups[i].attrLen;
+	}
+	hashValue = hash(&probeKey[0]);
+
+	int g = buckets[(hashValue / AGGPARTITIONS) & (buckets.size() - 1)];
+	while(g >= 0 && memcmp(&keys[g * keyLen], &probeKey[0], keyLen))
+		g = chain[g];
+	if(g < 0){
+		if(maxGroups > 0 && cnt == maxGroups) return false;
+		g = newGroup(tuple);
+	}
+
+	counts[g] ++;
+	char* out = &tuples[g * reclen];
+	for(int i = 0; i < aggCnt; i ++){
+		const AttrDesc &attr = aggs[i].attrDesc;
+		const char* value = tuple + attr.attrOffset;
+		char* acc = out + aggs[i].offset;
+
+		switch(aggs[i].func){
+			case AGG_SUM:
+			case AGG_AVG:
+				double sum;
+				memcpy(&sum, acc, sizeof(double));
+				sum += numericValue(value, attr);
+				memcpy(acc, &sum, sizeof(double));
+				break;
+
+			case AGG_MIN:
+				if(compareValues(value, acc, attr) < 0)
+					memcpy(acc, value, attr.attrLen);
+				break;
+
+			case AGG_MAX:
+				if(compareValues(value, acc, attr) > 0)
+					memcpy(acc, value, attr.attrLen);
+				break;
+
+			default:
+				break;
+		}
+	}
+	return true;
+}
+
+
+Status GroupTable::write(HeapFile &result)
+{
+	Status status;
+
+	for(int g = 0; g < cnt; g ++){
+		char* out = &tuples[g * reclen];
+		for(int i = 0; i < aggCnt; i ++){
+			char* acc = out + aggs[i].offset;
+			if(aggs[i].func == AGG_COUNT){
+				memcpy(acc, &counts[g], sizeof(int));
+			}
+			else if(aggs[i].func == AGG_AVG){
+				double sum;
+				memcpy(&sum, acc, sizeof(double));
+				sum /= counts[g];
+				memcpy(acc, &sum, sizeof(double));
+			}
+		}
+
+		RID rid;
+		Record rec = {out, reclen};
+		status = result.insertRecord(rec, rid);
+		if(status != OK) return status;
+	}
+
+	cnt = 0;
+	keys.clear();
+	tuples.clear();
+	counts.clear();
+	chain.clear();
+	buckets.assign(buckets.size(), -1);
+	return OK;
+}
+
+
+/*
+ * Help function:
+ * 	create a temporary heap file for a partition of fileName, under a
+ * 	name no other file has (as for the runs of a SortedFile)
+ *
+ * Return:
+ * 	OK if success
+ *	Error code otherwise
+ */
+static Status createPartition(const string &fileName,	// the file being partitioned
+			      string &name,		// name of the partition file
+			      HeapFile* &file)		// the partition file, opened
+{
+	static int partFileCnt = 0;
+	Status status;
+
+	do{
+		ostringstream outputString;
+		outputString << fileName << ".agg." << ++partFileCnt;
+		name = outputString.str();
+	}while((status = db.createFile(name)) == FILEEXISTS);
+
+	if(status != OK) return status;
+	if((status = db.destroyFile(name)) != OK) return status;
+
+	file = new HeapFile(name, status);
+	return status;
+}
+
+
+/*
+ * Hash aggregation. The groups are added to a group table until it is
+ * full (the unpinned buffer pages); the tuples of the groups that do not
+ * fit go to the partitions their hash picks. When the input ends, the
+ * groups in the table are complete and written out, and the partitions,
+ * whose groups are disjoint, are aggregated one after the other.
+ */
+Status Operators::HashAggregate(HeapFile &result,		// The output relation
+				const string &fileName,		// The heap file to aggregate
+				const int tupleLen,		// Length of its tuples
+				const int groupCnt,		// Number of grouping attributes
+				const AttrDesc groups[],	// The grouping attributes
+				const int aggCnt,		// Number of aggregates
+				const AggDesc aggs[],		// The aggregates
+				const int reclen,		// Length of a tuple in the result relation
+				const int level)		// # of partitioning levels above
+{
+	Status status;
+
+	int keyLen = 0;
+	for(int i = 0; i < groupCnt; i ++)
+		keyLen += groups[i].attrLen;
+
+	// without grouping attributes there is only one group
+	const int pages = bufMgr->numUnpinnedPages() * 0.8;
+	const int maxGroups = max(1, (int)(pages * PAGESIZE) / GroupTable::groupBytes(keyLen, reclen));
+	GroupTable table(groupCnt, groups, aggCnt, aggs, reclen, groupCnt > 0 ? maxGroups : 0, level);
+
+	// Phase 1: aggregate the groups that fit, partition the others
+	HeapFile* parts[AGGPARTITIONS];
+	string partNames[AGGPARTITIONS];
+	for(int p = 0; p < AGGPARTITIONS; p ++)
+		parts[p] = NULL;
+
+	int tupleCnt = 0, spillCnt = 0, partCnt = 0;
+	{
+		HeapFileScan hfs(fileName, status);
+		if(status != OK) return status;
+
+		RID rid;
+		Record rec;
+		while((status = hfs.scanNext(rid, rec)) == OK){
+			tupleCnt ++;
+			if(table.add((char*)rec.data)) continue;
+
+			const int p = table.partition();
+			if(!parts[p]){
+				status = createPartition(fileName, partNames[p], parts[p]);
+				partCnt ++;
+			}
+			RID partRid;
+			if(status == OK) status = parts[p]->insertRecord(rec, partRid);
+			if(status != OK) break;
+			spillCnt ++;
+		}
+		if(status == FILEEOF) status = hfs.endScan();
+	}
+	if(status == OK) status = table.write(result);
+
+	for(int p = 0; p < AGGPARTITIONS; p ++)
+		delete parts[p];
+
+	if(status == OK && spillCnt > 0){
+		cout << "Aggregate: spilled " << spillCnt << " of " << tupleCnt << " tuples to "
+		     << partCnt << " partitions" << endl;
+	}
+
+	// Phase 2: the partitions, by hash with a new seed, or by sorting
+	// once there have been AGGMAXLEVELS levels
+	for(int p = 0; p < AGGPARTITIONS; p ++){
+		if(partNames[p].empty()) continue;
+
+		if(status == OK){
+			if(level + 1 < AGGMAXLEVELS)
+				status = Operators::HashAggregate(result, partNames[p], tupleLen, groupCnt, groups,
+								  aggCnt, aggs, reclen, level + 1);
+			else
+				status = Operators::SortAggregate(result, partNames[p], tupleLen, groupCnt, groups,
+								  aggCnt, aggs, reclen, 0, false);
+		}
+		Status destroyStatus = db.destroyFile(partNames[p]);
+		if(status == OK) status = destroyStatus;
+	}
+
+	return status;
+}
+
+
+/*
+ * Sort aggregation. The heap file is read in the order of the grouping
+ * attribute sortGroup; the groups of each run of equal values of it are
+ * collected in a group table and written out when the run ends. The
+ * table holds what fits in the unpinned buffer pages: the tuples of the
+ * other groups of the run go to a temporary file, which is aggregated
+ * in the order of the next grouping attribute once the run has ended.
+ * On the last grouping attribute a run is a single group.
+ */
+Status Operators::SortAggregate(HeapFile &result,		// The output relation
+				const string &fileName,		// The heap file to aggregate
+				const int tupleLen,		// Length of its tuples
+				const int groupCnt,		// Number of grouping attributes
+				const AttrDesc groups[],	// The grouping attributes
+				const int aggCnt,		// Number of aggregates
+				const AggDesc aggs[],		// The aggregates
+				const int reclen,		// Length of a tuple in the result relation
+				const int sortGroup,		// The grouping attribute to sort on
+				const bool cache)		// Use a sorted copy or clustering
+{
+	Status status;
+	const AttrDesc &sortAttr = groups[sortGroup];
+	const Datatype type = static_cast<Datatype>(sortAttr.attrType);
+
+	int keyLen = 0;
+	for(int i = 0; i < groupCnt; i ++)
+		keyLen += groups[i].attrLen;
+
+	// The file is sorted as in SMJ (see smj.cpp)
+	const RunGenerator runGen = SortedFile::sortThreads() > 1 ? PARALLEL_RUNS : REPLACEMENT_SELECTION;
+	int pages = bufMgr->numUnpinnedPages() * 0.8;
+	const int maxItems = max(2, (int)(pages * PAGESIZE) / tupleLen);
+	SortedFile sorted(fileName, sortAttr.attrOffset, sortAttr.attrLen, type, maxItems, status,
+			  0, runGen, cache);
+	if(status != OK) return status;
+
+	pages = bufMgr->numUnpinnedPages() * 0.8;
+	const int maxGroups = max(1, (int)(pages * PAGESIZE) / GroupTable::groupBytes(keyLen, reclen));
+	GroupTable table(groupCnt, groups, aggCnt, aggs, reclen, maxGroups, 0);
+	vector<unsigned char> runKey(sortAttr.attrLen), key(sortAttr.attrLen);
+	bool inRun = false;
+
+	// the tuples of the run the table has no room for
+	HeapFile* spill = NULL;
+	string spillName;
+	int spillCnt = 0;
+
+	Record rec;
+	while(true){
+		status = sorted.next(rec);
+		const bool eof = (status == FILEEOF);
+		if(status == OK)
+			normalizeKey((char*)rec.data + sortAttr.attrOffset, type, sortAttr.attrLen, &key[0]);
+		else if(!eof)
+			break;
+
+		// the end of a run: its groups are complete
+		if(inRun && (eof || key != runKey)){
+			status = table.write(result);
+			if(status == OK && spill){
+				delete spill;
+				spill = NULL;
+				status = Operators::SortAggregate(result, spillName, tupleLen, groupCnt, groups,
+								  aggCnt, aggs, reclen, sortGroup + 1, false);
+				Status destroyStatus = db.destroyFile(spillName);
+				if(status == OK) status = destroyStatus;
+			}
+			if(status != OK) break;
+		}
+		if(eof){
+			status = OK;
+			break;
+		}
+		runKey.swap(key);
+		inRun = true;
+
+		if(table.add((char*)rec.data)) continue;
+
+		if(!spill) status = createPartition(fileName, spillName, spill);
+		RID rid;
+		if(status == OK) status = spill->insertRecord(rec, rid);
+		if(status != OK) break;
+		spillCnt ++;
+	}
+
+	if(spill){
+		delete spill;
+		(void)db.destroyFile(spillName);
+	}
+
+	if(status == OK && spillCnt > 0){
+		cout << "Aggregate: spilled " << spillCnt << " tuples of runs of " << sortAttr.attrName
+		     << " to be sorted on " << groups[sortGroup + 1].attrName << endl;
+	}
+	return status;
+}
+
+
+/*
+ * Help function:
+ * 	check that the output relation has the attributes of an aggregation:
+ * 	for each grouping attribute and then each aggregate, in this order,
+ * 	one of the same type and length at the offset the value is written to
+ *
+ * Return:
+ * 	OK if so
+ *	Error code otherwise
+ */
+static Status checkResult(const string &result,		// The output relation
+			  const int groupCnt,		// Number of grouping attributes
+			  const AttrDesc groups[],	// The grouping attributes
+			  const int aggCnt,		// Number of aggregates
+			  const AggDesc aggs[])		// The aggregates
+{
+	Status status;
+	int attrCnt;
+	AttrDesc* attrs;
+
+	status = attrCat->getRelInfo(result, attrCnt, attrs);
+	if(status != OK) return status;
+
+	status = (attrCnt == groupCnt + aggCnt) ? OK : ATTRTYPEMISMATCH;
+	int offset = 0;
+	for(int k = 0; status == OK && k < groupCnt + aggCnt; k ++){
+		int type, length;
+		if(k < groupCnt){
+			type = groups[k].attrType;
+			length = groups[k].attrLen;
+		}
+		else{
+			const AggDesc &agg = aggs[k - groupCnt];
+			switch(agg.func){
+				case AGG_COUNT: type = INTEGER; length = sizeof(int); break;
+				case AGG_SUM:
+				case AGG_AVG:   type = DOUBLE; length = sizeof(double); break;
+				default:        type = agg.attrDesc.attrType; length = agg.attrDesc.attrLen; break;
+			}
+			offset = agg.offset;
+		}
+
+		int i = 0;
+		while(i < attrCnt && attrs[i].attrOffset != offset) i ++;
+		if(i == attrCnt || attrs[i].attrType != type || attrs[i].attrLen != length)
+			status = ATTRTYPEMISMATCH;
+		offset += length;
+	}
+
+	delete []attrs;
+	return status;
+}
+
+
+/*
+ * Aggregates a relation
+ *
+ * Ungrouped COUNTs are answered from the tuple count of the heap file.
+ * A relation that can be read in the order of the first grouping
+ * attribute (clustered or with a sorted copy) is aggregated by sorting,
+ * any other by hashing.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise
+ */
+Status Operators::Aggregate(const string& result,		// Name of the output relation
+			    const int groupCnt,			// Number of grouping attributes
+			    const attrInfo groupNames[],	// The grouping attributes
+			    const int aggCnt,			// Number of aggregates
+			    const aggInfo aggs[])		// The aggregates
+{
+	Status status;
+
+	if(groupCnt + aggCnt == 0) return BADCATPARM;
+	const string relName(groupCnt > 0 ? groupNames[0].relName : aggs[0].attr.relName);
+
+	// convert the grouping attributes and the aggregates to AttrDesc,
+	// laying out the output tuple: the grouping attributes, then the
+	// aggregates
+	vector<AttrDesc> groupDescs(groupCnt + 1);
+	int reclen = 0;
+	status = Operators::ConvertFromInfoToDesc(groupNames, groupCnt, &groupDescs[0], reclen);
+	if(status != OK) return status;
+
+	vector<AggDesc> aggDescs(aggCnt + 1);
+	bool countOnly = true;
+	for(int i = 0; i < aggCnt; i ++){
+		AggDesc &agg = aggDescs[i];
+		agg.func = aggs[i].func;
+		agg.offset = reclen;
+
+		if(agg.func == AGG_COUNT && aggs[i].attr.attrName[0] == '\0'){
+			memset(&agg.attrDesc, 0, sizeof(AttrDesc));
+			strcpy(agg.attrDesc.relName, relName.c_str());
+			reclen += sizeof(int);
+			continue;
+		}
+
+		status = attrCat->getInfo(aggs[i].attr.relName, aggs[i].attr.attrName, agg.attrDesc);
+		if(status != OK) return status;
+
+		switch(agg.func){
+			case AGG_COUNT:
+				reclen += sizeof(int);
+				break;
+
+			case AGG_SUM:
+			case AGG_AVG:
+				if(agg.attrDesc.attrType == STRING) return ATTRTYPEMISMATCH;
+				reclen += sizeof(double);
+				countOnly = false;
+				break;
+
+			default:
+				reclen += agg.attrDesc.attrLen;
+				countOnly = false;
+				break;
+		}
+	}
+
+	// all the attributes must be of the one relation
+	for(int i = 0; i < groupCnt; i ++)
+		if(relName != groupDescs[i].relName) return BADCATPARM;
+	for(int i = 0; i < aggCnt; i ++)
+		if(relName != aggDescs[i].attrDesc.relName) return BADCATPARM;
+
+	status = checkResult(result, groupCnt, &groupDescs[0], aggCnt, &aggDescs[0]);
+	if(status != OK) return status;
+
+	HeapFile hf(result, status);
+	if(status != OK){
+		cerr << "Open heap file for storing the results of the aggregation failed!" << endl;
+		return status;
+	}
+
+	// COUNT(*) of the whole relation: the tuple count in its header page
+	if(groupCnt == 0 && countOnly){
+  		cout << "Algorithm: Header Count" << endl;
+
+		int recCnt;
+		status = Operators::GetRecCnt(relName, recCnt);
+		if(status != OK) return status;
+
+		vector<char> tuple(reclen);
+		for(int i = 0; i < aggCnt; i ++)
+			memcpy(&tuple[aggDescs[i].offset], &recCnt, sizeof(int));
+
+		RID rid;
+		Record rec = {&tuple[0], reclen};
+		return hf.insertRecord(rec, rid);
+	}
+
+	AttrDesc relDesc;
+	memset(&relDesc, 0, sizeof(AttrDesc));
+	strcpy(relDesc.relName, relName.c_str());
+	const int tupleLen = calTupleLength(relDesc);
+
+	if(groupCnt > 0 && Operators::StoredInOrder(groupDescs[0])){
+  		cout << "Algorithm: Sort Aggregate" << endl;
+		return Operators::SortAggregate(hf, relName, tupleLen, groupCnt, &groupDescs[0],
+						aggCnt, &aggDescs[0], reclen, 0, true);
+	}
+
+  	cout << "Algorithm: Hash Aggregate" << endl;
+	return Operators::HashAggregate(hf, relName, tupleLen, groupCnt, &groupDescs[0],
+					aggCnt, &aggDescs[0], reclen, 0);
+}
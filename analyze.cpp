@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <vector>
+#include "catalog.h"
+#include "utility.h"
+#include "stats.h"
+#include "normkey.h"
+
+using namespace std;
+
+
+// Pseudo-random numbers for the sample (xorshift64); the seed is fixed
+// so that analyzing the same relation gives the same statistics.
+
+static unsigned long long nextRandom(unsigned long long & state)
+{
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+
+//
+// Collects the statistics of each attribute of the specified relation
+// (see StatCatalog) in one scan of it. Every value goes into the
+// HyperLogLog sketch and the range of the attribute; the histogram is
+// built from a uniform sample of the tuples (reservoir sampling), whose
+// sorted values are cut into buckets of the same # of tuples.
+//
+// Returns:
+// 	OK on success
+// 	an error code otherwise
+//
+
+Status Utilities::Analyze(const string & relation)
+{
+  Status status;
+  RelDesc rd;
+  AttrDesc *attrs;
+  int attrCnt;
+
+  if ((status = relCat->getInfo(relation, rd)) != OK)
+    return status;
+  if ((status = attrCat->getRelInfo(rd.relName, attrCnt, attrs)) != OK)
+    return status;
+
+  vector<AttrStatsDesc> stats(attrCnt);
+  for(int i = 0; i < attrCnt; i++)
+    initStats(stats[i], attrs[i]);
+
+  // sample[i] holds the key prefixes of attribute i of the sampled tuples
+  vector<vector<unsigned long long> > sample(attrCnt);
+  unsigned long long state = 88172645463325252ull;
+  int recCnt = 0;
+  int pageCnt = 0;
+
+  {
+    HeapFileScan hfile(rd.relName, status);
+    if (status == OK)
+      status = hfile.startScan(0, 0, INTEGER, NULL, EQ);
+    if (status != OK) {
+      delete [] attrs;
+      return status;
+    }
+
+    Record rec;
+    RID rid;
+    while((status = hfile.scanNext(rid, rec)) == OK) {
+      // the tuple replaces a random one of the sample with probability
+      // STATSAMPLE / (# of tuples so far)
+      int slot = recCnt;
+      if (recCnt >= STATSAMPLE)
+        slot = nextRandom(state) % (recCnt + 1);
+      recCnt++;
+
+      for(int i = 0; i < attrCnt; i++) {
+        const char *tuple = (const char *)rec.data;
+        addValue(stats[i], tuple);
+        if (slot >= STATSAMPLE)
+          continue;
+
+        const unsigned long long key =
+          keyPrefix(tuple + attrs[i].attrOffset,
+                    static_cast<Datatype>(attrs[i].attrType), attrs[i].attrLen);
+        if (slot < (int)sample[i].size())
+          sample[i][slot] = key;
+        else
+          sample[i].push_back(key);
+      }
+    }
+    if (status == FILEEOF)
+      status = hfile.endScan();
+    pageCnt = hfile.getPageCnt();
+  }
+  if (status != OK) {
+    delete [] attrs;
+    return status;
+  }
+
+  // equi-depth histograms: bucket b ends at sampled value
+  // (b + 1) * n / bucketCnt, and has its share of all the tuples
+  StatCatalog statCat(status);
+  for(int i = 0; status == OK && i < attrCnt; i++) {
+    vector<unsigned long long> & keys = sample[i];
+    sort(keys.begin(), keys.end());
+
+    const int n = keys.size();
+    stats[i].recCnt = recCnt;
+    stats[i].pageCnt = pageCnt;
+    stats[i].bucketCnt = min(STATBUCKETS, n);
+
+    int start = 0;
+    for(int b = 0; b < stats[i].bucketCnt; b++) {
+      const int end = (long long)(b + 1) * n / stats[i].bucketCnt;
+      stats[i].bucketHi[b] = keys[end - 1];
+      stats[i].bucketRecs[b] = (int)((double)recCnt * end / n + 0.5)
+                               - (int)((double)recCnt * start / n + 0.5);
+      start = end;
+    }
+
+    status = statCat.addInfo(stats[i]);
+  }
+
+  delete [] attrs;
+  return status;
+}
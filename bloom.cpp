@@ -0,0 +1,96 @@
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include "bloom.h"
+#include "catalog.h"
+#include "normkey.h"
+
+using namespace std;
+
+#define FNVOFFSET 14695981039346656037ull
+#define FNVPRIME  1099511628211ull
+
+
+BloomFilter::BloomFilter(const int keyCnt, const Datatype type, const int length)
+  : setCnt(0), type(type), length(length), probeCnt(0), passCnt(0)
+{
+  bitCnt = (unsigned long long)(keyCnt > 0 ? keyCnt : 1) * BLOOMBITSPERKEY;
+  bitCnt = (bitCnt + 7) & ~7ull;
+  bits.assign(bitCnt / 8, 0);
+}
+
+
+// Hash the normalized key with FNV-1a. The BLOOMHASHES bit positions
+// are h1 + i * h2 (double hashing), with h2 the upper half of the hash
+// made odd. An attribute is at most MAXSTRINGLEN bytes long, so the
+// normalized key fits in a buffer on the stack.
+
+void BloomFilter::hash(const char* key, unsigned long long & h1,
+		       unsigned long long & h2) const
+{
+  unsigned char norm[MAXSTRINGLEN + 1];
+  normalizeKey(key, type, length, norm);
+
+  unsigned long long h = FNVOFFSET;
+  for (int i = 0; i < length; i++) {
+    h ^= norm[i];
+    h *= FNVPRIME;
+  }
+
+  h1 = h;
+  h2 = (h >> 32) | 1;
+}
+
+
+void BloomFilter::add(const char* key)
+{
+  unsigned long long h1, h2;
+  hash(key, h1, h2);
+
+  for (int i = 0; i < BLOOMHASHES; i++) {
+    unsigned long long bit = (h1 + i * h2) % bitCnt;
+    unsigned char mask = 1 << (bit & 7);
+    if (!(bits[bit >> 3] & mask)) {
+      bits[bit >> 3] |= mask;
+      setCnt++;
+    }
+  }
+}
+
+
+bool BloomFilter::probe(const char* key)
+{
+  unsigned long long h1, h2;
+  hash(key, h1, h2);
+  probeCnt++;
+
+  for (int i = 0; i < BLOOMHASHES; i++) {
+    unsigned long long bit = (h1 + i * h2) % bitCnt;
+    if (!(bits[bit >> 3] & (1 << (bit & 7))))
+      return false;
+  }
+
+  passCnt++;
+  return true;
+}
+
+
+// A key that was never added passes if all its bits happen to be set,
+// i.e. with probability (fraction of bits set) ^ BLOOMHASHES.
+
+double BloomFilter::falsePositiveRate() const
+{
+  return pow((double)setCnt / bitCnt, BLOOMHASHES);
+}
+
+
+void BloomFilter::printStats() const
+{
+  char line[128];
+
+  snprintf(line, sizeof(line),
+	   "Bloom filter: %d of %d tuples passed (%.1f%%), est. false positive rate %.2f%%",
+	   passCnt, probeCnt, probeCnt > 0 ? 100.0 * passCnt / probeCnt : 0.0,
+	   100.0 * falsePositiveRate());
+  cout << line << endl;
+}
@@ -0,0 +1,46 @@
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <vector>
+#include "datatypes.h"
+
+// A Bloom filter is sized with BLOOMBITSPERKEY bits for each key it is
+// built from and sets BLOOMHASHES bits per key, which gives about 1%
+// false positives when it holds as many keys as it was sized for.
+#define BLOOMBITSPERKEY 10
+#define BLOOMHASHES     7
+
+
+// A Bloom filter over the values of a join attribute, used for
+// semi-join reduction: it is built from the join keys of one relation
+// and the tuples of the other relation whose keys it rejects cannot
+// join. Keys are hashed in their normalized form (see normkey.h), so
+// only values that are equal as bytes of that form match. The filter
+// counts the keys it is probed with, for the operator statistics.
+
+class BloomFilter {
+ public:
+  BloomFilter(const int keyCnt,         // expected # of keys
+	      const Datatype type,      // type of the keys
+	      const int length);        // length of the keys
+
+  void add(const char* key);            // add a key
+  bool probe(const char* key);          // false if the key was never added
+
+  double falsePositiveRate() const;     // estimated from the bits set
+  void printStats() const;              // print selectivity and error rate
+
+ private:
+  void hash(const char* key, unsigned long long & h1,
+	    unsigned long long & h2) const;
+
+  std::vector<unsigned char> bits;      // the bit array
+  unsigned long long bitCnt;            // # of bits in the array
+  unsigned long long setCnt;            // # of bits set
+  Datatype type;                        // type of the keys
+  int length;                           // length of the keys
+  int probeCnt;                         // # of keys probed
+  int passCnt;                          // # of probed keys that passed
+};
+
+#endif
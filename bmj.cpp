@@ -0,0 +1,116 @@
+#include "catalog.h"
+#include "query.h"
+#include "sort.h"
+#include "index.h"
+#include "projection.h"
+#include <cstring>
+#include <cassert>
+
+// defined in smj.cpp
+int calTupleLength(const AttrDesc &attrDesc);
+
+
+/*
+ * Band merge join: evaluates a join with an inequality predicate
+ * (LT, LTE, GT, GTE) on two relations sorted on the join attributes.
+ *
+ * The predicate is first turned around so that it reads
+ * "outer attribute < (or <=) inner attribute": for GT and GTE the
+ * right relation is the outer one. With both relations in ascending
+ * order, the inner tuples that qualify for an outer tuple are then a
+ * suffix of the inner relation, and the suffix of the next outer tuple
+ * starts at the same place or later. For each outer tuple the inner
+ * relation is advanced to the start of its suffix, the start is marked,
+ * the suffix is emitted and the inner relation goes back to the mark.
+ * Apart from the sorts the cost is that of the output.
+ */
+
+Status Operators::BMJ(const string& result,           // Output relation name
+                      const int projCnt,              // Number of attributes in the projection
+                      const AttrDesc attrDescArray[], // Projection list (as AttrDesc)
+                      const AttrDesc& attrDesc1,      // The left attribute in the join predicate
+                      const Operator op,              // Predicate operator
+                      const AttrDesc& attrDesc2,      // The right attribute in the join predicate
+                      const int reclen)               // The length of a tuple in the result relation
+{
+  	cout << "Algorithm: Band Merge Join" << endl;
+
+	Status status;
+
+	if(op != LT && op != LTE && op != GT && op != GTE) return BADSCANPARM;
+
+	// attrDesc1 op attrDesc2  <=>  outer < (<=) inner
+	const bool swapped = (op == GT || op == GTE);
+	const bool strict = (op == LT || op == GT);
+	const AttrDesc& outerDesc = swapped ? attrDesc2 : attrDesc1;
+	const AttrDesc& innerDesc = swapped ? attrDesc1 : attrDesc2;
+
+	// The relations are sorted as in SMJ (see smj.cpp)
+	const RunGenerator runGen = SortedFile::sortThreads() > 1 ? PARALLEL_RUNS : REPLACEMENT_SELECTION;
+
+	// Open the heap file for storing the resulting record
+	HeapFile result_hf(result, status);
+	if(status != OK)	return status;
+
+	// the projection list, compiled once for all the result tuples
+	Projection proj(attrDesc1.relName, projCnt, attrDescArray, reclen);
+
+	// Step 1: Sort the outer and the inner relation on their join attributes
+	unsigned int ava_pages_num = bufMgr->numUnpinnedPages() * 0.8;
+	int outer_max_tuples = ava_pages_num * PAGESIZE / calTupleLength(outerDesc);
+	SortedFile sf_outer(outerDesc.relName, outerDesc.attrOffset, outerDesc.attrLen,
+			    static_cast<Datatype>(outerDesc.attrType), outer_max_tuples, status,
+			    0, runGen, true);
+	if(status != OK){ return status;  }
+
+	ava_pages_num = bufMgr->numUnpinnedPages() * 0.8;
+	int inner_max_tuples = ava_pages_num * PAGESIZE / calTupleLength(innerDesc);
+	SortedFile sf_inner(innerDesc.relName, innerDesc.attrOffset, innerDesc.attrLen,
+			    static_cast<Datatype>(innerDesc.attrType), inner_max_tuples, status,
+			    0, runGen, true);
+	if(status != OK){ return status;  }
+
+	// Step 2: Slide the start of the qualifying suffix of the inner relation
+	Record outerRec, innerRec;
+	Status outerStatus = sf_outer.next(outerRec);
+	Status innerStatus = sf_inner.next(innerRec);
+
+	while(outerStatus == OK && innerStatus == OK){
+		// Skip the inner tuples that are too small for this outer tuple;
+		// they are too small for all the following ones as well
+		int diff = Operators::matchRec(outerRec, innerRec, outerDesc, innerDesc);
+		while(strict ? diff >= 0 : diff > 0){
+			innerStatus = sf_inner.next(innerRec);
+			if(innerStatus != OK) break;
+			diff = Operators::matchRec(outerRec, innerRec, outerDesc, innerDesc);
+		}
+		if(innerStatus != OK) break;
+
+		// Emit the suffix starting at the marked inner tuple
+		status = sf_inner.setMark();
+		if(status != OK) return status;
+
+		while(innerStatus == OK){
+			if(swapped)
+				status = proj.insert(result_hf, innerRec.data, outerRec.data);
+			else
+				status = proj.insert(result_hf, outerRec.data, innerRec.data);
+			if(status != OK)  return status;
+
+			innerStatus = sf_inner.next(innerRec);
+		}
+		if(innerStatus != FILEEOF)  return innerStatus;
+
+		// Go back to the start of the suffix for the next outer tuple
+		status = sf_inner.gotoMark();
+		if(status != OK) return status;
+		innerStatus = sf_inner.next(innerRec);
+
+		outerStatus = sf_outer.next(outerRec);
+	}
+
+	if(outerStatus != OK && outerStatus != FILEEOF)  return outerStatus;
+	if(innerStatus != OK && innerStatus != FILEEOF)  return innerStatus;
+
+  	return OK;
+}
@@ -0,0 +1,42 @@
+#include "catalog.h"
+#include "query.h"
+#include "exec.h"
+#include <cstring>
+#include <iostream>
+
+int calTupleLength(const AttrDesc &attrDesc);
+
+/* 
+ * Block nested-loops join with attrDesc1 as the outer relation 
+ * and attrDesc2 as the inner relation
+ */
+
+Status Operators::BNL(const string& result,           // Name of the output relation
+                      const int projCnt,              // Number of attributes in the projection
+                      const AttrDesc attrDescArray[], // The projection list (as AttrDesc)
+                      const AttrDesc& attrDesc1,      // The left attribute in the join predicate
+                      const Operator op,              // Predicate operator
+                      const AttrDesc& attrDesc2,      // The right attribute in the join predicate
+                      const int reclen)               // Length of a tuple in the output relation
+{
+  	cout << "Algorithm: Block NL Join" << endl;
+
+	// Block nested-loops join:  R is the outer relation, 
+	//                           S is the inner relation
+	// Algorithm:
+	// for each block of tuples of R that fits into the unpinned part of the buffer pool do
+	// 	for each tuple s in S 
+	//		for each tuple r in the block that matches s do add <r, s> to the result heap file
+	//
+	// S is read once per block instead of once per tuple of R
+	const int blockBytes = bufMgr->numUnpinnedPages() * 0.8 * PAGESIZE;
+
+	vector<AttrDesc> layout(projCnt);
+	JoinLayout(attrDesc1.relName, calTupleLength(attrDesc1), projCnt, attrDescArray, &layout[0]);
+
+	Iterator *join = new NLJoinIter(new ScanIter(attrDesc1.relName), attrDesc1, op,
+					new ScanIter(attrDesc2.relName), attrDesc2, blockBytes);
+	ProjectIter plan(join, projCnt, &layout[0], reclen);
+
+	return Operators::Drain(plan, result);
+}
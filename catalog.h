@@ -3,7 +3,7 @@
 
 #include "datatypes.h"
 #include "heapfile.h"
-// #include "index.h"
+#include "index.h"
 
 // -------------------- These enums are defined in datatypes.h -------------
 // -- These are the data types that minirel understands
@@ -19,9 +19,16 @@
 
 #define RELCATNAME   "relcat"           // name of relation catalog
 #define ATTRCATNAME  "attrcat"          // name of attribute catalog
+#define COMPCATNAME  "compcat"          // name of composite index catalog
+#define SORTCATNAME  "sortcat"          // name of sorted copy catalog
+#define STATCATNAME  "statcat"          // name of statistics catalog
+#define CLUSTCATNAME "clustcat"         // name of clustering catalog
 #define RELNAME      "relname"          // name of indexed field in rel/attrcat
 #define MAXNAME      32                 // length of relName, attrName
 #define MAXSTRINGLEN 255                // max. length of string attribute
+#define STATBUCKETS  16                 // # of buckets of an attribute histogram
+#define HLLBITS      8                  // log2 of the # of HyperLogLog registers
+#define HLLREGS      (1 << HLLBITS)     // # of HyperLogLog registers
 
 
 // schema of relation catalog:
@@ -85,6 +92,13 @@ class RelCatalog : public HeapFileScan {
   // add index to a relation
   const Status addIndex(const string & rName, const string & attrName);
 
+  // add a covering index to a relation. The index entries also carry the
+  // values of the attributes in includeNames
+  const Status addIndex(const string & rName, 
+			const string & attrName,
+			const int includeCnt,
+			const string includeNames[]);
+
   // drop index from a relation
   const Status dropIndex(const string & rName, const string & attrName);
 
@@ -152,6 +166,244 @@ class AttrCatalog : public HeapFileScan {
 };
 
 
+// schema of composite index catalog:
+//   relation name : char(32)           <-- lookup key
+//   key count : integer(4)
+//   attribute names : char(32) x MAXKEYATTRS (in key order)
+typedef struct {
+  char relName[MAXNAME];                // relation name
+  int keyCnt;                           // number of key attributes
+  char attrName[MAXKEYATTRS][MAXNAME];  // names of the key attributes
+} CompIndexDesc;
+
+
+// The class implementing the composite index catalog. A composite index
+// has a key made of several attributes of a relation; the per-attribute
+// indexed flag in the attribute catalog does not describe it, so its
+// definition is kept here. Unlike the relation and attribute catalogs
+// there is no global instance: Utilities::Quit shuts the buffer manager
+// down without knowing about this catalog, so it is opened where needed.
+class CompIndexCatalog : public HeapFileScan {
+ public:
+  // open composite index catalog
+  CompIndexCatalog(Status &status);
+
+  // get all composite indexes defined on a relation
+  const Status getRelInfo(const string & rName,
+			  int &indexCnt,
+			  CompIndexDesc *&indexes);
+
+  // look up the offsets, lengths and types of the key attributes
+  const Status getKeyInfo(const CompIndexDesc & index,
+			  int keyOffset[],
+			  int keyLength[],
+			  Datatype keyType[]);
+
+  // create a composite index on the given attributes of a relation
+  const Status addIndex(const string & rName,
+			const int keyCnt,
+			const string attrNames[]);
+
+  // drop a composite index
+  const Status dropIndex(const string & rName,
+			 const int keyCnt,
+			 const string attrNames[]);
+
+  // open a composite index, rebuilding it first if the relation has been
+  // changed by something that did not maintain it
+  const Status openIndex(const CompIndexDesc & index,
+			 Index *&indexPtr);
+
+  // close composite index catalog
+  ~CompIndexCatalog();
+};
+
+
+// schema of sorted copy catalog:
+//   relation name : char(32)           <-- lookup key
+//   attribute offset : integer(4)
+//   attribute length : integer(4)
+//   attribute type : integer(4)
+//   relation file id : integer(4)
+//   relation version : integer(4)
+//   file name : char(48)
+//   file id : integer(4)
+//   page count : integer(4)
+typedef struct {
+  char relName[MAXNAME];                // relation name
+  int attrOffset;                       // offset of the sort attribute
+  int attrLen;                          // length of the sort attribute
+  int attrType;                         // type of the sort attribute
+  int relFileId;                        // id of the relation file the copy was made from
+  int relVersion;                       // relation version the copy was made from
+  char fileName[MAXNAME + 16];          // heap file holding the sorted copy
+  int fileId;                           // id of that file (the oldest copy has the smallest)
+  int pageCnt;                          // # of data pages of that file
+} SortCopyDesc;
+
+// The sorted copies of a database hold at most SORTCOPYPAGES data
+// pages in all; the oldest copies are dropped to make room.
+#define SORTCOPYPAGES 4096
+
+
+// The class implementing the sorted copy catalog. A sorted copy is
+// the fully merged output of a sort, kept after the sort so that the
+// next sort of the relation on the same attribute can read it instead.
+// A copy is only valid for the relation file and version it was made
+// from (see HeapFile::getFileId and HeapFile::getVersion), so a copy
+// of a relation that was destroyed and created again is never read; a
+// stale copy is dropped when it is looked up, and all stale copies
+// when a copy is added. Like the composite index catalog it is opened
+// where needed.
+class SortCatalog : public HeapFileScan {
+ public:
+  // open sorted copy catalog
+  SortCatalog(Status &status);
+
+  // look up the sorted copy of a relation on an attribute
+  const Status getInfo(const string & rName,
+		       const int attrOffset,
+		       const int attrLen,
+		       const Datatype attrType,
+		       SortCopyDesc &desc);
+
+  // record a sorted copy, dropping an earlier copy on the same
+  // attribute, stale copies and, to stay within SORTCOPYPAGES, the
+  // oldest copies
+  const Status addCopy(const SortCopyDesc & desc);
+
+  // drop a sorted copy: its file is destroyed and the entry removed
+  const Status dropCopy(const SortCopyDesc & desc);
+
+  // close sorted copy catalog
+  ~SortCatalog();
+};
+
+
+// schema of statistics catalog:
+//   relation name : char(32)           <-- lookup key
+//   attribute name : char(32)
+//   attribute offset : integer(4)
+//   attribute length : integer(4)
+//   attribute type : integer(4)
+//   tuple count : integer(4)
+//   page count : integer(4)
+//   smallest value : key prefix(8)
+//   largest value : key prefix(8)
+//   bucket count : integer(4)
+//   bucket upper bounds : key prefix(8) x STATBUCKETS
+//   bucket tuple counts : integer(4) x STATBUCKETS
+//   HyperLogLog registers : byte x HLLREGS
+// Values are kept as normalized key prefixes (see normkey.h), which
+// compare like the values; strings are cut to their first 8 bytes.
+typedef struct {
+  char relName[MAXNAME];                // relation name
+  char attrName[MAXNAME];               // attribute name
+  int attrOffset;                       // attribute offset
+  int attrLen;                          // attribute length
+  int attrType;                         // attribute type
+  int recCnt;                           // # of tuples of the relation
+  int pageCnt;                          // # of pages of the relation
+  unsigned long long minKey;            // smallest value
+  unsigned long long maxKey;            // largest value
+  int bucketCnt;                        // # of histogram buckets in use
+  unsigned long long bucketHi[STATBUCKETS];  // largest value in each bucket
+  int bucketRecs[STATBUCKETS];          // # of tuples in each bucket
+  unsigned char hll[HLLREGS];           // HyperLogLog sketch of the values
+} AttrStatsDesc;
+
+
+// The class implementing the statistics catalog. ANALYZE (see
+// Utilities::Analyze) records the size of a relation and, for each of
+// its attributes, the range of values, an equi-depth histogram and a
+// HyperLogLog sketch from which the # of distinct values is estimated
+// (see stats.h). Inserts keep the statistics up to date; deletes do
+// not, so estimates are scaled to the current size of the relation.
+// Like the composite index catalog it is opened where needed.
+class StatCatalog : public HeapFileScan {
+ public:
+  // open statistics catalog
+  StatCatalog(Status &status);
+
+  // look up the statistics of an attribute
+  const Status getInfo(const string & rName,
+		       const string & attrName,
+		       AttrStatsDesc &desc);
+
+  // record the statistics of an attribute, replacing earlier ones
+  const Status addInfo(const AttrStatsDesc & desc);
+
+  // add a newly inserted tuple to the statistics of its relation
+  const Status addTuple(const string & rName,
+			const char* tuple,
+			const int pageCnt);
+
+  // close statistics catalog
+  ~StatCatalog();
+};
+
+
+// schema of clustering catalog:
+//   relation name : char(32)           <-- lookup key
+//   attribute name : char(32)
+//   attribute offset : integer(4)
+//   attribute length : integer(4)
+//   attribute type : integer(4)
+//   relation file id : integer(4)
+//   relation version : integer(4)
+//   last value : key prefix(8)
+typedef struct {
+  char relName[MAXNAME];                // relation name
+  char attrName[MAXNAME];               // attribute the relation is ordered on
+  int attrOffset;                       // attribute offset
+  int attrLen;                          // attribute length
+  int attrType;                         // attribute type
+  int relFileId;                        // id of the relation file that is in order
+  int relVersion;                       // relation version that is in order
+  unsigned long long lastKey;           // key prefix of the last tuple
+} ClusterDesc;
+
+
+// The class implementing the clustering catalog. CLUSTER (see
+// Utilities::Cluster) rewrites a relation in the order of an attribute
+// and records it here. The order holds for the relation file and
+// version given (see HeapFile::getFileId); an insert of a value that is not smaller than the last one keeps it
+// (the tuple goes at the end of the file), anything else ends it. Like
+// the composite index catalog it is opened where needed.
+class ClusterCatalog : public HeapFileScan {
+ public:
+  // open clustering catalog
+  ClusterCatalog(Status &status);
+
+  // look up the clustering of a relation
+  const Status getInfo(const string & rName,
+		       ClusterDesc &desc);
+
+  // true if the relation, in the file with the given id at the given
+  // version, is in the order of the attribute given by attrOffset,
+  // attrLen and attrType
+  bool isClustered(const string & rName,
+		   const int attrOffset,
+		   const int attrLen,
+		   const Datatype attrType,
+		   const int fileId,
+		   const int version);
+
+  // record the clustering of a relation, replacing an earlier one
+  const Status setInfo(const ClusterDesc & desc);
+
+  // bring the clustering up to date with a newly inserted tuple
+  const Status addTuple(const string & rName,
+			const char* tuple,
+			const int fileId,
+			const int oldVersion,
+			const int newVersion);
+
+  // close clustering catalog
+  ~ClusterCatalog();
+};
+
+
 // extern variables that are instantianted in the main program.
 extern RelCatalog  *relCat;   // Pointer to the relational catalog object
 extern AttrCatalog *attrCat;  // Pointer to the attribute catalog object
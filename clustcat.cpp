@@ -0,0 +1,156 @@
+#include <cstring>
+#include "catalog.h"
+#include "normkey.h"
+
+
+ClusterCatalog::ClusterCatalog(Status &status) :
+	HeapFileScan(CLUSTCATNAME, status)
+{
+}
+
+
+ClusterCatalog::~ClusterCatalog()
+{
+}
+
+
+/*
+ * Looks up the clustering of relation rName.
+ *
+ * Returns:
+ * 	OK on success
+ * 	RECNOTFOUND if the relation has not been clustered
+ * 	an error code otherwise
+ */
+const Status ClusterCatalog::getInfo(const string & rName,
+				     ClusterDesc &desc)
+{
+	Status status;
+	RID rid;
+	Record rec;
+	bool found = false;
+
+	if(rName.empty()) return BADCATPARM;
+
+	status = startScan(0, MAXNAME, STRING, rName.c_str(), EQ);
+	if(status != OK) return status;
+
+	if(scanNext(rid, rec) == OK){
+		memcpy(&desc, rec.data, sizeof(ClusterDesc));
+		found = true;
+	}
+
+	status = endScan();
+	if(status != OK) return status;
+
+	return found ? OK : RECNOTFOUND;
+}
+
+
+/*
+ * Tells whether relation rName, in the file with the given id at the
+ * given version, is in the order of the attribute given by attrOffset,
+ * attrLen and attrType.
+ */
+bool ClusterCatalog::isClustered(const string & rName,
+				 const int attrOffset,
+				 const int attrLen,
+				 const Datatype attrType,
+				 const int fileId,
+				 const int version)
+{
+	ClusterDesc desc;
+
+	if(getInfo(rName, desc) != OK) return false;
+	return desc.relFileId == fileId && desc.relVersion == version
+		&& desc.attrOffset == attrOffset
+		&& desc.attrLen == attrLen && desc.attrType == attrType;
+}
+
+
+/*
+ * Records the clustering of a relation. An earlier clustering of the
+ * relation is dropped first.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise
+ */
+const Status ClusterCatalog::setInfo(const ClusterDesc & desc)
+{
+	Status status;
+	RID rid;
+	Record rec;
+	bool found = false;
+
+	if(!desc.relName[0] || !desc.attrName[0]) return BADCATPARM;
+
+	status = startScan(0, MAXNAME, STRING, desc.relName, EQ);
+	if(status != OK) return status;
+
+	found = (scanNext(rid, rec) == OK);
+
+	status = endScan();
+	if(status != OK) return status;
+
+	if(found){
+		status = deleteRecord(rid);
+		if(status != OK) return status;
+	}
+
+	// inserts into the relation bring its clustering up to date from now on
+	{
+		HeapFile hf(desc.relName, status);
+		if(status != OK) return status;
+		hf.addCatalogFlags(CLUSTERFLAG);
+	}
+
+	Record newRec = {(void *)&desc, sizeof(ClusterDesc)};
+	return insertRecord(newRec, rid);
+}
+
+
+/*
+ * Brings the clustering of relation rName up to date with a tuple just
+ * inserted at the end of it, if it was in order before the insert (file
+ * fileId at oldVersion) and the value of the tuple is not smaller than
+ * the last one. Prefixes of longer strings that are equal may hide a smaller
+ * value, so they end the order.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise
+ */
+const Status ClusterCatalog::addTuple(const string & rName,
+				      const char* tuple,
+				      const int fileId,
+				      const int oldVersion,
+				      const int newVersion)
+{
+	Status status;
+	RID rid;
+	Record rec;
+
+	if(rName.empty()) return BADCATPARM;
+
+	status = startScan(0, MAXNAME, STRING, rName.c_str(), EQ);
+	if(status != OK) return status;
+
+	if((status = scanNext(rid, rec)) == OK){
+		ClusterDesc *desc = (ClusterDesc *)rec.data;
+		const Datatype type = static_cast<Datatype>(desc->attrType);
+		const unsigned long long key = keyPrefix(tuple + desc->attrOffset, type, desc->attrLen);
+		const bool exact = (type != STRING || desc->attrLen <= (int)sizeof(unsigned long long));
+
+		if(desc->relFileId == fileId && desc->relVersion == oldVersion
+		   && (key > desc->lastKey || (exact && key == desc->lastKey))){
+			desc->relVersion = newVersion;
+			desc->lastKey = key;
+			status = markDirty(rid);
+		}
+	}
+	if(status == FILEEOF) status = OK;
+
+	const Status endStatus = endScan();
+	return status != OK ? status : endStatus;
+}
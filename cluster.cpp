@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include "catalog.h"
+#include "utility.h"
+#include "sort.h"
+#include "normkey.h"
+
+using namespace std;
+
+
+// Build the hash index on an attribute again from its relation, with
+// the attributes its entries included before.
+
+static Status rebuildIndex(const AttrDesc & attr)
+{
+  Status status;
+  const Datatype type = static_cast<Datatype>(attr.attrType);
+  int includeCnt;
+  int includeOffset[MAXINCLUDE];
+  int includeLength[MAXINCLUDE];
+
+  {
+    Index index(attr.relName, attr.attrOffset, attr.attrLen, type, NONUNIQUE, status);
+    if (status != OK)
+      return status;
+    index.getIncludes(includeCnt, includeOffset, includeLength);
+  }
+
+  // the index file is named after the relation and the offset (see Index)
+  ostringstream indexName;
+  indexName << attr.relName << '.' << attr.attrOffset << ends;
+  if ((status = db.destroyFile(indexName.str())) != OK)
+    return status;
+
+  Index index(attr.relName, attr.attrOffset, attr.attrLen, type, NONUNIQUE,
+              includeCnt, includeOffset, includeLength, status);
+  return status;
+}
+
+
+// Create a temporary heap file for the sorted tuples of a relation,
+// named after it and not in use.
+
+static Status createTemp(const string & relName, string & name)
+{
+  static int tempFileCnt = 0;
+  Status status;
+
+  do {
+    ostringstream outputString;
+    outputString << relName << ".clu." << ++tempFileCnt;
+    name = outputString.str();
+  } while ((status = db.createFile(name)) == FILEEXISTS);
+
+  if (status != OK)
+    return status;
+  return db.destroyFile(name);
+}
+
+
+// Copy the tuples of heap file fromName into the empty heap file
+// toName, in file order.
+
+static Status copyFile(const string & fromName, const string & toName)
+{
+  Status status;
+  HeapFileScan from(fromName, status);
+  if (status != OK)
+    return status;
+  HeapFile to(toName, status);
+  if (status != OK)
+    return status;
+
+  Record rec;
+  RID rid;
+  while ((status = from.scanNext(rid, rec)) == OK
+         && (status = to.insertRecord(rec, rid)) == OK)
+    ;
+  return status == FILEEOF ? from.endScan() : status;
+}
+
+
+//
+// Rewrites the specified relation in the order of one of its attributes
+// (CLUSTER). The relation is sorted with a SortedFile and its file is
+// created again from the sorted tuples, so the data pages are numbered
+// consecutively and every zone map (rebuilt here) covers a narrow range
+// of the attribute. The indexes of the relation are rebuilt for the new
+// RIDs, and the order is recorded in the clustering catalog, where sorts
+// of the relation on the attribute (e.g. for a merge join) find it.
+//
+// The sorted tuples are written to a temporary file first, and the
+// relation file is only replaced once all of them are there: a failed
+// sort leaves the relation as it was. Should copying them into the new
+// relation file fail, the temporary file is kept.
+//
+// Returns:
+// 	OK on success
+// 	an error code otherwise
+//
+
+Status Utilities::Cluster(const string & relation, const string & attrName)
+{
+  Status status;
+  AttrDesc attr;
+  AttrDesc *attrs;
+  int attrCnt;
+
+  if ((status = attrCat->getInfo(relation, attrName, attr)) != OK)
+    return status;
+  if ((status = attrCat->getRelInfo(attr.relName, attrCnt, attrs)) != OK)
+    return status;
+
+  const Datatype type = static_cast<Datatype>(attr.attrType);
+  int tupleLen = 0;
+  for (int i = 0; i < attrCnt; i++)
+    tupleLen += attrs[i].attrLen;
+
+  // what the new file takes over from the old one
+  int fileId = 0, version = 0, catalogFlags = 0;
+  ZoneMap zones[MAXZONEMAPS];
+  {
+    HeapFile hfile(attr.relName, status);
+    if (status == OK) {
+      fileId = hfile.getFileId();
+      version = hfile.getVersion();
+      catalogFlags = hfile.getCatalogFlags();
+      memcpy(zones, hfile.getZoneMaps(), sizeof(zones));
+    }
+  }
+  if (status != OK) {
+    delete [] attrs;
+    return status;
+  }
+
+  ClusterCatalog clustCat(status);
+  if (status != OK
+      || clustCat.isClustered(attr.relName, attr.attrOffset, attr.attrLen, type,
+                              fileId, version)) {
+    delete [] attrs;
+    return status;
+  }
+
+  // Sort the relation into a temporary file. Then the relation file is
+  // replaced by one holding the tuples in sorted order. The new file has
+  // a new id, so nothing derived from the old one (sorted copies,
+  // adaptive indexes) is taken for it.
+  ClusterDesc desc;
+  memset(&desc, 0, sizeof(ClusterDesc));
+  string tempName;
+  if ((status = createTemp(attr.relName, tempName)) != OK) {
+    delete [] attrs;
+    return status;
+  }
+  {
+    const int pages = bufMgr->numUnpinnedPages() * 0.8;
+    const int maxItems = max(2, (int)(pages * PAGESIZE) / tupleLen);
+    const RunGenerator runGen = SortedFile::sortThreads() > 1 ? PARALLEL_RUNS : REPLACEMENT_SELECTION;
+    SortedFile sorted(attr.relName, attr.attrOffset, attr.attrLen, type, maxItems, status,
+                      0, runGen);
+
+    if (status == OK) {
+      HeapFile tfile(tempName, status);
+      Record rec;
+      RID rid;
+      while (status == OK && (status = sorted.next(rec)) == OK) {
+        status = tfile.insertRecord(rec, rid);
+        desc.lastKey = keyPrefix((char *)rec.data + attr.attrOffset, type, attr.attrLen);
+      }
+      if (status == FILEEOF)
+        status = OK;
+    }
+  }
+  if (status == OK)
+    status = db.destroyFile(attr.relName);
+  if (status != OK) {
+    (void)db.destroyFile(tempName);
+    delete [] attrs;
+    return status;
+  }
+
+  {
+    HeapFile hfile(attr.relName, status);
+    if (status == OK)
+      hfile.addCatalogFlags(catalogFlags);
+  }
+  if (status == OK)
+    status = copyFile(tempName, attr.relName);
+  if (status == OK) {
+    HeapFile hfile(attr.relName, status);
+    desc.relFileId = hfile.getFileId();
+    desc.relVersion = hfile.getVersion();
+  }
+  if (status == OK)
+    status = db.destroyFile(tempName);
+
+  // the zone maps and indexes of the relation
+  for (int i = 0; status == OK && i < MAXZONEMAPS; i++) {
+    if (zones[i].length == 0)
+      continue;
+    HeapFileScan hfile(attr.relName, status);
+    if (status == OK)
+      status = hfile.addZoneMap(zones[i].offset, zones[i].length,
+                                static_cast<Datatype>(zones[i].type));
+  }
+
+  for (int i = 0; status == OK && i < attrCnt; i++) {
+    if (attrs[i].indexed == 1)
+      status = rebuildIndex(attrs[i]);
+  }
+  delete [] attrs;
+  if (status != OK)
+    return status;
+
+  // composite indexes are rebuilt when opened, the relation file being new
+  int indexCnt = 0;
+  CompIndexDesc *indexes;
+  CompIndexCatalog compCat(status);
+  if (status == OK)
+    status = compCat.getRelInfo(attr.relName, indexCnt, indexes);
+  for (int k = 0; status == OK && k < indexCnt; k++) {
+    Index *index;
+    if ((status = compCat.openIndex(indexes[k], index)) == OK)
+      delete index;
+  }
+  if (indexCnt > 0)
+    delete [] indexes;
+  if (status != OK)
+    return status;
+
+  strcpy(desc.relName, attr.relName);
+  strcpy(desc.attrName, attr.attrName);
+  desc.attrOffset = attr.attrOffset;
+  desc.attrLen = attr.attrLen;
+  desc.attrType = attr.attrType;
+  return clustCat.setInfo(desc);
+}
@@ -0,0 +1,248 @@
+#include "catalog.h"
+#include "query.h"
+#include "index.h"
+#include "projection.h"
+#include "exec.h"
+#include "adaptive.h"
+#include <algorithm>
+#include <cstring>
+
+
+/*
+ * Help function:
+ * 	check a record against a conjunction of predicates. The comparison
+ * 	of each predicate follows HeapFileScan::matchRec.
+ *
+ * Return:
+ * 	true if every predicate holds
+ */
+bool Operators::MatchPredicates(const Record & rec,         // the record
+				const int predCnt,          // number of predicates
+				const PredDesc preds[])     // the predicates
+{
+	for(int i = 0; i < predCnt; i ++){
+		const int offset = preds[i].attrDesc.attrOffset;
+		const int length = preds[i].attrDesc.attrLen;
+		const char* attr = (char*)rec.data + offset;
+		const char* fltr = (char*)preds[i].attrValue;
+
+		if(offset + length > rec.length) return false;
+
+		double diff = 0;
+		switch(preds[i].attrDesc.attrType){
+			case INTEGER:
+				int iattr, ifltr;
+				memcpy(&iattr, attr, sizeof(int));
+				memcpy(&ifltr, fltr, sizeof(int));
+				diff = iattr - ifltr;
+				break;
+
+			case DOUBLE:
+				double fattr, ffltr;
+				memcpy(&fattr, attr, sizeof(double));
+				memcpy(&ffltr, fltr, sizeof(double));
+				diff = fattr - ffltr;
+				break;
+
+			case STRING:
+				diff = strncmp(attr, fltr, length);
+				break;
+		}
+
+		bool match = false;
+		switch(preds[i].op){
+			case LT:  match = (diff < 0.0);  break;
+			case LTE: match = (diff <= 0.0); break;
+			case EQ:  match = (diff == 0.0); break;
+			case GTE: match = (diff >= 0.0); break;
+			case GT:  match = (diff > 0.0);  break;
+			case NE:  match = (diff != 0.0); break;
+			default: break;
+		}
+		if(!match) return false;
+	}
+
+	return true;
+}
+
+
+/*
+ * A scan select evaluating a conjunction of predicates. The first
+ * predicate is pushed into the heap file scan (unless the scan builds an
+ * adaptive index on its attribute), the others are checked on the
+ * records it returns.
+ */
+Status Operators::ConjScanSelect(const string& result,       // Name of the output relation
+				 const int projCnt,          // Number of attributes in the projection
+				 const AttrDesc projNames[], // Projection list (as AttrDesc)
+				 const int predCnt,          // Number of predicates
+				 const PredDesc preds[],     // The predicates
+				 const int reclen)           // Length of a tuple in the result relation
+{
+  	cout << "Algorithm: File Scan" << endl;
+
+	// the plan: a scan filtered on the first predicate, the others
+	// checked on its tuples, projected
+	string relName(projNames[0].relName);
+
+	ScanIter *scan = new ScanIter(relName, preds[0].attrDesc, preds[0].op, preds[0].attrValue,
+				      noteAdaptiveUse(preds[0].attrDesc, preds[0].op));
+	Iterator *filter = new FilterIter(scan, predCnt - 1, preds + 1);
+	ProjectIter plan(filter, projCnt, projNames, reclen);
+
+	HeapFileScan::clearScanStats();
+	Status status = Operators::Drain(plan, result);
+
+	// pages the zone maps of the relation let the scan skip
+	const ScanStats &stats = HeapFileScan::scanStats;
+	if(stats.pagesSkipped > 0){
+		cout << "Zone map: skipped " << stats.pagesSkipped << " of "
+		     << stats.pagesRead + stats.pagesSkipped << " pages" << endl;
+	}
+	if(status == OK && scan->indexBuilt()){
+		cout << "Adaptive index: built on " << relName << "." << preds[0].attrDesc.attrName << endl;
+	}
+	return status;
+}
+
+
+/*
+ * Select using a composite index. The key built from the equality
+ * predicates is looked up, the matching records are fetched in page
+ * order and every predicate is checked on them before projecting.
+ */
+Status Operators::CompositeIndexSelect(const string& result,       // Name of the output relation
+				       const int projCnt,          // Number of attributes in the projection
+				       const AttrDesc projNames[], // Projection list (as AttrDesc)
+				       Index &iscan,               // The composite index
+				       const void* key,            // The key to look up
+				       const int predCnt,          // Number of predicates
+				       const PredDesc preds[],     // The predicates
+				       const int reclen)           // Length of a tuple in the result relation
+{
+	Status status;
+	string relName(projNames[0].relName);
+
+	// Phase 1: collect the matching RIDs from the index, sorted by page
+	vector<RID> rids;
+	int pageCnt;
+	status = Operators::CollectRIDs(iscan, key, rids, pageCnt);
+	if(status != OK) return status;
+
+	HeapFileScan hfs(relName, status);
+	if(status != OK) return status;
+
+	if(pageCnt > BITMAP_SCAN_THRESHOLD * hfs.getPageCnt()){
+		return Operators::ConjScanSelect(result, projCnt, projNames, predCnt, preds, reclen);
+	}
+
+  	cout << "Algorithm: Composite Index Select" << endl;
+
+	HeapFile hf(result, status);
+	if(status != OK) {
+		cerr << "Open heap file for storing the results of the index scan failed!" << endl;
+		return status;
+	}
+
+	// Phase 2: fetch the records in page order, check the predicates
+	// and insert the projections into the result heap file
+	Record rec;
+	Projection proj(projCnt, projNames, reclen);
+
+	for(unsigned int r = 0; r < rids.size(); r ++){
+		status = hfs.getRandomRecord(rids[r], rec);
+		if(status != OK) return status;
+
+		if(!Operators::MatchPredicates(rec, predCnt, preds)) continue;
+
+		status = proj.insert(hf, rec.data);
+		if(status != OK) return status;
+	}
+
+
+  	return hfs.endScan();
+}
+
+
+/*
+ * Select by index intersection. Each index is probed for the value of
+ * its predicate and the sorted RID lists are intersected, stopping as
+ * soon as the intersection is empty; the remaining RIDs are fetched in
+ * page order and the residual predicates checked on them.
+ */
+Status Operators::IndexIntersectSelect(const string& result,       // Name of the output relation
+				       const int projCnt,          // Number of attributes in the projection
+				       const AttrDesc projNames[], // Projection list (as AttrDesc)
+				       const int idxCnt,           // Number of predicates answered by indexes
+				       const PredDesc idxPreds[],  // Those predicates
+				       const int predCnt,          // Number of residual predicates
+				       const PredDesc preds[],     // The residual predicates
+				       const int reclen)           // Length of a tuple in the result relation
+{
+	Status status;
+	string relName(projNames[0].relName);
+
+	// Phase 1: intersect the RID lists of the indexes
+	vector<RID> rids, next, both;
+	int pageCnt = 0;
+	for(int i = 0; i < idxCnt; i ++){
+		const AttrDesc &attr = idxPreds[i].attrDesc;
+		Index iscan(relName, attr.attrOffset, attr.attrLen,
+			    static_cast<Datatype>(attr.attrType), 0, status);
+		if(status != OK) return status;
+
+		status = Operators::CollectRIDs(iscan, idxPreds[i].attrValue, i == 0 ? rids : next, pageCnt);
+		if(status != OK) return status;
+
+		if(i > 0){
+			both.clear();
+			set_intersection(rids.begin(), rids.end(), next.begin(), next.end(),
+					 back_inserter(both));
+			rids.swap(both);
+		}
+		if(rids.empty()) break;
+	}
+
+	pageCnt = 0;
+	for(unsigned int i = 0; i < rids.size(); i ++){
+		if(i == 0 || rids[i].pageNo != rids[i - 1].pageNo)
+			pageCnt ++;
+	}
+
+	HeapFileScan hfs(relName, status);
+	if(status != OK) return status;
+
+	if(pageCnt > BITMAP_SCAN_THRESHOLD * hfs.getPageCnt()){
+		vector<PredDesc> all(preds, preds + predCnt);
+		all.insert(all.begin(), idxPreds, idxPreds + idxCnt);
+		return Operators::ConjScanSelect(result, projCnt, projNames, all.size(), &all[0], reclen);
+	}
+
+	if(idxCnt > 1)
+  		cout << "Algorithm: Index Intersection Select" << endl;
+	else
+  		cout << "Algorithm: Bitmap Index Select" << endl;
+
+	HeapFile hf(result, status);
+	if(status != OK) {
+		cerr << "Open heap file for storing the results of the index scan failed!" << endl;
+		return status;
+	}
+
+	// Phase 2: fetch the records in page order, check the residual
+	// predicates and insert the projections into the result heap file
+	Record rec;
+	Projection proj(projCnt, projNames, reclen);
+
+	for(unsigned int r = 0; r < rids.size(); r ++){
+		status = hfs.getRandomRecord(rids[r], rec);
+		if(status != OK) return status;
+
+		if(!Operators::MatchPredicates(rec, predCnt, preds)) continue;
+
+		status = proj.insert(hf, rec.data);
+		if(status != OK) return status;
+	}
+
+  	return hfs.endScan();
+}
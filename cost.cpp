@@ -0,0 +1,194 @@
+#include <cfloat>
+#include <cmath>
+#include "cost.h"
+#include "stats.h"
+#include "query.h"
+
+using namespace std;
+
+
+// The size comes from the relation itself, which is always current;
+// the # of distinct values from the statistics catalog, if the relation
+// has been analyzed and the attribute has not changed since.
+
+Status getJoinStats(const AttrDesc & attrDesc, JOINSTATS & stats)
+{
+  Status status;
+  HeapFile hf(attrDesc.relName, status);
+  if (status != OK) return status;
+
+  stats.recCnt = hf.getRecCnt();
+  stats.pageCnt = hf.getPageCnt();
+  stats.distinct = stats.recCnt;
+
+  AttrStatsDesc desc;
+  if (getAttrStats(attrDesc, desc) == OK)
+    stats.distinct = min(estimateDistinct(desc), stats.recCnt);
+
+  stats.distinct = max(stats.distinct, 1.0);
+  return OK;
+}
+
+
+Status getAttrStats(const AttrDesc & attrDesc, AttrStatsDesc & desc)
+{
+  if (!attrDesc.attrName[0]) return RECNOTFOUND;
+
+  // the statistics catalog is only opened for an analyzed relation
+  Status status;
+  {
+    HeapFile hf(attrDesc.relName, status);
+    if (status != OK) return status;
+    if (!(hf.getCatalogFlags() & STATSFLAG)) return RECNOTFOUND;
+  }
+
+  StatCatalog statCat(status);
+  if (status != OK) return status;
+
+  status = statCat.getInfo(attrDesc.relName, attrDesc.attrName, desc);
+  if (status != OK) return status;
+
+  if (desc.attrOffset != attrDesc.attrOffset || desc.attrLen != attrDesc.attrLen
+      || desc.attrType != attrDesc.attrType)
+    return RECNOTFOUND;
+  return OK;
+}
+
+
+// Equality matches each tuple with the tuples of the other input that
+// share its value, assuming the values of the input with fewer distinct
+// values all occur in the other (containment). The other comparisons
+// keep a third of the pairs, as in System R.
+
+double joinCard(const JOINSTATS & outer, const JOINSTATS & inner,
+		const Operator op)
+{
+  const double pairs = outer.recCnt * inner.recCnt;
+  const double eq = pairs / max(max(outer.distinct, inner.distinct), 1.0);
+
+  switch (op) {
+  case EQ:     return eq;
+  case NE:     return pairs - eq;
+  case NOTSET: return pairs;
+  default:     return pairs / 3;
+  }
+}
+
+
+// The outer tuples are taken in batches of frames pages (see INL in
+// inl.cpp); within a batch the matching inner tuples are fetched in
+// page order, so each inner page is read at most once per batch. Each
+// distinct outer key reads one bucket page of the index (a key seen
+// again finds its bucket in the buffer pool), and the index has no
+// more bucket pages than the inner relation has data pages.
+
+double costINL(const JOINSTATS & outer, const JOINSTATS & inner,
+	       const int frames)
+{
+  const double batches = ceil(outer.pageCnt / max(frames, 1));
+  const double matches = joinCard(outer, inner, EQ);
+  const double buckets = min(outer.distinct, inner.pageCnt);
+
+  return outer.pageCnt + buckets + min(matches, batches * inner.pageCnt);
+}
+
+
+double costHJ(const JOINSTATS & outer, const JOINSTATS & inner)
+{
+  if (inner.pageCnt > HASHJOINMAXPAGES) return DBL_MAX;
+  return outer.pageCnt + inner.pageCnt;
+}
+
+
+// Sorting reads the input and writes runs about twice the size of
+// memory (replacement selection); each merge pass reads and writes
+// everything with a fan-in of frames - 1, and the final merge reads
+// it once more.
+
+static double sortCost(const double pageCnt, const int frames)
+{
+  const int fanIn = max(frames, MINSORTFRAMES) - 1;
+  const double runCnt = ceil(pageCnt / (2.0 * max(frames, MINSORTFRAMES)));
+
+  double passes = 0;
+  for (double runs = runCnt; runs > fanIn; runs = ceil(runs / fanIn))
+    passes++;
+
+  return pageCnt * (3 + 2 * passes);
+}
+
+
+double costSMJ(const JOINSTATS & outer, const JOINSTATS & inner,
+	       const int frames)
+{
+  return sortCost(outer.pageCnt, frames) + sortCost(inner.pageCnt, frames);
+}
+
+
+double costBNL(const JOINSTATS & outer, const JOINSTATS & inner,
+	       const int frames)
+{
+  const double blocks = max(ceil(outer.pageCnt / max(frames, 1)), 1.0);
+  return outer.pageCnt + blocks * inner.pageCnt;
+}
+
+
+double defaultSelectivity(const Operator op)
+{
+  switch (op) {
+  case EQ:     return 0.1;
+  case NE:     return 0.9;
+  case NOTSET: return 1;
+  default:     return 1.0 / 3;
+  }
+}
+
+
+double selectivity(const AttrDesc & attrDesc, const Operator op,
+		   const void* attrValue)
+{
+  AttrStatsDesc desc;
+  if (getAttrStats(attrDesc, desc) == OK)
+    return estimateSelectivity(desc, op, attrValue);
+  return defaultSelectivity(op);
+}
+
+
+// A string comparison may look at every byte of the attribute.
+
+double predicateCost(const AttrDesc & attrDesc)
+{
+  if (attrDesc.attrType == STRING)
+    return 1 + attrDesc.attrLen / 8.0;
+  return 1;
+}
+
+
+double pagesTouched(const double tuples, const double pageCnt)
+{
+  if (pageCnt < 1) return 0;
+  return pageCnt * (1 - pow(1 - 1 / pageCnt, tuples));
+}
+
+
+double costSeqScan(const double pageCnt)
+{
+  return pageCnt;
+}
+
+
+// A page read out of sequence costs 1 / BITMAP_SCAN_THRESHOLD sequential
+// reads: fetching that fraction of the relation costs as much as
+// scanning all of it. A probe reads one bucket page of the index.
+
+double costIndexFetch(const double matches)
+{
+  return 1 + matches / BITMAP_SCAN_THRESHOLD;
+}
+
+
+double costBitmapFetch(const double matches, const double pageCnt)
+{
+  const double sort = SORTCMPCOST * matches * log2(matches + 1);
+  return 1 + pagesTouched(matches, pageCnt) / BITMAP_SCAN_THRESHOLD + sort;
+}
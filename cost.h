@@ -0,0 +1,94 @@
+#ifndef COST_H
+#define COST_H
+
+#include "catalog.h"
+
+// A hash join keeps the tuples of its build input in memory, so only
+// inputs of at most HASHJOINMAXPAGES pages are used as build side.
+#define HASHJOINMAXPAGES 2048
+
+// A merge join sorts its inputs with the frames left unpinned; the
+// cost model assumes at least this many.
+#define MINSORTFRAMES 3
+
+// The CPU cost of a comparison of a sort, in page reads. It keeps index
+// fetches of a handful of tuples from being sorted for nothing.
+#define SORTCMPCOST 0.001
+
+
+// The estimated size of a join input (a relation or an intermediate
+// result) and of its join attribute, for the cost model.
+
+typedef struct {
+  double recCnt;                        // # of tuples
+  double pageCnt;                       // # of pages
+  double distinct;                      // # of distinct values of the join attribute
+} JOINSTATS;
+
+
+// Costs are in page reads and writes, for joins of input outer (whose
+// tuples are read once, in any order) with input inner; the cost of
+// writing the result is the same for all of them and left out. frames
+// is the # of buffer frames the join may use for its inputs.
+
+// The statistics of a relation for a join on the attribute attrDesc.
+// Without catalog statistics every value is taken to be distinct.
+Status getJoinStats(const AttrDesc & attrDesc, JOINSTATS & stats);
+
+// The catalog statistics of an attribute (see StatCatalog); RECNOTFOUND
+// if it has not been analyzed.
+Status getAttrStats(const AttrDesc & attrDesc, AttrStatsDesc & desc);
+
+// The estimated # of tuples of "outer op inner".
+double joinCard(const JOINSTATS & outer, const JOINSTATS & inner,
+		const Operator op);
+
+// Probe the hash index on inner for each outer tuple (INL).
+double costINL(const JOINSTATS & outer, const JOINSTATS & inner,
+	       const int frames);
+
+// Load inner into an in-memory hash table and probe it with outer;
+// infinite if inner is too large for a build side.
+double costHJ(const JOINSTATS & outer, const JOINSTATS & inner);
+
+// Sort both inputs and merge them (SMJ and BMJ).
+double costSMJ(const JOINSTATS & outer, const JOINSTATS & inner,
+	       const int frames);
+
+// Scan inner once for each block of outer tuples that fits in frames.
+double costBNL(const JOINSTATS & outer, const JOINSTATS & inner,
+	       const int frames);
+
+
+// Selections. Costs are in sequential page reads, for fetching the
+// tuples of a relation of pageCnt pages that satisfy a predicate;
+// matches is their (estimated) #.
+
+// The fraction of the tuples that satisfy "attribute op value" when
+// there are no statistics for the attribute (as in System R).
+double defaultSelectivity(const Operator op);
+
+// The fraction of the tuples that satisfy "attribute op attrValue":
+// from the catalog statistics of the attribute, or defaultSelectivity.
+double selectivity(const AttrDesc & attrDesc, const Operator op,
+		   const void* attrValue);
+
+// The CPU cost of checking a predicate on the attribute, relative to a
+// comparison of two integers.
+double predicateCost(const AttrDesc & attrDesc);
+
+// The expected # of distinct pages that tuples fall on (Cardenas).
+double pagesTouched(const double tuples, const double pageCnt);
+
+// Read all of the relation in sequence.
+double costSeqScan(const double pageCnt);
+
+// Probe the hash index and fetch each match in the order of the index
+// entries.
+double costIndexFetch(const double matches);
+
+// Probe the hash index, sort the RIDs and fetch each page with matches
+// once, in file order.
+double costBitmapFetch(const double matches, const double pageCnt);
+
+#endif
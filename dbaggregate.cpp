@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <vector>
+#include "catalog.h"
+#include "query.h"
+#include "utility.h"
+
+// Global variables
+DB db;                 // a handle for the DB class
+Error error;           // a handle for the error class
+
+BufMgr *bufMgr;        // pointer to the buffer manager
+RelCatalog *relCat;    // pointer to the relation catalogs
+AttrCatalog *attrCat;  // pointer to the attribute catalogs
+
+#define CALL(c)    {Status s;if((s=c)!=OK){error.print(s);exit(1);}}
+
+#define RESULTNAME "Tmp_Aggregate"     // the relation the result is printed from
+
+static void usage(const char *prog)
+{
+  cerr << "Usage: " << prog << " dbname relation {attribute | func(attribute) | count(*)} ..." << endl
+       << "  func is one of count, sum, avg, min, max" << endl;
+  exit(1);
+}
+
+
+// Driver program for aggregating a relation: the arguments that are
+// attribute names group the relation, the others are the aggregates
+// computed for each group, e.g.
+//   dbaggregate testdb emp dept count(*) avg(salary) max(age)
+// The result is printed.
+int main(int argc, char *argv[])
+{
+  if (argc < 4)
+    usage(argv[0]);
+
+  if (chdir(argv[1]) < 0) {
+    perror("chdir");
+    exit(1);
+  }
+
+  // create buffer manager
+  bufMgr = new BufMgr(32);
+
+  // open relation and attribute catalogs
+  Status status;
+
+  relCat = new RelCatalog(status);
+  if (status == OK)
+    attrCat = new AttrCatalog(status);
+  if (status != OK) {
+    error.print(status);
+    exit(1);
+  }
+
+  static const char *funcNames[] = { "count", "sum", "avg", "min", "max" };
+  const char *relation = argv[2];
+
+  // the grouping attributes and the aggregates, and the attributes of
+  // the result relation (grouping attributes first)
+  vector<attrInfo> groups, resultAttrs;
+  vector<aggInfo> aggs;
+  for(int i = 3; i < argc; i++) {
+    attrInfo attr;
+    memset(&attr, 0, sizeof(attrInfo));
+    strncpy(attr.relName, relation, MAXNAME - 1);
+
+    const char *open = strchr(argv[i], '(');
+    if (!open) {
+      strncpy(attr.attrName, argv[i], MAXNAME - 1);
+      groups.push_back(attr);
+      continue;
+    }
+
+    const char *close = strchr(open, ')');
+    if (!close)
+      usage(argv[0]);
+
+    aggInfo agg;
+    int f = 0;
+    while (f < 5 && (strlen(funcNames[f]) != (size_t)(open - argv[i])
+                     || strncasecmp(argv[i], funcNames[f], open - argv[i])))
+      f++;
+    if (f == 5)
+      usage(argv[0]);
+    agg.func = (AggFunc)f;
+
+    const string name(open + 1, close - open - 1);
+    if (name != "*")
+      strncpy(attr.attrName, name.c_str(), MAXNAME - 1);
+    else if (agg.func != AGG_COUNT)
+      usage(argv[0]);
+    agg.attr = attr;
+    aggs.push_back(agg);
+  }
+
+  for(unsigned int i = 0; i < groups.size(); i++) {
+    AttrDesc desc;
+    CALL(attrCat->getInfo(relation, groups[i].attrName, desc));
+    groups[i].attrType = desc.attrType;
+    groups[i].attrLen = desc.attrLen;
+    resultAttrs.push_back(groups[i]);
+  }
+
+  for(unsigned int i = 0; i < aggs.size(); i++) {
+    attrInfo attr;
+    memset(&attr, 0, sizeof(attrInfo));
+    strcpy(attr.relName, RESULTNAME);
+    const string name = string(funcNames[aggs[i].func]) + "("
+      + (aggs[i].attr.attrName[0] ? aggs[i].attr.attrName : "*") + ")";
+    strncpy(attr.attrName, name.c_str(), MAXNAME - 1);
+
+    switch (aggs[i].func) {
+    case AGG_COUNT:
+      attr.attrType = INTEGER;
+      attr.attrLen = sizeof(int);
+      break;
+    case AGG_SUM:
+    case AGG_AVG:
+      attr.attrType = DOUBLE;
+      attr.attrLen = sizeof(double);
+      break;
+    default:
+      AttrDesc desc;
+      CALL(attrCat->getInfo(relation, aggs[i].attr.attrName, desc));
+      attr.attrType = desc.attrType;
+      attr.attrLen = desc.attrLen;
+      break;
+    }
+    resultAttrs.push_back(attr);
+  }
+
+  for(unsigned int i = 0; i < resultAttrs.size(); i++)
+    strcpy(resultAttrs[i].relName, RESULTNAME);
+
+  CALL(relCat->createRel(RESULTNAME, resultAttrs.size(), &resultAttrs[0]));
+  status = Operators::Aggregate(RESULTNAME, groups.size(), groups.empty() ? NULL : &groups[0],
+                                aggs.size(), aggs.empty() ? NULL : &aggs[0]);
+  if (status == OK)
+    status = Utilities::Print(RESULTNAME);
+  if (status != OK)
+    error.print(status);
+  CALL(relCat->destroyRel(RESULTNAME));
+
+  delete relCat;
+  delete attrCat;
+
+  delete bufMgr;
+
+  return status == OK ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "catalog.h"
+#include "utility.h"
+#include "stats.h"
+
+// Global variables
+DB db;                 // a handle for the DB class
+Error error;           // a handle for the error class
+
+BufMgr *bufMgr;        // pointer to the buffer manager
+RelCatalog *relCat;    // pointer to the relation catalogs
+AttrCatalog *attrCat;  // pointer to the attribute catalogs
+
+#define CALL(c)    {Status s;if((s=c)!=OK){error.print(s);exit(1);}}
+
+
+// Driver program for collecting the statistics of relations (ANALYZE);
+// with no relations given, all relations of the database are analyzed.
+// An argument relation.attribute builds a zone map on the attribute
+// instead.
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    cerr << "Usage: " << argv[0] << " dbname [relation | relation.attribute ...]" << endl;
+    return 1;
+  }
+
+  if (chdir(argv[1]) < 0) {
+    perror("chdir");
+    exit(1);
+  }
+
+  // create buffer manager
+  bufMgr = new BufMgr(32);
+
+  // open relation and attribute catalogs
+  Status status;
+
+  relCat = new RelCatalog(status);
+  if (status == OK)
+    attrCat = new AttrCatalog(status);
+  if (status != OK) {
+    error.print(status);
+    exit(1);
+  }
+
+  // the relations to analyze: those given, or all but the catalogs
+  vector<string> relations;
+  bool zoneMaps = false;
+  for(int i = 2; i < argc; i++) {
+    const char *dot = strchr(argv[i], '.');
+    if (dot) {
+      const string relation(argv[i], dot - argv[i]);
+      CALL(Utilities::BuildZoneMap(relation, dot + 1));
+      cout << "Zone map built on " << argv[i] << endl;
+      zoneMaps = true;
+    }
+    else
+      relations.push_back(argv[i]);
+  }
+
+  if (relations.empty() && !zoneMaps) {
+    RID rid;
+    Record rec;
+    CALL(relCat->startScan(0, 0, STRING, NULL, EQ));
+    while(relCat->scanNext(rid, rec) == OK) {
+      const RelDesc *rd = (const RelDesc *)rec.data;
+      if (strcmp(rd->relName, RELCATNAME) && strcmp(rd->relName, ATTRCATNAME))
+        relations.push_back(rd->relName);
+    }
+    CALL(relCat->endScan());
+  }
+
+  for(unsigned int r = 0; r < relations.size(); r++) {
+    CALL(Utilities::Analyze(relations[r]));
+
+    AttrDesc *attrs;
+    int attrCnt;
+    CALL(attrCat->getRelInfo(relations[r], attrCnt, attrs));
+
+    StatCatalog statCat(status);
+    CALL(status);
+    for(int i = 0; i < attrCnt; i++) {
+      AttrStatsDesc desc;
+      CALL(statCat.getInfo(attrs[i].relName, attrs[i].attrName, desc));
+      if (i == 0)
+        cout << relations[r] << ": " << desc.recCnt << " tuples, "
+             << desc.pageCnt << " pages" << endl;
+      cout << "  " << desc.attrName << ": ~" << (int)(estimateDistinct(desc) + 0.5)
+           << " distinct values, " << desc.bucketCnt << " histogram buckets" << endl;
+    }
+    delete [] attrs;
+  }
+
+  delete relCat;
+  delete attrCat;
+
+  delete bufMgr;
+
+  return 0;
+}
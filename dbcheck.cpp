@@ -0,0 +1,773 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include "catalog.h"
+#include "query.h"
+#include "sort.h"
+#include "adaptive.h"
+#include "utility.h"
+
+// Global variables
+DB db;                 // a handle for the DB class
+Error error;           // a handle for the error class
+
+BufMgr *bufMgr;        // pointer to the buffer manager
+RelCatalog *relCat;    // pointer to the relation catalogs
+AttrCatalog *attrCat;  // pointer to the attribute catalogs
+
+#define CALL(c)    {Status s;if((s=c)!=OK){error.print(s);exit(1);}}
+
+#define RELR       "Check_R"           // v, id, a, b, s (see RTUPLE)
+#define RELS       "Check_S"           // a, w
+#define RELT       "Check_T"           // w, x
+#define RELX       "Check_X"           // d, i
+#define RELY       "Check_Y"           // d, j
+#define RELZ       "Check_Z"           // j, k
+#define RELE       "Check_E"           // empty, with the attributes of RELR
+#define RELQ       "Check_Q"           // destroyed and created again
+#define RESULTNAME "Check_Result"      // the relation the operators fill
+
+#define RTUPLES    3000                // # of tuples of RELR
+#define STRLEN     16                  // length of RELR.s
+#define QTUPLES    1000                // # of tuples of RELQ(k, m)
+#define DOUBLEERROR 1e-07              // DOUBLEs this close are equal (see matchRec)
+
+// A tuple of RELR. The attributes are laid out as in the relation (the
+// double first, so no padding comes before the end); RLEN is the length
+// of the tuple in the relation.
+typedef struct {
+  double v;                             // integral, so sums are exact
+  int id;                               // unique, in no particular order
+  int a;                                // 0 .. 3
+  int b;                                // 0 .. 999
+  char s[STRLEN];
+} RTUPLE;
+#define RLEN (sizeof(double) + 3 * sizeof(int) + STRLEN)
+
+static int failures = 0;
+
+static void check(const string & name, const bool ok)
+{
+  cout << "CHECK " << name << ": " << (ok ? "ok" : "FAILED") << endl;
+  if (!ok)
+    failures++;
+}
+
+
+// Create relation rel with attrCnt attributes of the given names and
+// types; strings are STRLEN long.
+static void createRel(const string & rel, const int attrCnt,
+                      const char *names[], const Datatype types[])
+{
+  vector<attrInfo> attrs(attrCnt);
+  for(int i = 0; i < attrCnt; i++) {
+    memset(&attrs[i], 0, sizeof(attrInfo));
+    strcpy(attrs[i].relName, rel.c_str());
+    strcpy(attrs[i].attrName, names[i]);
+    attrs[i].attrType = types[i];
+    attrs[i].attrLen = types[i] == INTEGER ? sizeof(int)
+      : types[i] == DOUBLE ? sizeof(double) : STRLEN;
+  }
+  CALL(relCat->createRel(rel, attrCnt, &attrs[0]));
+}
+
+static attrInfo attr(const string & rel, const char *name)
+{
+  attrInfo info;
+  memset(&info, 0, sizeof(attrInfo));
+  strcpy(info.relName, rel.c_str());
+  strcpy(info.attrName, name);
+  return info;
+}
+
+static void insert(const string & rel, const void *tuple, const int length)
+{
+  Status status;
+  HeapFile hf(rel, status);
+  CALL(status);
+  RID rid;
+  Record rec = {(void *)tuple, length};
+  CALL(hf.insertRecord(rec, rid));
+}
+
+
+// The tuples of a relation as read by a plain scan, in file order
+static vector<string> scan(const string & rel)
+{
+  vector<string> tuples;
+  Status status;
+  HeapFileScan hfs(rel, status);
+  CALL(status);
+  RID rid;
+  Record rec;
+  while ((status = hfs.scanNext(rid, rec)) == OK)
+    tuples.push_back(string((char *)rec.data, rec.length));
+  if (status != FILEEOF)
+    CALL(status);
+  return tuples;
+}
+
+static RTUPLE rtuple(const string & tuple)
+{
+  RTUPLE t;
+  memcpy(&t, tuple.data(), RLEN);
+  return t;
+}
+
+static bool sameTuples(vector<string> a, vector<string> b)
+{
+  sort(a.begin(), a.end());
+  sort(b.begin(), b.end());
+  return a == b;
+}
+
+
+// The relation the operators are checked on. The values come from a
+// fixed linear congruential generator, so every run sees the same data.
+static void createRelations()
+{
+  const char *rNames[] = {"v", "id", "a", "b", "s"};
+  const Datatype rTypes[] = {DOUBLE, INTEGER, INTEGER, INTEGER, STRING};
+  createRel(RELR, 5, rNames, rTypes);
+
+  unsigned int seed = 12345;
+  for(int i = 0; i < RTUPLES; i++) {
+    RTUPLE t;
+    memset(&t, 0, sizeof(RTUPLE));
+    seed = seed * 1103515245 + 12345;
+    t.id = (i * 7919) % RTUPLES;
+    t.a = (seed >> 16) % 4;
+    t.b = (seed >> 8) % 1000;
+    t.v = (int)(seed % 100) - 50;
+    sprintf(t.s, "s%05u", (seed >> 4) % 5000);
+    insert(RELR, &t, RLEN);
+  }
+}
+
+
+// Aggregate: GROUP BY a (and b) with COUNT(*), SUM(v), AVG(v), MIN(s)
+// and MAX(b), against the groups of a scan
+static void checkAggregate(const string & name, const int groupCnt)
+{
+  typedef struct {
+    int cnt;
+    double sum;
+    string min;
+    int max;
+  } GROUP;
+
+  map<pair<int, int>, GROUP> groups;
+  vector<string> tuples = scan(RELR);
+  for(unsigned int i = 0; i < tuples.size(); i++) {
+    const RTUPLE t = rtuple(tuples[i]);
+    const string s(t.s, STRLEN);
+    const pair<int, int> key(t.a, groupCnt > 1 ? t.b : 0);
+    if (!groups.count(key)) {
+      GROUP g = {0, 0, s, t.b};
+      groups[key] = g;
+    }
+    GROUP & g = groups[key];
+    g.cnt++;
+    g.sum += t.v;
+    g.min = min(g.min, s);
+    g.max = max(g.max, t.b);
+  }
+
+  vector<string> expected;
+  for(map<pair<int, int>, GROUP>::iterator it = groups.begin(); it != groups.end(); ++it) {
+    string row((char *)&it->first.first, sizeof(int));
+    if (groupCnt > 1)
+      row.append((char *)&it->first.second, sizeof(int));
+    const double avg = it->second.sum / it->second.cnt;
+    row.append((char *)&it->second.cnt, sizeof(int));
+    row.append((char *)&it->second.sum, sizeof(double));
+    row.append((char *)&avg, sizeof(double));
+    row.append(it->second.min);
+    row.append((char *)&it->second.max, sizeof(int));
+    expected.push_back(row);
+  }
+
+  const char *names[] = {"a", "b", "cnt", "sum", "avg", "mins", "maxb"};
+  const Datatype types[] = {INTEGER, INTEGER, INTEGER, DOUBLE, DOUBLE, STRING, INTEGER};
+  if (groupCnt > 1)
+    createRel(RESULTNAME, 7, names, types);
+  else {
+    const char *names1[] = {"a", "cnt", "sum", "avg", "mins", "maxb"};
+    createRel(RESULTNAME, 6, names1, types + 1);
+  }
+
+  const attrInfo groupAttrs[] = {attr(RELR, "a"), attr(RELR, "b")};
+  const AggFunc funcs[] = {AGG_COUNT, AGG_SUM, AGG_AVG, AGG_MIN, AGG_MAX};
+  const char *aggNames[] = {"", "v", "v", "s", "b"};
+  aggInfo aggs[5];
+  for(int i = 0; i < 5; i++) {
+    aggs[i].func = funcs[i];
+    aggs[i].attr = attr(RELR, aggNames[i]);
+  }
+
+  const Status status = Operators::Aggregate(RESULTNAME, groupCnt, groupAttrs, 5, aggs);
+  check(name, status == OK && sameTuples(scan(RESULTNAME), expected));
+  CALL(relCat->destroyRel(RESULTNAME));
+}
+
+
+// Aggregate: COUNT(*) of the whole relation
+static void checkCount()
+{
+  const char *names[] = {"cnt"};
+  const Datatype types[] = {INTEGER};
+  createRel(RESULTNAME, 1, names, types);
+
+  aggInfo count;
+  count.func = AGG_COUNT;
+  count.attr = attr(RELR, "");
+  const int recCnt = scan(RELR).size();
+
+  const Status status = Operators::Aggregate(RESULTNAME, 0, NULL, 1, &count);
+  vector<string> rows = scan(RESULTNAME);
+  check("aggregate COUNT(*)", status == OK && rows.size() == 1
+        && !memcmp(rows[0].data(), &recCnt, sizeof(int)));
+  CALL(relCat->destroyRel(RESULTNAME));
+}
+
+
+// Aggregate of an empty relation without grouping: one tuple of zeros
+// if all the aggregates are COUNTs, none otherwise (see Aggregate)
+static void checkEmptyAggregate()
+{
+  const char *rNames[] = {"v", "id", "a", "b", "s"};
+  const Datatype rTypes[] = {DOUBLE, INTEGER, INTEGER, INTEGER, STRING};
+  createRel(RELE, 5, rNames, rTypes);
+
+  const char *names[] = {"cnt", "cntb", "mins"};
+  const Datatype types[] = {INTEGER, INTEGER, STRING};
+  aggInfo aggs[3];
+  aggs[0].func = AGG_COUNT;
+  aggs[0].attr = attr(RELE, "");
+  aggs[1].func = AGG_COUNT;
+  aggs[1].attr = attr(RELE, "b");
+  aggs[2].func = AGG_MIN;
+  aggs[2].attr = attr(RELE, "s");
+
+  createRel(RESULTNAME, 2, names, types);
+  Status status = Operators::Aggregate(RESULTNAME, 0, NULL, 2, aggs);
+  vector<string> rows = scan(RESULTNAME);
+  const int zeros[2] = {0, 0};
+  check("aggregate COUNTs of an empty relation", status == OK && rows.size() == 1
+        && !memcmp(rows[0].data(), zeros, sizeof(zeros)));
+  CALL(relCat->destroyRel(RESULTNAME));
+
+  createRel(RESULTNAME, 3, names, types);
+  status = Operators::Aggregate(RESULTNAME, 0, NULL, 3, aggs);
+  check("aggregate MIN of an empty relation", status == OK && scan(RESULTNAME).empty());
+  CALL(relCat->destroyRel(RESULTNAME));
+
+  CALL(relCat->destroyRel(RELE));
+}
+
+
+// OrderBy: the tuples in the order of id (unique), the first limit of
+// them if limit > 0
+static void checkOrderBy(const string & name, const int limit)
+{
+  vector<pair<int, string> > keyed;
+  vector<string> tuples = scan(RELR);
+  for(unsigned int i = 0; i < tuples.size(); i++)
+    keyed.push_back(make_pair(rtuple(tuples[i]).id, tuples[i]));
+  sort(keyed.begin(), keyed.end());
+
+  vector<string> expected;
+  for(unsigned int i = 0; i < keyed.size() && (limit == 0 || (int)i < limit); i++)
+    expected.push_back(keyed[i].second);
+
+  const char *names[] = {"v", "id", "a", "b", "s"};
+  const Datatype types[] = {DOUBLE, INTEGER, INTEGER, INTEGER, STRING};
+  createRel(RESULTNAME, 5, names, types);
+
+  attrInfo proj[5];
+  for(int i = 0; i < 5; i++)
+    proj[i] = attr(RELR, names[i]);
+  const attrInfo sortAttr = attr(RELR, "id");
+
+  const Status status = Operators::OrderBy(RESULTNAME, 5, proj, &sortAttr, limit);
+  check(name, status == OK && scan(RESULTNAME) == expected);
+  CALL(relCat->destroyRel(RESULTNAME));
+}
+
+
+// Cluster: the same tuples, in the order of the attribute, which sorts
+// then read as they are
+static void checkCluster(const char *attrName)
+{
+  vector<string> before = scan(RELR);
+  const Status status = Utilities::Cluster(RELR, attrName);
+  vector<string> after = scan(RELR);
+
+  AttrDesc desc;
+  CALL(attrCat->getInfo(RELR, attrName, desc));
+
+  // the attribute is an integer (a or b)
+  bool ordered = true;
+  for(unsigned int i = 1; i < after.size(); i++) {
+    int v1, v2;
+    memcpy(&v1, after[i - 1].data() + desc.attrOffset, sizeof(int));
+    memcpy(&v2, after[i].data() + desc.attrOffset, sizeof(int));
+    ordered = ordered && v1 <= v2;
+  }
+
+  Status sortStatus;
+  SortedFile sorted(RELR, desc.attrOffset, desc.attrLen, (Datatype)desc.attrType,
+                    RTUPLES, sortStatus, 0, QUICKSORT_RUNS, true);
+  check(string("cluster on ") + attrName,
+        status == OK && sameTuples(before, after) && ordered
+        && sortStatus == OK && sorted.getStats().clustered);
+}
+
+
+// Select on id = valueId AND b = valueB, which the hash indexes on id
+// and b answer by intersecting their RIDs, against a filtered scan
+static void checkIndexSelect(const int valueId, const int valueB)
+{
+  vector<string> expected;
+  vector<string> tuples = scan(RELR);
+  for(unsigned int i = 0; i < tuples.size(); i++) {
+    const RTUPLE t = rtuple(tuples[i]);
+    if (t.id == valueId && t.b == valueB)
+      expected.push_back(tuples[i]);
+  }
+
+  const char *names[] = {"v", "id", "a", "b", "s"};
+  const Datatype types[] = {DOUBLE, INTEGER, INTEGER, INTEGER, STRING};
+  createRel(RESULTNAME, 5, names, types);
+
+  attrInfo proj[5];
+  for(int i = 0; i < 5; i++)
+    proj[i] = attr(RELR, names[i]);
+  predInfo preds[2];
+  preds[0].attr = attr(RELR, "id");
+  preds[0].op = EQ;
+  preds[0].attrValue = &valueId;
+  preds[1].attr = attr(RELR, "b");
+  preds[1].op = EQ;
+  preds[1].attrValue = &valueB;
+  for(int i = 0; i < 2; i++) {
+    preds[i].attr.attrType = INTEGER;
+    preds[i].attr.attrLen = sizeof(int);
+  }
+
+  const Status status = Operators::Select(RESULTNAME, 5, proj, 2, preds);
+  check("index intersection select", status == OK && !expected.empty()
+        && sameTuples(scan(RESULTNAME), expected));
+  CALL(relCat->destroyRel(RESULTNAME));
+}
+
+
+// Join of R, S and T on R.a = S.a and S.w = T.w, against nested loops
+// over scans
+static void checkMultiJoin()
+{
+  const char *sNames[] = {"a", "w"};
+  const Datatype intTypes[] = {INTEGER, INTEGER};
+  createRel(RELS, 2, sNames, intTypes);
+  for(int i = 0; i < 8; i++) {
+    int t[2] = {i % 5, i * 3 % 7};
+    insert(RELS, t, sizeof(t));
+  }
+
+  const char *tNames[] = {"w", "x"};
+  createRel(RELT, 2, tNames, intTypes);
+  for(int i = 0; i < 20; i++) {
+    int t[2] = {i % 9, i};
+    insert(RELT, t, sizeof(t));
+  }
+
+  vector<string> r = scan(RELR), s = scan(RELS), t = scan(RELT);
+  vector<string> expected;
+  for(unsigned int i = 0; i < r.size(); i++) {
+    const RTUPLE rt = rtuple(r[i]);
+    for(unsigned int j = 0; j < s.size(); j++) {
+      int st[2];
+      memcpy(st, s[j].data(), sizeof(st));
+      if (st[0] != rt.a)
+        continue;
+      for(unsigned int k = 0; k < t.size(); k++) {
+        int tt[2];
+        memcpy(tt, t[k].data(), sizeof(tt));
+        if (tt[0] != st[1])
+          continue;
+        int row[3] = {rt.id, st[1], tt[1]};
+        expected.push_back(string((char *)row, sizeof(row)));
+      }
+    }
+  }
+
+  const char *names[] = {"id", "w", "x"};
+  const Datatype types[] = {INTEGER, INTEGER, INTEGER};
+  createRel(RESULTNAME, 3, names, types);
+
+  const attrInfo proj[] = {attr(RELR, "id"), attr(RELS, "w"), attr(RELT, "x")};
+  const string rels[] = {RELR, RELS, RELT};
+  joinInfo joins[2];
+  joins[0].attr1 = attr(RELR, "a");
+  joins[0].op = EQ;
+  joins[0].attr2 = attr(RELS, "a");
+  joins[1].attr1 = attr(RELS, "w");
+  joins[1].op = EQ;
+  joins[1].attr2 = attr(RELT, "w");
+
+  const Status status = Operators::Join(RESULTNAME, 3, proj, 3, rels, 2, joins);
+  check("multi-way join", status == OK && !expected.empty()
+        && sameTuples(scan(RESULTNAME), expected));
+  CALL(relCat->destroyRel(RESULTNAME));
+
+  CALL(relCat->destroyRel(RELS));
+  CALL(relCat->destroyRel(RELT));
+}
+
+
+// Join of X, Y and Z on X.d = Y.d (DOUBLEs, some of which differ in
+// their last bits) and Y.j = Z.j. The DOUBLEs must match as they do in
+// the join of two relations, with a tolerance, whichever step of the
+// plan joins them. With zCnt small Z starts the plan and the DOUBLE
+// predicate is joined last; with zCnt large it is joined first.
+static void checkDoubleJoin(const string & name, const int zCnt)
+{
+  const char *xNames[] = {"d", "i"};
+  const char *yNames[] = {"d", "j"};
+  const char *zNames[] = {"j", "k"};
+  const Datatype doubleTypes[] = {DOUBLE, INTEGER};
+  const Datatype intTypes[] = {INTEGER, INTEGER};
+  createRel(RELX, 2, xNames, doubleTypes);
+  createRel(RELY, 2, yNames, doubleTypes);
+  createRel(RELZ, 2, zNames, intTypes);
+
+  typedef struct {
+    double d;
+    int n;
+  } DTUPLE;
+  const int DLEN = sizeof(double) + sizeof(int);
+  for(int i = 0; i < 12; i++) {
+    DTUPLE x = {i / 2 + (i % 2) * 1e-9, i};
+    insert(RELX, &x, DLEN);
+  }
+  for(int i = 0; i < 6; i++) {
+    DTUPLE y = {i + 3e-9, i % 3};
+    insert(RELY, &y, DLEN);
+  }
+  for(int i = 0; i < zCnt; i++) {
+    int z[2] = {i % 3, i};
+    insert(RELZ, z, sizeof(z));
+  }
+
+  vector<string> x = scan(RELX), y = scan(RELY), z = scan(RELZ);
+  vector<string> expected;
+  for(unsigned int i = 0; i < x.size(); i++) {
+    DTUPLE xt;
+    memcpy(&xt, x[i].data(), DLEN);
+    for(unsigned int j = 0; j < y.size(); j++) {
+      DTUPLE yt;
+      memcpy(&yt, y[j].data(), DLEN);
+      if (xt.d - yt.d >= DOUBLEERROR || yt.d - xt.d >= DOUBLEERROR)
+        continue;
+      for(unsigned int k = 0; k < z.size(); k++) {
+        int zt[2];
+        memcpy(zt, z[k].data(), sizeof(zt));
+        if (zt[0] != yt.n)
+          continue;
+        int row[3] = {xt.n, yt.n, zt[1]};
+        expected.push_back(string((char *)row, sizeof(row)));
+      }
+    }
+  }
+
+  const char *names[] = {"i", "j", "k"};
+  const Datatype types[] = {INTEGER, INTEGER, INTEGER};
+  createRel(RESULTNAME, 3, names, types);
+
+  const attrInfo proj[] = {attr(RELX, "i"), attr(RELY, "j"), attr(RELZ, "k")};
+  const string rels[] = {RELX, RELY, RELZ};
+  joinInfo joins[2];
+  joins[0].attr1 = attr(RELX, "d");
+  joins[0].op = EQ;
+  joins[0].attr2 = attr(RELY, "d");
+  joins[1].attr1 = attr(RELY, "j");
+  joins[1].op = EQ;
+  joins[1].attr2 = attr(RELZ, "j");
+
+  const Status status = Operators::Join(RESULTNAME, 3, proj, 3, rels, 2, joins);
+  check(name, status == OK && expected.size() == 12 * (unsigned)zCnt / 3
+        && sameTuples(scan(RESULTNAME), expected));
+  CALL(relCat->destroyRel(RESULTNAME));
+
+  CALL(relCat->destroyRel(RELX));
+  CALL(relCat->destroyRel(RELY));
+  CALL(relCat->destroyRel(RELZ));
+}
+
+
+// RELQ(k) with the given values, in this order
+static void createQ(const int keys[], const int keyCnt)
+{
+  const char *names[] = {"k"};
+  const Datatype types[] = {INTEGER};
+  createRel(RELQ, 1, names, types);
+  for(int i = 0; i < keyCnt; i++)
+    insert(RELQ, &keys[i], sizeof(int));
+}
+
+// The values of RELQ.k as a SortedFile that may use a sorted copy or
+// the clustering gives them
+static vector<int> sortQ(bool & clustered)
+{
+  vector<int> keys;
+  Status status;
+  SortedFile sorted(RELQ, 0, sizeof(int), INTEGER, 100, status, 0, QUICKSORT_RUNS, true);
+  CALL(status);
+  Record rec;
+  while (sorted.next(rec) == OK)
+    keys.push_back(*(int *)rec.data);
+  clustered = sorted.getStats().clustered;
+  return keys;
+}
+
+
+// A sorted copy of a relation must not be taken for a relation of the
+// same name that is created after the first one is destroyed, even
+// where the new relation has been changed as often as the old one.
+static void checkRecreatedSortedCopy()
+{
+  bool clustered;
+  const int oldKeys[] = {30, 20, 10}, newKeys[] = {9, 8, 7};
+
+  createQ(oldKeys, 3);
+  sortQ(clustered);
+  sortQ(clustered);
+  CALL(relCat->destroyRel(RELQ));
+  createQ(newKeys, 3);
+  vector<int> keys = sortQ(clustered);
+  check("recreated relation, sorted copy",
+        keys.size() == 3 && keys[0] == 7 && keys[1] == 8 && keys[2] == 9);
+  CALL(relCat->destroyRel(RELQ));
+}
+
+
+// The clustering of a relation must not be taken for a relation of the
+// same name that is created after the first one is destroyed.
+static void checkRecreatedClustering()
+{
+  bool clustered;
+  const int oldKeys[] = {3, 1, 2}, newKeys[] = {6, 4, 5};
+
+  createQ(oldKeys, 3);
+  CALL(Utilities::Cluster(RELQ, "k"));
+  CALL(relCat->destroyRel(RELQ));
+  createQ(newKeys, 3);
+  vector<int> keys = sortQ(clustered);
+  check("recreated relation, clustering", !clustered
+        && keys.size() == 3 && keys[0] == 4 && keys[1] == 5 && keys[2] == 6);
+  CALL(relCat->destroyRel(RELQ));
+}
+
+
+// Select on k < value into the result, returning the values of k
+static vector<int> selectQ(const int value)
+{
+  const char *names[] = {"k"};
+  const Datatype types[] = {INTEGER};
+  createRel(RESULTNAME, 1, names, types);
+  attrInfo proj = attr(RELQ, "k");
+  attrInfo k = attr(RELQ, "k");
+  k.attrType = INTEGER;
+  k.attrLen = sizeof(int);
+  CALL(Operators::Select(RESULTNAME, 1, &proj, &k, LT, &value));
+
+  vector<int> keys;
+  vector<string> tuples = scan(RESULTNAME);
+  for(unsigned int i = 0; i < tuples.size(); i++)
+    keys.push_back(*(int *)tuples[i].data());
+  sort(keys.begin(), keys.end());
+  CALL(relCat->destroyRel(RESULTNAME));
+  return keys;
+}
+
+
+// The adaptive index of a relation must not be taken for a relation of
+// the same name that is created after the first one is destroyed, even
+// where the new relation has been changed as often as the old one.
+static void checkRecreatedAdaptiveIndex()
+{
+  vector<int> values(100);
+  for(int i = 0; i < 100; i++)
+    values[i] = i;
+  createQ(&values[0], 100);
+  for(int i = 0; i <= ADAPTIVEUSES; i++)
+    selectQ(5);
+  CALL(relCat->destroyRel(RELQ));
+
+  for(int i = 0; i < 100; i++)
+    values[i] = i + 3;
+  createQ(&values[0], 100);
+  vector<int> keys = selectQ(5);
+  check("recreated relation, adaptive index",
+        keys.size() == 2 && keys[0] == 3 && keys[1] == 4);
+  CALL(relCat->destroyRel(RELQ));
+}
+
+
+// Select on k = value[0] AND m = value[1] of RELQ(k, m) into the
+// result, returning the number of tuples
+static int selectKM(const attrInfo values[])
+{
+  const char *names[] = {"k", "m"};
+  const Datatype types[] = {INTEGER, INTEGER};
+  createRel(RESULTNAME, 2, names, types);
+  const attrInfo proj[] = {attr(RELQ, "k"), attr(RELQ, "m")};
+  predInfo preds[2];
+  for(int i = 0; i < 2; i++) {
+    preds[i].attr = values[i];
+    preds[i].op = EQ;
+    preds[i].attrValue = values[i].attrValue;
+  }
+  CALL(Operators::Select(RESULTNAME, 2, proj, 2, preds));
+  const int cnt = scan(RESULTNAME).size();
+  CALL(relCat->destroyRel(RESULTNAME));
+  return cnt;
+}
+
+
+// A composite index on (k, m), whose catalog entry outlives the
+// relation, must not keep inserts into a relation of the same name with
+// other attributes from working, nor be used for one with the same
+// attributes. Both relations with that schema get as many tuples, so
+// their files are at the same version, but (1, 2) is elsewhere in the
+// second one.
+static void checkRecreatedCompositeIndex()
+{
+  const char *names[] = {"k", "m"};
+  const char *otherNames[] = {"x", "y"};
+  const Datatype types[] = {INTEGER, INTEGER};
+  const int k = 1, m = 2;
+  attrInfo values[2] = {attr(RELQ, "k"), attr(RELQ, "m")};
+  values[0].attrValue = (void *)&k;
+  values[1].attrValue = (void *)&m;
+  for(int i = 0; i < 2; i++) {
+    values[i].attrType = INTEGER;
+    values[i].attrLen = sizeof(int);
+  }
+
+  createRel(RELQ, 2, names, types);
+  {
+    Status status;
+    CompIndexCatalog compCat(status);
+    CALL(status);
+    const string keyNames[] = {"k", "m"};
+    CALL(compCat.addIndex(RELQ, 2, keyNames));
+  }
+  for(int i = 0; i < QTUPLES; i++) {
+    const int t[2] = {i, i + 1};
+    insert(RELQ, t, sizeof(t));
+  }
+  check("composite index", selectKM(values) == 1);
+  CALL(relCat->destroyRel(RELQ));
+
+  createRel(RELQ, 2, otherNames, types);
+  attrInfo other[2] = {values[0], values[1]};
+  strcpy(other[0].attrName, "x");
+  strcpy(other[1].attrName, "y");
+  check("recreated relation, insert past a composite index",
+        Updates::Insert(RELQ, 2, other) == OK);
+  CALL(relCat->destroyRel(RELQ));
+
+  createRel(RELQ, 2, names, types);
+  for(int i = 0; i < QTUPLES; i++) {
+    const int t[2] = {QTUPLES - 1 - i, QTUPLES - i};
+    insert(RELQ, t, sizeof(t));
+  }
+  check("recreated relation, composite index", selectKM(values) == 1);
+
+  {
+    Status status;
+    CompIndexCatalog compCat(status);
+    CALL(status);
+    const string keyNames[] = {"k", "m"};
+    CALL(compCat.dropIndex(RELQ, 2, keyNames));
+  }
+  CALL(relCat->destroyRel(RELQ));
+}
+
+
+// Driver program checking the operators that have several algorithms
+// against plain scans of the same relations. The relations are created
+// in the database and destroyed again. Prints a line per check and
+// returns 1 if any of them failed.
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    cerr << "Usage: " << argv[0] << " dbname" << endl;
+    return 1;
+  }
+
+  if (chdir(argv[1]) < 0) {
+    perror("chdir");
+    exit(1);
+  }
+
+  // create buffer manager
+  bufMgr = new BufMgr(32);
+
+  // open relation and attribute catalogs
+  Status status;
+
+  relCat = new RelCatalog(status);
+  if (status == OK)
+    attrCat = new AttrCatalog(status);
+  if (status != OK) {
+    error.print(status);
+    exit(1);
+  }
+
+  createRelations();
+  CALL(relCat->addIndex(RELR, "id"));
+  CALL(relCat->addIndex(RELR, "b"));
+
+  checkCount();
+  checkEmptyAggregate();
+  checkAggregate("hash aggregate, GROUP BY a", 1);
+  checkAggregate("hash aggregate, GROUP BY a, b", 2);
+  checkOrderBy("top-N order by, LIMIT 10", 10);
+  checkOrderBy("sort order by", 0);
+  checkMultiJoin();
+  checkDoubleJoin("multi-way join on DOUBLEs, joined last", 1);
+  checkDoubleJoin("multi-way join on DOUBLEs, joined first", 600);
+
+  // sorts on a read the relation as it is
+  checkCluster("a");
+  checkAggregate("sort aggregate, GROUP BY a", 1);
+  checkAggregate("sort aggregate, GROUP BY a, b", 2);
+  checkIndexSelect(rtuple(scan(RELR)[17]).id, rtuple(scan(RELR)[17]).b);
+  checkCluster("b");
+  checkIndexSelect(rtuple(scan(RELR)[42]).id, rtuple(scan(RELR)[42]).b);
+
+  checkRecreatedSortedCopy();
+  checkRecreatedClustering();
+  checkRecreatedAdaptiveIndex();
+  checkRecreatedCompositeIndex();
+
+  CALL(relCat->destroyRel(RELR));
+
+  if (failures)
+    cout << failures << " check(s) FAILED" << endl;
+  else
+    cout << "all checks passed" << endl;
+
+  delete relCat;
+  delete attrCat;
+
+  delete bufMgr;
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "catalog.h"
+#include "utility.h"
+
+// Global variables
+DB db;                 // a handle for the DB class
+Error error;           // a handle for the error class
+
+BufMgr *bufMgr;        // pointer to the buffer manager
+RelCatalog *relCat;    // pointer to the relation catalogs
+AttrCatalog *attrCat;  // pointer to the attribute catalogs
+
+#define CALL(c)    {Status s;if((s=c)!=OK){error.print(s);exit(1);}}
+
+
+// Driver program for rewriting relations in the order of an attribute
+// (CLUSTER), given as relation.attribute
+int main(int argc, char *argv[])
+{
+  if (argc < 3) {
+    cerr << "Usage: " << argv[0] << " dbname relation.attribute ..." << endl;
+    return 1;
+  }
+
+  if (chdir(argv[1]) < 0) {
+    perror("chdir");
+    exit(1);
+  }
+
+  // create buffer manager
+  bufMgr = new BufMgr(32);
+
+  // open relation and attribute catalogs
+  Status status;
+
+  relCat = new RelCatalog(status);
+  if (status == OK)
+    attrCat = new AttrCatalog(status);
+  if (status != OK) {
+    error.print(status);
+    exit(1);
+  }
+
+  for(int i = 2; i < argc; i++) {
+    const char *dot = strchr(argv[i], '.');
+    if (!dot) {
+      cerr << "Usage: " << argv[0] << " dbname relation.attribute ..." << endl;
+      return 1;
+    }
+    const string relation(argv[i], dot - argv[i]);
+    CALL(Utilities::Cluster(relation, dot + 1));
+    cout << "Clustered " << argv[i] << endl;
+  }
+
+  delete relCat;
+  delete attrCat;
+
+  delete bufMgr;
+
+  return 0;
+}
@@ -0,0 +1,933 @@
+#include <cstring>
+#include <sstream>
+#include "exec.h"
+#include "sort.h"
+#include "index.h"
+#include "normkey.h"
+#include "adaptive.h"
+
+int calTupleLength(const AttrDesc &attrDesc);
+
+
+// Copy the next tuples of the plan one after the other. The tuples of
+// a plan all have the same length.
+
+Status Iterator::nextBatch(std::vector<char> & tuples, int & tupleLen,
+			   int & tupleCnt, const int maxCnt)
+{
+  Status status = OK;
+  Record rec;
+
+  tuples.clear();
+  tupleLen = 0;
+  tupleCnt = 0;
+
+  while (tupleCnt < maxCnt && (status = next(rec)) == OK) {
+    tupleLen = rec.length;
+    tuples.insert(tuples.end(), (char *)rec.data, (char *)rec.data + rec.length);
+    tupleCnt++;
+  }
+
+  if (status != OK && status != FILEEOF) return status;
+  return tupleCnt > 0 ? OK : FILEEOF;
+}
+
+
+// Copy the attribute value at src into a NUL terminated buffer of at
+// least length bytes, so that a string compared over a longer length
+// than its own stops at the end of it.
+
+static void copyValue(std::vector<char> & value, const char* src,
+		      const int srcLen, const int length)
+{
+  value.assign(max(srcLen, length) + 1, 0);
+  memcpy(&value[0], src, srcLen);
+}
+
+
+Operator flipOp(const Operator op)
+{
+  switch (op) {
+  case LT:  return GT;
+  case LTE: return GTE;
+  case GTE: return LTE;
+  case GT:  return LT;
+  default:  return op;
+  }
+}
+
+
+// Put the tuples of a join side by side in tuple.
+
+static Record joinTuples(std::vector<char> & tuple,
+			 const Record & left, const Record & right)
+{
+  tuple.resize(left.length + right.length);
+  memcpy(&tuple[0], left.data, left.length);
+  memcpy(&tuple[left.length], right.data, right.length);
+
+  Record rec = {&tuple[0], (int)tuple.size()};
+  return rec;
+}
+
+
+ScanIter::ScanIter(const string & relName)
+  : relName(relName), filtered(false), op(NOTSET), attrValue(NULL),
+    buildIndex(false), build(NULL), built(false), hfs(NULL)
+{
+}
+
+
+ScanIter::ScanIter(const string & relName, const AttrDesc & attrDesc,
+		   const Operator op, const void* attrValue,
+		   const bool buildIndex)
+  : relName(relName), filtered(true), attrDesc(attrDesc), op(op),
+    attrValue(attrValue), buildIndex(buildIndex), build(NULL), built(false),
+    hfs(NULL)
+{
+}
+
+
+ScanIter::~ScanIter()
+{
+  close();
+}
+
+
+Status ScanIter::open()
+{
+  Status status;
+
+  close();
+  if (built) buildIndex = false;
+  if (filtered && !buildIndex)
+    hfs = new HeapFileScan(relName, attrDesc.attrOffset, attrDesc.attrLen,
+			   static_cast<Datatype>(attrDesc.attrType),
+			   (const char *)attrValue, op, status);
+  else
+    hfs = new HeapFileScan(relName, status);
+  if (status != OK) {
+    close();
+    return status;
+  }
+
+  if (buildIndex && !built)
+    build = new CrackerIndex(attrDesc, hfs->getFileId(), hfs->getVersion());
+  return OK;
+}
+
+
+Status ScanIter::next(Record & rec)
+{
+  RID rid;
+  Status status;
+
+  if (!hfs) return FILEEOF;
+
+  for (;;) {
+    status = hfs->scanNext(rid, rec);
+    if (status != OK) break;
+
+    // without the filter in the heap file scan, check the predicate here
+    if (!buildIndex) return OK;
+
+    if (build) {
+      build->add((const char *)rec.data, rid);
+      if (build->getBytes() > ADAPTIVEBYTES) {
+	delete build;
+	build = NULL;
+      }
+    }
+    PredDesc pred = {attrDesc, op, attrValue};
+    if (Operators::MatchPredicates(rec, 1, &pred)) return OK;
+  }
+
+  if (status == FILEEOF && build) {
+    addAdaptiveIndex(build);
+    build = NULL;
+    built = true;
+  }
+  return status;
+}
+
+
+Status ScanIter::close()
+{
+  Status status = OK;
+
+  if (hfs) {
+    status = hfs->endScan();
+    delete hfs;
+    hfs = NULL;
+  }
+  delete build;
+  build = NULL;
+  return status;
+}
+
+
+bool ScanIter::indexBuilt() const
+{
+  return built;
+}
+
+
+IndexScanIter::IndexScanIter(const AttrDesc & attrDesc, const void* attrValue)
+  : attrDesc(attrDesc), attrValue(attrValue), hfs(NULL), pos(0)
+{
+}
+
+
+IndexScanIter::~IndexScanIter()
+{
+  close();
+}
+
+
+Status IndexScanIter::open()
+{
+  Status status;
+  int pageCnt;
+
+  close();
+
+  Index index(attrDesc.relName, attrDesc.attrOffset, attrDesc.attrLen,
+	      static_cast<Datatype>(attrDesc.attrType), 0, status);
+  if (status != OK) return status;
+
+  status = Operators::CollectRIDs(index, attrValue, rids, pageCnt);
+  if (status != OK) return status;
+
+  hfs = new HeapFileScan(attrDesc.relName, status);
+  if (status != OK) {
+    close();
+    return status;
+  }
+
+  pos = 0;
+  return OK;
+}
+
+
+Status IndexScanIter::next(Record & rec)
+{
+  if (!hfs || pos >= rids.size()) return FILEEOF;
+  return hfs->getRandomRecord(rids[pos++], rec);
+}
+
+
+Status IndexScanIter::close()
+{
+  Status status = OK;
+
+  if (hfs) {
+    status = hfs->endScan();
+    delete hfs;
+    hfs = NULL;
+  }
+  rids.clear();
+  return status;
+}
+
+
+RIDScanIter::RIDScanIter(const string & relName, const std::vector<RID> & rids)
+  : relName(relName), hfs(NULL), rids(rids), pos(0)
+{
+}
+
+
+RIDScanIter::~RIDScanIter()
+{
+  close();
+}
+
+
+Status RIDScanIter::open()
+{
+  Status status;
+
+  close();
+  hfs = new HeapFileScan(relName, status);
+  if (status != OK) {
+    close();
+    return status;
+  }
+
+  pos = 0;
+  return OK;
+}
+
+
+Status RIDScanIter::next(Record & rec)
+{
+  if (!hfs || pos >= rids.size()) return FILEEOF;
+  return hfs->getRandomRecord(rids[pos++], rec);
+}
+
+
+Status RIDScanIter::close()
+{
+  Status status = OK;
+
+  if (hfs) {
+    status = hfs->endScan();
+    delete hfs;
+    hfs = NULL;
+  }
+  return status;
+}
+
+
+FilterIter::FilterIter(Iterator* child, const int predCnt,
+		       const PredDesc preds[])
+  : child(child), preds(preds, preds + predCnt)
+{
+}
+
+
+FilterIter::~FilterIter()
+{
+  delete child;
+}
+
+
+Status FilterIter::open()
+{
+  return child->open();
+}
+
+
+Status FilterIter::next(Record & rec)
+{
+  Status status;
+
+  while ((status = child->next(rec)) == OK) {
+    if (preds.empty() || Operators::MatchPredicates(rec, preds.size(), &preds[0]))
+      return OK;
+  }
+  return status;
+}
+
+
+Status FilterIter::close()
+{
+  return child->close();
+}
+
+
+CompareIter::CompareIter(Iterator* child, const AttrDesc & attrDesc1,
+			 const Operator op, const AttrDesc & attrDesc2)
+  : child(child), attrDesc2(attrDesc2)
+{
+  pred.attrDesc = attrDesc1;
+  pred.op = op;
+  pred.attrValue = NULL;
+}
+
+
+CompareIter::~CompareIter()
+{
+  delete child;
+}
+
+
+Status CompareIter::open()
+{
+  return child->open();
+}
+
+
+Status CompareIter::next(Record & rec)
+{
+  Status status;
+
+  while ((status = child->next(rec)) == OK) {
+    copyValue(value, (char *)rec.data + attrDesc2.attrOffset, attrDesc2.attrLen,
+	      pred.attrDesc.attrLen);
+    pred.attrValue = &value[0];
+    if (Operators::MatchPredicates(rec, 1, &pred))
+      return OK;
+  }
+  return status;
+}
+
+
+Status CompareIter::close()
+{
+  return child->close();
+}
+
+
+ProjectIter::ProjectIter(Iterator* child, const int projCnt,
+			 const AttrDesc projNames[], const int reclen)
+  : child(child), proj(projCnt, projNames, reclen)
+{
+}
+
+
+ProjectIter::~ProjectIter()
+{
+  delete child;
+}
+
+
+Status ProjectIter::open()
+{
+  return child->open();
+}
+
+
+Status ProjectIter::next(Record & rec)
+{
+  Record in;
+
+  Status status = child->next(in);
+  if (status != OK) return status;
+
+  rec.data = (void *)proj.project(in.data);
+  rec.length = proj.getLength();
+  return OK;
+}
+
+
+Status ProjectIter::close()
+{
+  return child->close();
+}
+
+
+NLJoinIter::NLJoinIter(Iterator* left, const AttrDesc & leftAttr,
+		       const Operator op,
+		       Iterator* right, const AttrDesc & rightAttr,
+		       const int blockBytes)
+  : left(left), right(right), rightAttr(rightAttr), blockBytes(blockBytes),
+    leftLen(0), blockCnt(0), cur(0), leftDone(false), rightOpen(false)
+{
+  pred.attrDesc = leftAttr;
+  pred.op = op;
+  pred.attrValue = NULL;
+}
+
+
+NLJoinIter::~NLJoinIter()
+{
+  close();
+  delete left;
+  delete right;
+}
+
+
+Status NLJoinIter::open()
+{
+  close();
+  leftDone = false;
+  return left->open();
+}
+
+
+Status NLJoinIter::next(Record & rec)
+{
+  Status status;
+  Record leftRec;
+
+  for (;;) {
+    if (rightOpen) {
+      // join the current right tuple with the rest of the block
+      while (cur < blockCnt) {
+	leftRec.data = &block[cur++ * leftLen];
+	leftRec.length = leftLen;
+	if (pred.op == NOTSET || Operators::MatchPredicates(leftRec, 1, &pred)) {
+	  rec = joinTuples(tuple, leftRec, rightRec);
+	  return OK;
+	}
+      }
+
+      status = right->next(rightRec);
+      if (status == OK) {
+	if (pred.op != NOTSET) {
+	  copyValue(value, (char *)rightRec.data + rightAttr.attrOffset, rightAttr.attrLen,
+		    pred.attrDesc.attrLen);
+	  pred.attrValue = &value[0];
+	}
+	cur = 0;
+	continue;
+      }
+      if (status != FILEEOF) return status;
+
+      rightOpen = false;
+      status = right->close();
+      if (status != OK) return status;
+    }
+
+    // read the next block of left tuples and run the right input for it
+    if (leftDone) return FILEEOF;
+
+    block.clear();
+    blockCnt = 0;
+    while (blockCnt == 0 || (int)block.size() + leftLen <= blockBytes) {
+      status = left->next(leftRec);
+      if (status == FILEEOF) {
+	leftDone = true;
+	break;
+      }
+      if (status != OK) return status;
+
+      leftLen = leftRec.length;
+      block.insert(block.end(), (char *)leftRec.data, (char *)leftRec.data + leftLen);
+      blockCnt++;
+    }
+    if (blockCnt == 0) return FILEEOF;
+
+    status = right->open();
+    if (status != OK) return status;
+    rightOpen = true;
+    cur = blockCnt;
+  }
+}
+
+
+Status NLJoinIter::close()
+{
+  Status status = OK;
+
+  if (rightOpen) {
+    status = right->close();
+    rightOpen = false;
+  }
+  block.clear();
+  blockCnt = 0;
+  Status leftStatus = left->close();
+  return status != OK ? status : leftStatus;
+}
+
+
+INLJoinIter::INLJoinIter(Iterator* left, const AttrDesc & leftAttr,
+			 const AttrDesc & rightAttr)
+  : left(left), leftAttr(leftAttr), rightAttr(rightAttr),
+    index(NULL), column(NULL), hfs(NULL), pos(0)
+{
+  match.attrDesc = rightAttr;
+  match.op = EQ;
+  match.attrValue = NULL;
+}
+
+
+INLJoinIter::~INLJoinIter()
+{
+  close();
+  delete left;
+}
+
+
+Status INLJoinIter::open()
+{
+  Status status;
+
+  close();
+
+  hfs = new HeapFileScan(rightAttr.relName, status);
+  if (status == OK && rightAttr.indexed == 1)
+    index = new Index(rightAttr.relName, rightAttr.attrOffset, rightAttr.attrLen,
+		      static_cast<Datatype>(rightAttr.attrType), 0, status);
+  else if (status == OK && !(column = findAdaptiveIndex(rightAttr)))
+    status = NOINDEX;
+  if (status == OK)
+    status = left->open();
+  if (status != OK) {
+    close();
+    return status;
+  }
+
+  rids.clear();
+  pos = 0;
+  return OK;
+}
+
+
+Status INLJoinIter::next(Record & rec)
+{
+  Status status;
+  Record leftRec, rightRec;
+  int pageCnt;
+
+  if (!hfs) return FILEEOF;
+
+  for (;;) {
+    // probe the index for left tuples until one of them has a match
+    while (pos >= rids.size()) {
+      status = left->next(leftRec);
+      if (status != OK) return status;
+
+      leftTuple.assign((char *)leftRec.data, (char *)leftRec.data + leftRec.length);
+      if (index) {
+	status = Operators::CollectRIDs(*index, &leftTuple[leftAttr.attrOffset], rids, pageCnt);
+	if (status != OK) return status;
+      }
+      else {
+	copyValue(value, &leftTuple[leftAttr.attrOffset], leftAttr.attrLen, rightAttr.attrLen);
+	column->lookup(EQ, &value[0], rids);
+	match.attrValue = &value[0];
+      }
+      pos = 0;
+    }
+
+    status = hfs->getRandomRecord(rids[pos++], rightRec);
+    if (status != OK) return status;
+
+    // the adaptive index returns candidates
+    if (index || Operators::MatchPredicates(rightRec, 1, &match)) break;
+  }
+
+  Record l = {&leftTuple[0], (int)leftTuple.size()};
+  rec = joinTuples(tuple, l, rightRec);
+  return OK;
+}
+
+
+Status INLJoinIter::close()
+{
+  Status status = OK;
+
+  if (hfs) {
+    status = left->close();
+    delete index;
+    index = NULL;
+    column = NULL;
+    hfs->endScan();
+    delete hfs;
+    hfs = NULL;
+  }
+  rids.clear();
+  pos = 0;
+  return status;
+}
+
+
+SMJoinIter::SMJoinIter(const AttrDesc & leftAttr, const AttrDesc & rightAttr)
+  : leftAttr(leftAttr), rightAttr(rightAttr), input(NULL), inputLen(0),
+    left(NULL), right(NULL), filter(NULL), inGroup(false)
+{
+}
+
+
+SMJoinIter::SMJoinIter(Iterator* input, const int leftLen,
+		       const AttrDesc & leftAttr, const AttrDesc & rightAttr)
+  : leftAttr(leftAttr), rightAttr(rightAttr), input(input), inputLen(leftLen),
+    left(NULL), right(NULL), filter(NULL), inGroup(false)
+{
+}
+
+
+SMJoinIter::~SMJoinIter()
+{
+  close();
+  delete filter;
+  delete input;
+}
+
+
+// Write the tuples of the left plan to a new temporary file, named
+// after the right relation.
+
+Status SMJoinIter::writeInput()
+{
+  static int tempFileCnt = 0;
+  Status status;
+
+  do {
+    ostringstream outputString;
+    outputString << rightAttr.relName << ".smj." << ++tempFileCnt;
+    tempName = outputString.str();
+  } while ((status = db.createFile(tempName)) == FILEEXISTS);
+  if (status != OK) {
+    tempName.clear();
+    return status;
+  }
+  if ((status = db.destroyFile(tempName)) != OK)
+    return status;
+
+  HeapFile temp(tempName, status);
+  if (status != OK) return status;
+  if ((status = input->open()) != OK) return status;
+
+  Record rec;
+  RID rid;
+  while ((status = input->next(rec)) == OK) {
+    if ((status = temp.insertRecord(rec, rid)) != OK) return status;
+  }
+  if (status != FILEEOF) return status;
+  return input->close();
+}
+
+
+const BloomFilter* SMJoinIter::getFilter() const
+{
+  return filter;
+}
+
+
+Status SMJoinIter::open()
+{
+  Status status;
+
+  close();
+  delete filter;
+  filter = NULL;
+
+  // With several processors the sort of each memory load is split over
+  // threads; on one, replacement selection gives fewer runs to merge.
+  // A sorted relation that comes out as a single run is kept, and as
+  // long as the relation does not change the next join on the same
+  // attribute reads the sorted copy (see SortCatalog)
+  const RunGenerator runGen = SortedFile::sortThreads() > 1 ? PARALLEL_RUNS : REPLACEMENT_SELECTION;
+
+  // Semi-join reduction: a Bloom filter over the join keys of the smaller
+  // relation is pushed into the sort of the larger one, so that its tuples
+  // without a match are dropped before they are sorted and written to runs
+  string leftName(leftAttr.relName);
+  int leftLen;
+  if (input) {
+    if ((status = writeInput()) != OK) {
+      close();
+      return status;
+    }
+    leftName = tempName;
+    leftLen = inputLen;
+  }
+  else
+    leftLen = calTupleLength(leftAttr);
+
+  int recCnt1, recCnt2;
+  status = Operators::GetRecCnt(leftName, recCnt1);
+  if (status != OK) return status;
+  status = Operators::GetRecCnt(rightAttr.relName, recCnt2);
+  if (status != OK) return status;
+
+  const bool leftBuild = (recCnt1 <= recCnt2);
+  if (!input && Operators::SemiJoinApplies(leftAttr, rightAttr, false)) {
+    const AttrDesc & buildDesc = leftBuild ? leftAttr : rightAttr;
+    filter = new BloomFilter(min(recCnt1, recCnt2),
+			     static_cast<Datatype>(buildDesc.attrType), buildDesc.attrLen);
+    status = Operators::BuildBloomFilter(buildDesc, *filter);
+    if (status != OK) return status;
+  }
+
+  // Sort each relation on its join attribute, in the unpinned part of
+  // the buffer pool
+  unsigned int pages = bufMgr->numUnpinnedPages() * 0.8;
+  left = new SortedFile(leftName, leftAttr.attrOffset, leftAttr.attrLen,
+			static_cast<Datatype>(leftAttr.attrType),
+			pages * PAGESIZE / leftLen, status,
+			0, runGen, !input, leftBuild ? NULL : filter);
+  if (status != OK) {
+    close();
+    return status;
+  }
+
+  pages = bufMgr->numUnpinnedPages() * 0.8;
+  right = new SortedFile(rightAttr.relName, rightAttr.attrOffset, rightAttr.attrLen,
+			 static_cast<Datatype>(rightAttr.attrType),
+			 pages * PAGESIZE / calTupleLength(rightAttr), status,
+			 0, runGen, true, leftBuild ? filter : NULL);
+  if (status != OK) {
+    close();
+    return status;
+  }
+
+  leftStatus = left->next(leftRec);
+  rightStatus = right->next(rightRec);
+  inGroup = false;
+  return OK;
+}
+
+
+// The merge: when the current tuples match, the position of the right
+// one is marked and the left tuple joins the group of right tuples
+// with its key. A following left tuple with the same key goes back to
+// the mark and joins the group again.
+
+Status SMJoinIter::next(Record & rec)
+{
+  if (!left) return FILEEOF;
+
+  for (;;) {
+    if (inGroup) {
+      if (rightStatus == OK && Operators::matchRec(leftRec, rightRec, leftAttr, rightAttr) == 0) {
+	rec = joinTuples(tuple, leftRec, rightRec);
+	rightStatus = right->next(rightRec);
+	return OK;
+      }
+      if (rightStatus != OK && rightStatus != FILEEOF) return rightStatus;
+
+      // the group is done for this left tuple
+      leftStatus = left->next(leftRec);
+      Record mark = {&markTuple[0], (int)markTuple.size()};
+      if (leftStatus == OK && Operators::matchRec(leftRec, mark, leftAttr, rightAttr) == 0) {
+	rightStatus = right->gotoMark();
+	if (rightStatus == OK) rightStatus = right->next(rightRec);
+	if (rightStatus != OK) return rightStatus;
+	continue;
+      }
+      inGroup = false;
+    }
+
+    if (leftStatus != OK) return leftStatus;
+    if (rightStatus != OK) return rightStatus;
+
+    int diff = Operators::matchRec(leftRec, rightRec, leftAttr, rightAttr);
+    if (diff < 0)
+      leftStatus = left->next(leftRec);
+    else if (diff > 0)
+      rightStatus = right->next(rightRec);
+    else {
+      rightStatus = right->setMark();
+      if (rightStatus != OK) return rightStatus;
+
+      // copied, as rightRec is only valid until the next call of next()
+      markTuple.assign((char *)rightRec.data, (char *)rightRec.data + rightRec.length);
+      inGroup = true;
+    }
+  }
+}
+
+
+Status SMJoinIter::close()
+{
+  Status status = OK;
+
+  delete left;
+  delete right;
+  left = NULL;
+  right = NULL;
+  inGroup = false;
+  if (!tempName.empty()) {
+    status = db.destroyFile(tempName);
+    tempName.clear();
+  }
+  return status;
+}
+
+
+HashJoinIter::HashJoinIter(Iterator* left, const AttrDesc & leftAttr,
+			   Iterator* right, const AttrDesc & rightAttr)
+  : left(left), right(right), leftAttr(leftAttr), rightAttr(rightAttr),
+    keyLen(max(leftAttr.attrLen, rightAttr.attrLen)), rightLen(0), match(-1),
+    opened(false)
+{
+}
+
+
+HashJoinIter::~HashJoinIter()
+{
+  close();
+  delete left;
+  delete right;
+}
+
+
+// Write the normalized key of the attribute value at src into dst,
+// padded with zero bytes to keyLen bytes.
+
+void HashJoinIter::makeKey(const char* src, const AttrDesc & attrDesc,
+			   unsigned char* dst) const
+{
+  memset(dst, 0, keyLen);
+  normalizeKey(src, static_cast<Datatype>(attrDesc.attrType), attrDesc.attrLen, dst);
+}
+
+
+// FNV-1a over the normalized key.
+
+unsigned int HashJoinIter::hash(const unsigned char* key) const
+{
+  unsigned int h = 2166136261u;
+  for (int i = 0; i < keyLen; i++) {
+    h ^= key[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+
+Status HashJoinIter::open()
+{
+  Status status;
+  Record rec;
+
+  close();
+
+  // Build: load the right input into the hash table
+  status = right->open();
+  if (status != OK) return status;
+
+  int cnt = 0;
+  while ((status = right->next(rec)) == OK) {
+    rightLen = rec.length;
+    rightTuples.insert(rightTuples.end(), (char *)rec.data, (char *)rec.data + rec.length);
+    keys.resize((cnt + 1) * keyLen);
+    makeKey((char *)rec.data + rightAttr.attrOffset, rightAttr, &keys[cnt * keyLen]);
+    cnt++;
+  }
+  Status closeStatus = right->close();
+  if (status != FILEEOF) return status;
+  if (closeStatus != OK) return closeStatus;
+
+  unsigned int bucketCnt = 1;
+  while (bucketCnt < (unsigned int)cnt) bucketCnt <<= 1;
+  buckets.assign(bucketCnt, -1);
+  chain.assign(cnt, -1);
+  for (int i = cnt - 1; i >= 0; i--) {
+    const unsigned int b = hash(&keys[i * keyLen]) & (bucketCnt - 1);
+    chain[i] = buckets[b];
+    buckets[b] = i;
+  }
+
+  // Probe: with the tuples of the left input
+  status = left->open();
+  if (status != OK) return status;
+
+  probeKey.resize(keyLen);
+  match = -1;
+  opened = true;
+  return OK;
+}
+
+
+Status HashJoinIter::next(Record & rec)
+{
+  Status status;
+
+  if (!opened) return FILEEOF;
+
+  for (;;) {
+    for (; match >= 0; match = chain[match]) {
+      if (memcmp(&keys[match * keyLen], &probeKey[0], keyLen) == 0) {
+	Record r = {&rightTuples[match * rightLen], rightLen};
+	rec = joinTuples(tuple, leftRec, r);
+	match = chain[match];
+	return OK;
+      }
+    }
+
+    status = left->next(leftRec);
+    if (status != OK) return status;
+
+    makeKey((char *)leftRec.data + leftAttr.attrOffset, leftAttr, &probeKey[0]);
+    match = buckets[hash(&probeKey[0]) & (buckets.size() - 1)];
+  }
+}
+
+
+Status HashJoinIter::close()
+{
+  Status status = OK;
+
+  if (opened) status = left->close();
+  opened = false;
+  rightTuples.clear();
+  keys.clear();
+  buckets.clear();
+  chain.clear();
+  match = -1;
+  return status;
+}
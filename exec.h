@@ -0,0 +1,334 @@
+#ifndef EXEC_H
+#define EXEC_H
+
+#include <vector>
+#include "heapfile.h"
+#include "catalog.h"
+#include "query.h"
+#include "projection.h"
+#include "bloom.h"
+
+class SortedFile;
+class CrackerIndex;
+
+// the operator of the same predicate with its operands swapped
+Operator flipOp(const Operator op);
+
+// # of tuples Operators::Drain asks a plan for at a time
+#define EXECBATCHSIZE 64
+
+
+// The execution engine: a query plan is a tree of iterators, each of
+// which produces its tuples one at a time on demand from the tuples of
+// its children (open/next/close), so operators pipeline without
+// materializing intermediate results. A join produces the tuple of its
+// left input followed by the tuple of its right input.
+//
+// An iterator owns its children and deletes them. The record returned
+// by next() points into memory owned by the iterator (or its inputs)
+// and stays valid until the next call of next() or close(). next()
+// returns FILEEOF after the last tuple. A plan can be opened again
+// after it has been closed, which restarts it.
+
+class Iterator {
+ public:
+  virtual ~Iterator() {}
+
+  virtual Status open() = 0;
+  virtual Status next(Record & rec) = 0;
+  virtual Status close() = 0;
+
+  // Copy up to maxCnt of the next tuples into tuples, one after the
+  // other (tupleLen bytes each). Returns FILEEOF if there are none.
+  virtual Status nextBatch(std::vector<char> & tuples,
+			   int & tupleLen,
+			   int & tupleCnt,
+			   const int maxCnt);
+};
+
+
+// Sequential scan of a relation, optionally filtered on one attribute.
+// With buildIndex, the scan reads every tuple to build an adaptive index
+// on the attribute (see adaptive.h), which is kept if the scan reaches
+// the end of the relation and the index fits in ADAPTIVEBYTES.
+
+class ScanIter : public Iterator {
+ public:
+  ScanIter(const string & relName);
+  ScanIter(const string & relName,
+	   const AttrDesc & attrDesc,     // attribute in the predicate
+	   const Operator op,             // predicate operation
+	   const void* attrValue,         // literal value in the predicate
+	   const bool buildIndex = false);
+  ~ScanIter();
+
+  Status open();
+  Status next(Record & rec);
+  Status close();
+
+  bool indexBuilt() const;          // the scan has built an adaptive index
+
+ private:
+  string relName;
+  bool filtered;
+  AttrDesc attrDesc;
+  Operator op;
+  const void* attrValue;
+  bool buildIndex;
+  CrackerIndex* build;              // the adaptive index being built
+  bool built;
+  HeapFileScan* hfs;
+};
+
+
+// Equality lookup in the hash index on an attribute. The matching RIDs
+// are collected at open() and the tuples fetched in page order.
+
+class IndexScanIter : public Iterator {
+ public:
+  IndexScanIter(const AttrDesc & attrDesc,   // the indexed attribute
+		const void* attrValue);      // the value to look up
+  ~IndexScanIter();
+
+  Status open();
+  Status next(Record & rec);
+  Status close();
+
+ private:
+  AttrDesc attrDesc;
+  const void* attrValue;
+  HeapFileScan* hfs;
+  std::vector<RID> rids;            // the matching RIDs in page order
+  unsigned int pos;                 // next RID to fetch
+};
+
+
+// Fetches the tuples of a relation with the given RIDs, in their order.
+
+class RIDScanIter : public Iterator {
+ public:
+  RIDScanIter(const string & relName,
+	      const std::vector<RID> & rids);
+  ~RIDScanIter();
+
+  Status open();
+  Status next(Record & rec);
+  Status close();
+
+ private:
+  string relName;
+  HeapFileScan* hfs;
+  std::vector<RID> rids;
+  unsigned int pos;                 // next RID to fetch
+};
+
+
+// Passes on the tuples of its child that satisfy all the predicates.
+
+class FilterIter : public Iterator {
+ public:
+  FilterIter(Iterator* child,
+	     const int predCnt,
+	     const PredDesc preds[]);
+  ~FilterIter();
+
+  Status open();
+  Status next(Record & rec);
+  Status close();
+
+ private:
+  Iterator* child;
+  std::vector<PredDesc> preds;
+};
+
+
+// Passes on the tuples of its child in which "attribute op attribute"
+// holds for two of their attributes, e.g. a join predicate between
+// relations that are already joined.
+
+class CompareIter : public Iterator {
+ public:
+  CompareIter(Iterator* child,
+	      const AttrDesc & attrDesc1,     // offsets within the child's tuples
+	      const Operator op,
+	      const AttrDesc & attrDesc2);
+  ~CompareIter();
+
+  Status open();
+  Status next(Record & rec);
+  Status close();
+
+ private:
+  Iterator* child;
+  AttrDesc attrDesc2;
+  PredDesc pred;                    // attrDesc1 op the value of attrDesc2
+  std::vector<char> value;          // the value of attrDesc2
+};
+
+
+// Projects the tuples of its child (see Projection).
+
+class ProjectIter : public Iterator {
+ public:
+  ProjectIter(Iterator* child,
+	      const int projCnt,
+	      const AttrDesc projNames[],  // offsets within the child's tuples
+	      const int reclen);
+  ~ProjectIter();
+
+  Status open();
+  Status next(Record & rec);
+  Status close();
+
+ private:
+  Iterator* child;
+  Projection proj;
+};
+
+
+// Nested loops join for any predicate "left attribute op right
+// attribute": the left tuples are taken in blocks of up to blockBytes
+// bytes (at least one tuple), and the right input is run again for
+// every block. With op NOTSET every pair of tuples joins (a cross
+// product).
+
+class NLJoinIter : public Iterator {
+ public:
+  NLJoinIter(Iterator* left, const AttrDesc & leftAttr,
+	     const Operator op,
+	     Iterator* right, const AttrDesc & rightAttr,
+	     const int blockBytes = 0);
+  ~NLJoinIter();
+
+  Status open();
+  Status next(Record & rec);
+  Status close();
+
+ private:
+  Iterator* left;
+  Iterator* right;
+  AttrDesc rightAttr;
+  int blockBytes;
+  PredDesc pred;                    // left attribute, op, right value
+  std::vector<char> block;          // the current block of left tuples
+  int leftLen;                      // length of a left tuple
+  int blockCnt;                     // # of tuples in block
+  int cur;                          // next tuple of block to join with rightRec
+  bool leftDone;                    // the left input has ended
+  bool rightOpen;                   // the right input runs for block
+  Record rightRec;                  // the current right tuple
+  std::vector<char> value;          // its join attribute value
+  std::vector<char> tuple;          // the output tuple
+};
+
+
+// Indexed nested loops equi-join: the hash index on the join attribute
+// of the right relation, or else its adaptive index (see adaptive.h), is
+// probed for every left tuple.
+
+class INLJoinIter : public Iterator {
+ public:
+  INLJoinIter(Iterator* left, const AttrDesc & leftAttr,
+	      const AttrDesc & rightAttr);    // indexed attribute of a relation
+  ~INLJoinIter();
+
+  Status open();
+  Status next(Record & rec);
+  Status close();
+
+ private:
+  Iterator* left;
+  AttrDesc leftAttr;
+  AttrDesc rightAttr;
+  Index* index;
+  CrackerIndex* column;             // the adaptive index, without index
+  HeapFileScan* hfs;                // the right relation
+  PredDesc match;                   // right attribute EQ the left value
+  std::vector<char> value;          // the left value, for the adaptive index
+  std::vector<char> leftTuple;      // the current left tuple
+  std::vector<RID> rids;            // its matches, in page order
+  unsigned int pos;                 // next match to fetch
+  std::vector<char> tuple;          // the output tuple
+};
+
+
+// Sort-merge equi-join of two relations. Both relations are sorted on
+// their join attributes (keeping sorted copies, see SortedFile); a
+// Bloom filter over the keys of the smaller one drops the tuples of
+// the larger one without a match before they are sorted. The left
+// side can also be a plan, whose tuples (of leftLen bytes, leftAttr at
+// its offset in them) are written to a temporary file at open() and
+// sorted without a filter or a sorted copy.
+
+class SMJoinIter : public Iterator {
+ public:
+  SMJoinIter(const AttrDesc & leftAttr,
+	     const AttrDesc & rightAttr);
+  SMJoinIter(Iterator* input, const int leftLen,
+	     const AttrDesc & leftAttr,
+	     const AttrDesc & rightAttr);
+  ~SMJoinIter();
+
+  Status open();
+  Status next(Record & rec);
+  Status close();
+
+  const BloomFilter* getFilter() const;  // the semi-join filter, or NULL
+
+ private:
+  Status writeInput();              // write the left plan to tempName
+
+  AttrDesc leftAttr;
+  AttrDesc rightAttr;
+  Iterator* input;                  // the left plan, or NULL
+  int inputLen;                     // length of its tuples
+  string tempName;                  // the file its tuples are written to
+  SortedFile* left;
+  SortedFile* right;
+  BloomFilter* filter;
+  Record leftRec, rightRec;         // the current tuples
+  Status leftStatus, rightStatus;
+  bool inGroup;                     // joining leftRec with a group of right tuples
+  std::vector<char> markTuple;      // the first right tuple of the group
+  std::vector<char> tuple;          // the output tuple
+};
+
+
+// Hash equi-join: the tuples of the right input are loaded into an
+// in-memory hash table on their join attribute, which every left tuple
+// probes. The keys are compared in their normalized form, so DOUBLEs
+// must be equal exactly.
+
+class HashJoinIter : public Iterator {
+ public:
+  HashJoinIter(Iterator* left, const AttrDesc & leftAttr,
+	       Iterator* right, const AttrDesc & rightAttr);
+  ~HashJoinIter();
+
+  Status open();
+  Status next(Record & rec);
+  Status close();
+
+ private:
+  void makeKey(const char* src, const AttrDesc & attrDesc,
+	       unsigned char* dst) const;
+  unsigned int hash(const unsigned char* key) const;
+
+  Iterator* left;
+  Iterator* right;
+  AttrDesc leftAttr;
+  AttrDesc rightAttr;
+  int keyLen;                       // length of the normalized keys
+  int rightLen;                     // length of a right tuple
+  std::vector<char> rightTuples;    // the right tuples
+  std::vector<unsigned char> keys;  // their normalized keys
+  std::vector<int> buckets;         // first tuple in each bucket, -1 if none
+  std::vector<int> chain;           // next tuple in the same bucket
+  std::vector<unsigned char> probeKey;  // normalized key of leftRec
+  Record leftRec;                   // the current left tuple
+  int match;                        // next tuple of its bucket to check
+  bool opened;                      // the hash table is built
+  std::vector<char> tuple;          // the output tuple
+};
+
+#endif
@@ -1,5 +1,7 @@
 #include "heapfile.h"
+#include "catalog.h"
 #include "error.h"
+#include "normkey.h"
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
@@ -51,6 +53,11 @@ HeapFile::HeapFile(const string & name, Status& returnStatus)
 	headerPage->lastPage = -1;
 	headerPage->pageCnt = 0;
 	headerPage->recCnt = 0;
+	headerPage->version = 0;
+	headerPage->fileId = newFileId(name, headerPage);
+	headerPage->contiguous = 1;
+	headerPage->catalogFlags = 0;
+	memset(headerPage->zones, 0, sizeof(headerPage->zones));
     }
     else
     {
@@ -96,6 +103,116 @@ const int HeapFile::getRecCnt() const
    // Solution Ends
 }
 
+// Return number of data pages in heap file
+
+const int HeapFile::getPageCnt() const
+{
+  return headerPage->pageCnt;
+}
+
+// the header page must fit in a page
+typedef char HeaderPageFits[sizeof(HeaderPage) <= PAGESIZE ? 1 : -1];
+
+ScanStats HeapFileScan::scanStats = {0, 0};
+
+// Empty all the zones of a zone map
+
+static void clearZones(ZoneMap & zone)
+{
+  zone.pagesPerZone = 1;
+  for (int z = 0; z < ZONECNT; z++) {
+    zone.lo[z] = ~0ull;
+    zone.hi[z] = 0;
+  }
+}
+
+// Add a value on the data page at position pos (counted from the first
+// data page) to a zone map, merging pairs of zones until it has a zone
+// for the page
+
+static void widenZone(ZoneMap & zone, const int pos, const char* value)
+{
+  while (pos / zone.pagesPerZone >= ZONECNT) {
+    for (int z = 0; z < ZONECNT / 2; z++) {
+      zone.lo[z] = zone.lo[2*z] < zone.lo[2*z+1] ? zone.lo[2*z] : zone.lo[2*z+1];
+      zone.hi[z] = zone.hi[2*z] > zone.hi[2*z+1] ? zone.hi[2*z] : zone.hi[2*z+1];
+    }
+    for (int z = ZONECNT / 2; z < ZONECNT; z++) {
+      zone.lo[z] = ~0ull;
+      zone.hi[z] = 0;
+    }
+    zone.pagesPerZone *= 2;
+  }
+
+  const int z = pos / zone.pagesPerZone;
+  const unsigned long long key =
+    keyPrefix(value, static_cast<Datatype>(zone.type), zone.length);
+  if (key < zone.lo[z]) zone.lo[z] = key;
+  if (key > zone.hi[z]) zone.hi[z] = key;
+}
+
+void HeapFile::addToZones(const Record & rec, const int pageNo)
+{
+  if (!headerPage->contiguous) return;
+
+  for (int i = 0; i < MAXZONEMAPS; i++) {
+    ZoneMap & zone = headerPage->zones[i];
+    if (zone.length == 0 || zone.offset + zone.length > rec.length) continue;
+    widenZone(zone, pageNo - headerPage->firstPage, (char *)rec.data + zone.offset);
+  }
+}
+
+// Return the version of the heap file
+
+const int HeapFile::getVersion() const
+{
+  return headerPage->version;
+}
+
+// Return the id of the heap file
+
+const int HeapFile::getFileId() const
+{
+  return headerPage->fileId;
+}
+
+// File ids are handed out by a counter in the header page of the
+// relation catalog, the first file of a database, so a file that is
+// destroyed and created again gets a new id.
+
+int HeapFile::newFileId(const string & name, HeaderPage* header)
+{
+  if (name == RELCATNAME) {
+    header->nextFileId = 2;
+    return 1;
+  }
+
+  Status status;
+  HeapFile relcat(RELCATNAME, status);
+  if (status != OK)
+    return 0;
+  return relcat.headerPage->nextFileId++;
+}
+
+// Return the catalogs that have entries on the heap file
+
+const int HeapFile::getCatalogFlags() const
+{
+  return headerPage->catalogFlags;
+}
+
+void HeapFile::addCatalogFlags(const int flags)
+{
+  headerPage->catalogFlags |= flags;
+}
+
+// Return the zone maps of the heap file
+
+const ZoneMap* HeapFile::getZoneMaps() const
+{
+  return headerPage->zones;
+}
+
 // Insert a record into the file
 const Status HeapFile::insertRecord(const Record & rec, RID& outRid)
 {
@@ -140,6 +257,8 @@ const Status HeapFile::insertRecord(const Record & rec, RID& outRid)
 	// insert was successful. unpin page and return
         status = bufMgr->unPinPage(file, lastPageNo, true);
 	headerPage->recCnt++;
+	headerPage->version++;
+	addToZones(rec, lastPageNo);
 	outRid = rid;
 	return status;
     }
@@ -160,6 +279,7 @@ const Status HeapFile::insertRecord(const Record & rec, RID& outRid)
 	// modify header page contents properly
     	headerPage->lastPage = newPageNo;
 	headerPage->pageCnt++;
+	if (newPageNo != lastPageNo + 1) headerPage->contiguous = 0;
 
 	// link up new page appropriately
 	lastPage->setNextPage(newPageNo);  // set forward pointer
@@ -180,6 +300,8 @@ const Status HeapFile::insertRecord(const Record & rec, RID& outRid)
 	    // insert was successful. unpin page and return
             status = bufMgr->unPinPage(file, newPageNo, true);
 	    headerPage->recCnt++;
+	    headerPage->version++;
+	    addToZones(rec, newPageNo);
 	    outRid = rid;
 	    return status;
         }
@@ -215,6 +337,7 @@ const Status HeapFile::deleteRecord(const RID & rid)
     }
 
     headerPage->recCnt--;
+    headerPage->version++;
 
     // At this point we should check if the whole page can be deallocated.
     if (status == NORECORDS)
@@ -260,8 +383,17 @@ const Status HeapFile::deleteRecord(const RID & rid)
 	else
 	  headerPage->lastPage = page->getPrevPage();	    
 
-	// Now dispose this page
+	// Now dispose this page. The zone maps start over once the file
+	// is empty; freeing a page other than the last one leaves a gap in
+	// the page numbers
 	headerPage->pageCnt--;
+	if (headerPage->firstPage == -1) {
+	  headerPage->contiguous = 1;
+	  for (int i = 0; i < MAXZONEMAPS; i++)
+	    clearZones(headerPage->zones[i]);
+	}
+	else if (nextPageNo != -1)
+	  headerPage->contiguous = 0;
 	if ((status = bufMgr->unPinPage(file, pageNo, true)) != OK)
 	  return status;
 
@@ -374,8 +506,9 @@ const Status HeapFileScan::scanNext(RID& outRid)
     // special case the record of the first page of the file
     if (curPageNo == 0) 
     {
-    	// need to get the first page of the file
+    	// need to get the first page of the file (that may match)
 	curPageNo = headerPage->firstPage;
+	if (curPageNo != -1) curPageNo = nextZonePage(curPageNo);
 	dirtyFlag = false;
 	if (curPageNo == -1) {curRec.reset(); return FILEEOF;} // file is empty
 	 
@@ -384,15 +517,19 @@ const Status HeapFileScan::scanNext(RID& outRid)
         if (status != OK) return status;
 	else
 	{
+	    if (filter) scanStats.pagesRead++;
+
 	    // get the first record off the page
 	    status  = curPage->firstRecord(tmpRid);
 	    curRec = tmpRid;
 	    if (status == NORECORDS) 
 	    {
+		// unpin the empty page, as at the end of the file
+		status = bufMgr->unPinPage(file, curPageNo, dirtyFlag);
     	    	curPageNo = -1; // in case called again
 		curPage = NULL; // for endScan()
 	    	curRec.reset();  // reset the curRec
-                return FILEEOF;  // first page had no records
+                return status == OK ? FILEEOF : status;  // first page had no records
 	    }
 	    // get pointer to record
 	    status = curPage->getRecord(tmpRid, rec);
@@ -418,7 +555,19 @@ const Status HeapFileScan::scanNext(RID& outRid)
 	{
 	    // get the page number of the next page in the file
 	    nextPageNo = curPage->getNextPage();
-	    if (nextPageNo == -1) {curRec.reset(); return FILEEOF;} // end of file
+
+	    // skip the pages that cannot match. At the end of the file
+	    // the scan is over for good: the last page is unpinned, and
+	    // further calls return FILEEOF
+	    if (nextPageNo != -1) nextPageNo = nextZonePage(nextPageNo);
+	    if (nextPageNo == -1)
+	    {
+		status = bufMgr->unPinPage(file, curPageNo, dirtyFlag);
+		curPageNo = -1;
+		curPage = NULL;
+		curRec.reset();
+		return status == OK ? FILEEOF : status;
+	    }
 
 	    // unpin the current page
     	    status = bufMgr->unPinPage(file,curPageNo, 
@@ -432,15 +581,18 @@ const Status HeapFileScan::scanNext(RID& outRid)
 	    // read the next page of the file
             status = bufMgr->readPage(file,curPageNo,curPage);
             if (status != OK) return status;
+	    if (filter) scanStats.pagesRead++;
 
 	    // get the first record off the page
 	    status  = curPage->firstRecord(curRec);
 	    if (status == NORECORDS) 
 	    {
+	       // unpin the empty page, as at the end of the file
+	       status = bufMgr->unPinPage(file, curPageNo, dirtyFlag);
     	       curPageNo = -1; // in case, called again
 	       curPage = NULL; // for endScan()
 	       curRec.reset();  // reset the curRec
-	       return FILEEOF;  // first page had no records
+	       return status == OK ? FILEEOF : status;  // first page had no records
 	    }
 	}
 	// curRec points at a valid record
@@ -459,6 +611,114 @@ const Status HeapFileScan::scanNext(RID& outRid)
    // Solution Ends
 }
 
+// Can a zone of a zone map hold a value that satisfies "value op filter"?
+// Key prefixes only tell strings apart by their first bytes, so for
+// longer strings equal prefixes mean "maybe".
+
+static bool zoneMayMatch(const ZoneMap & zone, const int z,
+			 const unsigned long long key, const Operator op)
+{
+  const unsigned long long lo = zone.lo[z];
+  const unsigned long long hi = zone.hi[z];
+  const bool exact = (zone.type != STRING
+		      || zone.length <= (int)sizeof(unsigned long long));
+
+  if (lo > hi) return false;             // no values
+  switch (op) {
+  case LT:
+  case LTE: return lo <= key;
+  case GT:
+  case GTE: return hi >= key;
+  case EQ:  return lo <= key && key <= hi;
+  case NE:  return !(exact && lo == key && hi == key);
+  default:  return true;
+  }
+}
+
+int HeapFileScan::nextZonePage(int pageNo)
+{
+  if (!filter || !headerPage->contiguous) return pageNo;
+
+  const ZoneMap* zone = NULL;
+  for (int i = 0; i < MAXZONEMAPS; i++) {
+    const ZoneMap & z = headerPage->zones[i];
+    if (z.length == length && z.offset == offset && z.type == type)
+      zone = &z;
+  }
+  if (!zone) return pageNo;
+
+  const unsigned long long key = keyPrefix(filter, type, length);
+  while (pageNo <= headerPage->lastPage) {
+    const int z = (pageNo - headerPage->firstPage) / zone->pagesPerZone;
+    if (z >= ZONECNT || zoneMayMatch(*zone, z, key, op)) return pageNo;
+
+    // skip the rest of the zone
+    int next = headerPage->firstPage + (z + 1) * zone->pagesPerZone;
+    if (next > headerPage->lastPage + 1) next = headerPage->lastPage + 1;
+    scanStats.pagesSkipped += next - pageNo;
+    pageNo = next;
+  }
+  return -1;
+}
+
+const Status HeapFileScan::addZoneMap(const int offset_,
+				      const int length_,
+				      const Datatype type_)
+{
+  Status status;
+  RID rid;
+  Record rec;
+
+  if ((offset_ < 0 || length_ < 1) ||
+      (type_ != STRING && type_ != INTEGER && type_ != DOUBLE) ||
+      ((type_ == INTEGER && length_ != sizeof(int))
+       || (type_ == DOUBLE && length_ != sizeof(double))))
+    return BADSCANPARM;
+
+  // the zone map on the attribute, or else an unused one
+  ZoneMap* zone = NULL;
+  for (int i = 0; i < MAXZONEMAPS; i++) {
+    ZoneMap & z = headerPage->zones[i];
+    if (z.length == length_ && z.offset == offset_ && z.type == type_)
+      zone = &z;
+    else if (!zone && z.length == 0)
+      zone = &z;
+  }
+  if (!zone) return SCANTABFULL;
+
+  zone->offset = offset_;
+  zone->length = length_;
+  zone->type = type_;
+
+  // all the zone maps are rebuilt, as the others were not maintained
+  // if the data pages were not numbered consecutively; while at it,
+  // find out whether they are (again)
+  for (int i = 0; i < MAXZONEMAPS; i++)
+    clearZones(headerPage->zones[i]);
+  headerPage->contiguous = 1;
+  int lastPageNo = headerPage->firstPage - 1;
+
+  if ((status = startScan(0, 0, INTEGER, NULL, EQ)) != OK) return status;
+  while ((status = scanNext(rid, rec)) == OK) {
+    if (rid.pageNo != lastPageNo && rid.pageNo != lastPageNo + 1)
+      headerPage->contiguous = 0;
+    lastPageNo = rid.pageNo;
+    addToZones(rec, rid.pageNo);
+  }
+  if (status != FILEEOF) {
+    endScan();
+    return status;
+  }
+
+  return endScan();
+}
+
+void HeapFileScan::clearScanStats()
+{
+  scanStats.pagesRead = 0;
+  scanStats.pagesSkipped = 0;
+}
+
 // scan the next record and also return the actual record
 const Status HeapFileScan::scanNext(RID& outRid, Record& rec)
 {
@@ -13,6 +13,34 @@ extern DB db;
 // Some constant definitions
 const unsigned MAXNAMESIZE = 50;
 
+// A heap file keeps zone maps on up to MAXZONEMAPS attributes: the
+// smallest and largest value (as key prefixes, see normkey.h) in each of
+// ZONECNT zones of pagesPerZone consecutive data pages. When the file
+// outgrows the zones, neighbouring zones are merged and pagesPerZone
+// doubles. Inserts widen the zones; deletes leave them as they are,
+// which is still safe. A filtered scan skips the zones that cannot hold
+// a match, as long as the data pages are numbered consecutively (no page
+// has been freed but the last one).
+const int MAXZONEMAPS = 2;
+const int ZONECNT = 24;
+
+// What the catalogs hold on a heap file (HeaderPage::catalogFlags), so
+// that an insert only opens the catalogs it has to bring up to date. A
+// flag is set when the first entry is made and stays set.
+const int STATSFLAG = 1;		// statistics (StatCatalog)
+const int CLUSTERFLAG = 2;		// clustering (ClusterCatalog)
+const int COMPINDEXFLAG = 4;		// composite indexes (CompIndexCatalog)
+
+struct ZoneMap
+{
+  int		offset;		// byte offset of the attribute
+  int		length;		// length of the attribute, 0 if unused
+  int		type;		// datatype of the attribute
+  int		pagesPerZone;	// # of data pages per zone
+  unsigned long long lo[ZONECNT];	// smallest value in each zone
+  unsigned long long hi[ZONECNT];	// largest value in each zone
+};
+
 struct HeaderPage
 {
   char fileName[MAXNAMESIZE];   // name of file
@@ -20,6 +48,19 @@ struct HeaderPage
   int		lastPage;	// pageNo of last data page in file
   int		pageCnt;	// number of pages
   int		recCnt;		// record count
+  int		version;	// bumped by every insert and delete
+  int		fileId;		// never handed out again in the database
+  int		nextFileId;	// next file id to hand out (relation catalog only)
+  int		contiguous;	// data pages are firstPage, firstPage + 1, ...
+  int		catalogFlags;	// catalogs with entries on the file (STATSFLAG, ...)
+  ZoneMap	zones[MAXZONEMAPS];	// zone maps of the file
+};
+
+// Page counts of the filtered scans since the counts were last cleared
+struct ScanStats
+{
+  int		pagesRead;	// data pages read
+  int		pagesSkipped;	// data pages skipped using zone maps
 };
 
 
@@ -42,11 +83,41 @@ public:
   // return number of records in file
   const int getRecCnt() const;
 
+  // return number of data pages in file
+  const int getPageCnt() const;
+
+  // return the version of the file; it changes whenever a record is
+  // inserted or deleted, so structures derived from the file can tell
+  // whether they are still up to date. A file created again (under the
+  // same name) starts over, so the version only means something
+  // together with the id of the file.
+  const int getVersion() const;
+
+  // return the id of the file, which no other file of the database has
+  // had or will have
+  const int getFileId() const;
+
+  // the catalogs with entries on the file (STATSFLAG, ...), and
+  // recording that a catalog has some
+  const int getCatalogFlags() const;
+  void addCatalogFlags(const int flags);
+
+  // the zone maps of the file (MAXZONEMAPS of them, length 0 if unused)
+  const ZoneMap* getZoneMaps() const;
+
   // insert record into file
   const Status insertRecord(const Record & rec, RID& outRid); 
 
   // delete record from file
   const Status deleteRecord(const RID & rid);
+
+protected:
+
+  // hand out the id of a new file (see HeaderPage::nextFileId)
+  static int newFileId(const string & name, HeaderPage* header);
+
+  // add a record inserted on page pageNo to the zone maps
+  void addToZones(const Record & rec, const int pageNo);
 };
 
 
@@ -102,8 +173,22 @@ public:
   // read record from file, returning pointer and length
   const Status getRandomRecord(const RID &rid, Record & rec);
 
+  // build a zone map on an attribute (see ZoneMap), rebuilding the
+  // others of the file. No scan may be in progress.
+  const Status addZoneMap(const int offset,
+			  const int length,
+			  const Datatype type);
+
+  // page counts of the filtered scans
+  static ScanStats scanStats;
+  static void clearScanStats();
+
 private:
 
+  // the first data page from pageNo on that the zone maps do not rule
+  // out for the filter, -1 if there is none
+  int nextZonePage(int pageNo);
+
   RID   curRec;            // rid of last record returned
   Page* curPage;	   // pointer to pinned page in buffer pool
   int   curPageNo;	   // page number of pinned page
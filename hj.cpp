@@ -0,0 +1,35 @@
+#include "catalog.h"
+#include "query.h"
+#include "exec.h"
+#include <cstring>
+#include <iostream>
+
+int calTupleLength(const AttrDesc &attrDesc);
+
+/* 
+ * Hash join: the inner relation (attrDesc2) is loaded into an in-memory
+ * hash table on its join attribute, which is probed with the tuples of
+ * the outer relation (attrDesc1)
+ */
+
+Status Operators::HJ(const string& result,           // Name of the output relation
+                     const int projCnt,              // Number of attributes in the projection
+                     const AttrDesc attrDescArray[], // The projection list (as AttrDesc)
+                     const AttrDesc& attrDesc1,      // The left attribute in the join predicate
+                     const Operator op,              // Predicate operator
+                     const AttrDesc& attrDesc2,      // The right attribute in the join predicate
+                     const int reclen)               // Length of a tuple in the output relation
+{
+  	cout << "Algorithm: Hash Join" << endl;
+
+	if(op != EQ) return BADSCANPARM;
+
+	vector<AttrDesc> layout(projCnt);
+	JoinLayout(attrDesc1.relName, calTupleLength(attrDesc1), projCnt, attrDescArray, &layout[0]);
+
+	Iterator *join = new HashJoinIter(new ScanIter(attrDesc1.relName), attrDesc1,
+					  new ScanIter(attrDesc2.relName), attrDesc2);
+	ProjectIter plan(join, projCnt, &layout[0], reclen);
+
+	return Operators::Drain(plan, result);
+}
@@ -4,6 +4,10 @@
 #include <stdlib.h>
 #include <math.h>
 #include "index.h"
+#include "normkey.h"
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 
@@ -18,12 +22,62 @@ Index::Index(const string & name,
 	     const Datatype type, 
 	     const int unique, 
 	     Status& status)
+{
+  init(name, 1, &offset, &length, &type, unique, 0, NULL, NULL, status);
+}
+
+// Constructor for a covering index. In addition to the above,
+//     'includeCnt', 'includeOffset', 'includeLength' -- describing the
+//     attributes that are copied into every index entry
+
+Index::Index(const string & name, 
+	     const int offset, 
+	     const int length, 
+	     const Datatype type, 
+	     const int unique, 
+	     const int includeCnt,
+	     const int includeOffset[],
+	     const int includeLength[],
+	     Status& status)
+{
+  init(name, 1, &offset, &length, &type, unique, 
+       includeCnt, includeOffset, includeLength, status);
+}
+
+// Constructor for a composite index. The key is made of several
+// attributes, described by 'keyOffset', 'keyLength' and 'keyType'.
+// The entries store the concatenated normalized values of the key
+// attributes (see normkey.h).
+
+Index::Index(const string & name, 
+	     const int keyCnt,
+	     const int keyOffset[],
+	     const int keyLength[],
+	     const Datatype keyType[],
+	     const int unique, 
+	     Status& status)
+{
+  init(name, keyCnt, keyOffset, keyLength, keyType, unique, 
+       0, NULL, NULL, status);
+}
+
+void Index::init(const string & name, 
+		 const int keyCnt,
+		 const int keyOffset[],
+		 const int keyLength[],
+		 const Datatype keyType[],
+		 const int unique, 
+		 const int includeCnt,
+		 const int includeOffset[],
+		 const int includeLength[],
+		 Status& status)
 {
   Page* pagePtr;
   file = 0;
 
-  // For this assignment turn off hash indices on strings
-  if (type == STRING ) 
+  // For this assignment turn off hash indices on strings. A composite
+  // key is hashed as a byte string, so strings may be part of it.
+  if (keyCnt == 1 && keyType[0] == STRING ) 
   {
      status = NOCHARIDX;
      return;
@@ -34,33 +88,60 @@ Index::Index(const string & name,
     status = BADFILE;
     return;
   }
-  if (offset < 0 || length < 1) {
+  if (keyCnt < 1 || keyCnt > MAXKEYATTRS) {
     status = BADINDEXPARM;
     return;
   }
 
-  if (type != STRING && type != INTEGER && type != DOUBLE){
-    status = BADINDEXPARM;
-    return;
+  int length = 0;                     // length of the (concatenated) key
+  for (int i = 0; i < keyCnt; i++) {
+    const Datatype type = keyType[i];
+    if (keyOffset[i] < 0 || keyLength[i] < 1) {
+      status = BADINDEXPARM;
+      return;
+    }
+
+    if (type != STRING && type != INTEGER && type != DOUBLE){
+      status = BADINDEXPARM;
+      return;
+    }
+    if (type == INTEGER && keyLength[i] != sizeof(int)
+	|| type == DOUBLE && keyLength[i] != sizeof(double)) {
+      status = BADINDEXPARM;
+      return;
+    }
+    length += keyLength[i];
   }
-  if (type == INTEGER && length != sizeof(int)
-      || type == DOUBLE && length != sizeof(double)) {
+
+  if (includeCnt < 0 || includeCnt > MAXINCLUDE) {
     status = BADINDEXPARM;
     return;
   }
 
   curBuc = NULL;
 
+  // an index entry is the key, the RID and then the included attributes
   recSize = length + sizeof(RID);     // size of the index entry
+  for (int i = 0; i < includeCnt; i++) {
+    if (includeOffset[i] < 0 || includeLength[i] < 1) {
+      status = BADINDEXPARM;
+      return;
+    }
+    recSize += includeLength[i];
+  }
   numSlots = (PAGESIZE - 2*sizeof(short)) / recSize;   // # entries on a page
 
   status = OK;
 
   // get name of the index file by concatenating relation name and
-  // the offset of the attribute
+  // the offset of the attribute (the offsets of all the key attributes
+  // for a composite index)
 
   ostringstream outputString;
-  outputString << name << '.' << offset << ends;
+  outputString << name;
+  for (int i = 0; i < keyCnt; i++)
+    outputString << '.' << keyOffset[i];
+  outputString << ends;
   string indexName(outputString.str());
 
   // The constructor runs in two cases. In the first case, an index 
@@ -88,11 +169,22 @@ Index::Index(const string & name,
       return;
     strcpy(headerPage->fileName, name.c_str());
 
-    headerPage->offset = offset;
+    headerPage->offset = keyOffset[0];
     headerPage->length = length;
-    headerPage->type = type;
+    headerPage->type = keyType[0];
+    headerPage->keyCnt = keyCnt;
+    for (int i = 0; i < keyCnt; i++) {
+      headerPage->keyOffset[i] = keyOffset[i];
+      headerPage->keyLength[i] = keyLength[i];
+      headerPage->keyType[i] = keyType[i];
+    }
     headerPage->depth = 0;
     headerPage->unique = unique;
+    headerPage->includeCnt = includeCnt;
+    for (int i = 0; i < includeCnt; i++) {
+      headerPage->includeOffset[i] = includeOffset[i];
+      headerPage->includeLength[i] = includeLength[i];
+    }
     dirSize = 1;
 
     // allocate and initialize the first bucket pointed by dir[0]
@@ -112,13 +204,18 @@ Index::Index(const string & name,
     // build index by scanning the relation file and inserting every
     // tuple
     
-    HeapFileScan heapFileScan(name, offset, length, type, NULL, EQ, status);
+    HeapFileScan heapFileScan(name, keyOffset[0], keyLength[0], keyType[0],
+			      NULL, EQ, status);
 
     if (status != OK)
       return;
 
     Record rec;
     RID   rid;
+    char  key[PAGESIZE];
+
+    headerPage->relFileId = heapFileScan.getFileId();
+    headerPage->relVersion = heapFileScan.getVersion();
 
     while(1) {
       status = heapFileScan.scanNext(rid);
@@ -130,7 +227,8 @@ Index::Index(const string & name,
       status = heapFileScan.getRecord(rid, rec);
       if (status != OK)
 	return;
-      status = insertEntry((char *)rec.data + offset, rid);
+      makeKey((char *)rec.data, key);
+      status = insertEntry(key, rid, rec);
       if (status != OK)
 	return;
     }
@@ -151,6 +249,13 @@ Index::Index(const string & name,
       }
     headerPage = (iHeaderPage*) pagePtr;
     dirSize = (int)pow(2.0, headerPage->depth);
+
+    // the entry layout is taken from the existing index, which may
+    // have been created with included attributes
+    recSize = headerPage->length + sizeof(RID);
+    for (int i = 0; i < headerPage->includeCnt; i++)
+      recSize += headerPage->includeLength[i];
+    numSlots = (PAGESIZE - 2*sizeof(short)) / recSize;
   }
 }
 
@@ -178,7 +283,15 @@ const Status Index::hashIndex(const void *attr, int& hashvalue)
     int index;
     const char *value = (const char *)attr;
 
-    switch (headerPage->type)
+    // A composite key is hashed as a byte string (FNV-1a)
+    if (headerPage->keyCnt > 1)
+    {
+       unsigned int h = 2166136261u;
+       for (int i = 0; i < headerPage->length; i++)
+         h = (h ^ (unsigned char)value[i]) * 16777619u;
+       index = (int)(h & 0x7fffffff);
+    }
+    else switch (headerPage->type)
     {
        case STRING:
             {
@@ -216,11 +329,52 @@ const Status Index::hashIndex(const void *attr, int& hashvalue)
     return OK;
   }
 
-// Insert an <attribute, rid> pair into the index. Return OK if the 
+// Insert an <attribute, rid> pair into the index. If the index covers
+// other attributes as well, they are read from the record in the relation.
+
+const Status Index::insertEntry(const void *value, RID rid) 
+{
+  Status status;
+
+  if (headerPage->includeCnt == 0) {
+    Record rec = {NULL, 0};
+    return insertEntry(value, rid, rec);
+  }
+
+  HeapFileScan scan(headerPage->fileName, status);
+  if (status != OK)
+    return status;
+
+  Record rec;
+  if ((status = scan.getRandomRecord(rid, rec)) != OK)
+    return status;
+  return insertEntry(value, rid, rec);
+}
+
+// Insert an <attribute, rid> pair into the index, copying the included
+// attributes (if any) from the record rec.
+
+const Status Index::insertEntry(const void *value, RID rid, const Record & rec) 
+{
+  char entry[PAGESIZE];
+  int entryOffset = headerPage->length + sizeof(RID);
+
+  memcpy(entry, value, headerPage->length);
+  memcpy(&entry[headerPage->length], &rid, sizeof(RID));
+  for (int i = 0; i < headerPage->includeCnt; i++) {
+    memcpy(&entry[entryOffset], (char *)rec.data + headerPage->includeOffset[i],
+	   headerPage->includeLength[i]);
+    entryOffset += headerPage->includeLength[i];
+  }
+
+  return insertRaw(entry);
+}
+
+// Insert a complete index entry into the index. Return OK if the 
 // entry is inserted and DIROVERFLOW if the directory isn't large
 // enough to hold the indices.
 
-const Status Index::insertEntry(const void *value, RID rid) 
+const Status Index::insertRaw(const char *entry) 
 { 
   Bucket* bucket;
   Status status;
@@ -229,6 +383,8 @@ const Status Index::insertEntry(const void *value, RID rid)
   char  data[PAGESIZE*2];
   int counter;
   int index;
+  const void *value = entry;
+  RID rid = *(RID *)(entry + headerPage->length);
 
   // If the 'unique' flag is set, scan the index to see if the
   // <attribute, rid> pair already exists
@@ -276,9 +432,9 @@ const Status Index::insertEntry(const void *value, RID rid)
 
     // Copy all (value, rid) pairs in the old bucket and the new
     // entry to a temporary area
-    memcpy(data, bucket->data, numSlots*recSize);
-    memcpy(&(data[numSlots*recSize]), value, headerPage->length);
-    memcpy(&(data[numSlots*recSize + headerPage->length]), &rid, sizeof(RID));
+    for (int k = 0; k < numSlots; k++)
+      getSlot(bucket, k, &(data[k * recSize]));
+    memcpy(&(data[numSlots*recSize]), entry, recSize);
 
     counter = bucket->slotCnt + 1;
     bucket->slotCnt = 0;
@@ -315,13 +471,11 @@ const Status Index::insertEntry(const void *value, RID rid)
       printDir();
 #endif 
 
-    // call insertEntry recursively to insert all (value, rid) 
-    // pairs in the temporary area to the index
+    // call insertRaw recursively to insert all the entries
+    // in the temporary area to the index
 
     for (int k = 0; k < counter; k++) {
-      value = &(data[k * recSize]);
-      rid = * ((RID *)((char *)value + headerPage->length));
-      status = insertEntry(value, rid);
+      status = insertRaw(&(data[k * recSize]));
       if (status != OK)
 	return status;
     }
@@ -332,9 +486,7 @@ const Status Index::insertEntry(const void *value, RID rid)
     } else { 
     // There is sufficient free space in the bucket. Insert (value, rid) here
 
-    int offset = (bucket->slotCnt) * recSize;
-    memcpy(&(bucket->data[offset]), value, headerPage->length);
-    memcpy(&(bucket->data[offset+headerPage->length]), &rid, sizeof(RID));
+    putSlot(bucket, bucket->slotCnt, entry);
     (bucket->slotCnt)++;
   }
 
@@ -371,22 +523,20 @@ const Status Index::deleteEntry(const void* value, const RID & rid)
     return status;
 
   // scan the bucket for the entry. Delete it if found
-  for(int i = 0; i < bucket->slotCnt; i++) {
-    status = matchRec(bucket, value, i);
-    if (status == OK) {
-      if (!memcmp(&rid, &(bucket->data[i*recSize + headerPage->length]), 
-		 sizeof(RID))) {
-
-	// the entry is found. Decrease the entry counts in the bucket
-	// and copy the last entry in the bucket to the slot occupied
-	// by the deleted entry
-
-	(bucket->slotCnt)--;
-	memcpy(&(bucket->data[i*recSize]), 
-	       &(bucket->data[recSize*(bucket->slotCnt)]),recSize);
-	status = bufMgr->unPinPage(file, pageNo, true);
-	return status;
-      }
+  for(int i = nextMatch(bucket, value, 0); i < bucket->slotCnt; 
+      i = nextMatch(bucket, value, i + 1)) {
+    if (!memcmp(&rid, slotRest(bucket, i), sizeof(RID))) {
+
+      // the entry is found. Decrease the entry counts in the bucket
+      // and copy the last entry in the bucket to the slot occupied
+      // by the deleted entry
+
+      char entry[PAGESIZE];
+      (bucket->slotCnt)--;
+      getSlot(bucket, bucket->slotCnt, entry);
+      putSlot(bucket, i, entry);
+      status = bufMgr->unPinPage(file, pageNo, true);
+      return status;
     }
   }
 
@@ -403,7 +553,11 @@ const Status Index::matchRec(const Bucket* bucket,
 			     const void* value, 
 			     const int offset) 
 {
-  const char* tmp = &(bucket->data[offset*recSize]);
+  const char* tmp = slotKey(bucket, offset);
+
+  // composite keys are normalized, so equal keys have equal bytes
+  if (headerPage->keyCnt > 1)
+    return memcmp(value, tmp, headerPage->length) ? RECNOTFOUND : OK;
 
   switch(headerPage->type) {
   case INTEGER:
@@ -444,7 +598,7 @@ void Index::printBucs() {
       cout << "error dumping indices"<<endl;
     else {
       for (int j = 0; j < bucket->slotCnt; j++)
-	cout << *(int*)&(bucket->data[j*recSize]) << "\t";
+	cout << *(int*)slotKey(bucket, j) << "\t";
       cout << endl;
     }
     status = bufMgr->unPinPage(file, pageNo, false);
@@ -452,6 +606,112 @@ void Index::printBucs() {
 }
 #endif 
 
+// Position of the key and of the rest of the entry in 'slot'. The keys
+// of all numSlots slots come first, then the <rid, included attributes>
+// parts, so a bucket holds exactly as many entries as before.
+
+const char* Index::slotKey(const Bucket* bucket, const int slot) const
+{
+  return &(bucket->data[slot * headerPage->length]);
+}
+
+const char* Index::slotRest(const Bucket* bucket, const int slot) const
+{
+  return &(bucket->data[numSlots * headerPage->length 
+			+ slot * (recSize - headerPage->length)]);
+}
+
+void Index::getSlot(const Bucket* bucket, const int slot, char* entry) const
+{
+  memcpy(entry, slotKey(bucket, slot), headerPage->length);
+  memcpy(entry + headerPage->length, slotRest(bucket, slot), 
+	 recSize - headerPage->length);
+}
+
+void Index::putSlot(Bucket* bucket, const int slot, const char* entry) const
+{
+  memcpy((char *)slotKey(bucket, slot), entry, headerPage->length);
+  memcpy((char *)slotRest(bucket, slot), entry + headerPage->length, 
+	 recSize - headerPage->length);
+}
+
+// Return the first slot at or after 'slot' whose key equals 'value'.
+// INTEGER and DOUBLE keys are compared 16/8 (AVX-512), 8/4 (AVX2) or
+// 4/2 (SSE2) at a time, depending on what the compiler targets; the
+// remaining slots and the other key types go through matchRec.
+
+int Index::nextMatch(const Bucket* bucket, const void* value, int slot)
+{
+  const int slotCnt = bucket->slotCnt;
+
+  if (headerPage->keyCnt == 1 && headerPage->type == INTEGER) {
+    int key;
+    memcpy(&key, value, sizeof(int));
+    const char* keys = slotKey(bucket, 0);
+
+#if defined(__AVX512F__)
+    const __m512i v16 = _mm512_set1_epi32(key);
+    for (; slot + 16 <= slotCnt; slot += 16) {
+      __m512i k = _mm512_loadu_si512((const void *)(keys + slot * sizeof(int)));
+      unsigned int mask = _mm512_cmpeq_epi32_mask(k, v16);
+      if (mask) return slot + __builtin_ctz(mask);
+    }
+#endif
+#if defined(__AVX2__)
+    const __m256i v8 = _mm256_set1_epi32(key);
+    for (; slot + 8 <= slotCnt; slot += 8) {
+      __m256i k = _mm256_loadu_si256((const __m256i *)(keys + slot * sizeof(int)));
+      int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(k, v8)));
+      if (mask) return slot + __builtin_ctz(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i v4 = _mm_set1_epi32(key);
+    for (; slot + 4 <= slotCnt; slot += 4) {
+      __m128i k = _mm_loadu_si128((const __m128i *)(keys + slot * sizeof(int)));
+      int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(k, v4)));
+      if (mask) return slot + __builtin_ctz(mask);
+    }
+#endif
+  }
+  else if (headerPage->keyCnt == 1 && headerPage->type == DOUBLE) {
+    double key;
+    memcpy(&key, value, sizeof(double));
+    const char* keys = slotKey(bucket, 0);
+
+#if defined(__AVX512F__)
+    const __m512d v8 = _mm512_set1_pd(key);
+    for (; slot + 8 <= slotCnt; slot += 8) {
+      __m512d k = _mm512_loadu_pd(keys + slot * sizeof(double));
+      unsigned int mask = _mm512_cmp_pd_mask(k, v8, _CMP_EQ_OQ);
+      if (mask) return slot + __builtin_ctz(mask);
+    }
+#endif
+#if defined(__AVX2__)
+    const __m256d v4 = _mm256_set1_pd(key);
+    for (; slot + 4 <= slotCnt; slot += 4) {
+      __m256d k = _mm256_loadu_pd((const double *)(keys + slot * sizeof(double)));
+      int mask = _mm256_movemask_pd(_mm256_cmp_pd(k, v4, _CMP_EQ_OQ));
+      if (mask) return slot + __builtin_ctz(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128d v2 = _mm_set1_pd(key);
+    for (; slot + 2 <= slotCnt; slot += 2) {
+      __m128d k = _mm_loadu_pd((const double *)(keys + slot * sizeof(double)));
+      int mask = _mm_movemask_pd(_mm_cmpeq_pd(k, v2));
+      if (mask) return slot + __builtin_ctz(mask);
+    }
+#endif
+  }
+
+  // scalar fallback (and the tail of the SIMD loops)
+  for (; slot < slotCnt; slot++)
+    if (matchRec(bucket, value, slot) == OK)
+      return slot;
+  return slotCnt;
+}
+
 // start a scan of the entries with attribute 'value'. return SCANTABFULL
 // if too many scans are open at the same time
 
@@ -487,21 +747,135 @@ const Status Index::scanNext(RID& outRid)
   Bucket* buc = curBuc;
   const void* value = curValue;
 
-  while (offset < buc->slotCnt) {
-    if (matchRec(buc, value, offset) == OK)
-      break;
-    offset++;
-  }
+  offset = nextMatch(buc, value, offset);
 
   if (offset == buc->slotCnt)
     return NOMORERECS;
   else {
-    outRid = *(RID *)&(buc->data[offset*recSize + headerPage->length]);
+    memcpy(&outRid, slotRest(buc, offset), sizeof(RID));
     offset++;
     return OK;
   }
 }
 
+// return the next entry with attribute 'value' and copy the key and the
+// included attributes of the entry into their places in 'tuple'.
+
+const Status Index::scanNext(RID& outRid, char* tuple) 
+{
+  Status status = scanNext(outRid);
+  if (status != OK)
+    return status;
+
+  const char* entry = slotRest(curBuc, curOffset - 1);
+  int entryOffset = sizeof(RID);
+
+  // a composite key is stored normalized and is not copied back
+  if (headerPage->keyCnt == 1)
+    memcpy(tuple + headerPage->offset, slotKey(curBuc, curOffset - 1),
+	   headerPage->length);
+  for (int i = 0; i < headerPage->includeCnt; i++) {
+    memcpy(tuple + headerPage->includeOffset[i], entry + entryOffset,
+	   headerPage->includeLength[i]);
+    entryOffset += headerPage->includeLength[i];
+  }
+
+  return OK;
+}
+
+// return true if the attribute at (offset, length) of the relation is
+// the key or one of the included attributes of the index entries.
+
+const bool Index::covers(const int offset, const int length) const
+{
+  if (headerPage->keyCnt == 1 &&
+      offset == headerPage->offset && length == headerPage->length)
+    return true;
+
+  for (int i = 0; i < headerPage->includeCnt; i++)
+    if (offset == headerPage->includeOffset[i] 
+	&& length == headerPage->includeLength[i])
+      return true;
+
+  return false;
+}
+
+// return the number of bytes of a record that hold the key and all
+// the included attributes, i.e. the size of the tuple that scanNext fills.
+
+const int Index::coveredLength() const
+{
+  int len = 0;
+
+  if (headerPage->keyCnt == 1)
+    len = headerPage->offset + headerPage->length;
+
+  for (int i = 0; i < headerPage->includeCnt; i++)
+    len = MAX(len, headerPage->includeOffset[i] + headerPage->includeLength[i]);
+
+  return len;
+}
+
+void Index::getIncludes(int & includeCnt,
+			int includeOffset[],
+			int includeLength[]) const
+{
+  includeCnt = headerPage->includeCnt;
+  for (int i = 0; i < includeCnt; i++) {
+    includeOffset[i] = headerPage->includeOffset[i];
+    includeLength[i] = headerPage->includeLength[i];
+  }
+}
+
+// Build the index key of a record: the key attribute itself, or the
+// concatenated normalized key attributes of a composite index.
+
+void Index::makeKey(const char* tuple, char* key) const
+{
+  const void* values[MAXKEYATTRS];
+
+  for (int i = 0; i < headerPage->keyCnt; i++)
+    values[i] = tuple + headerPage->keyOffset[i];
+  makeKey(values, key);
+}
+
+// Build the index key from one value per key attribute (in key order).
+
+void Index::makeKey(const void* const values[], char* key) const
+{
+  if (headerPage->keyCnt == 1) {
+    memcpy(key, values[0], headerPage->length);
+    return;
+  }
+
+  int keyOffset = 0;
+  for (int i = 0; i < headerPage->keyCnt; i++) {
+    normalizeKey((const char *)values[i], (Datatype)headerPage->keyType[i],
+		 headerPage->keyLength[i], (unsigned char *)key + keyOffset);
+    keyOffset += headerPage->keyLength[i];
+  }
+}
+
+// Id of the relation file the index was built from, and version of
+// the relation the index is known to be consistent with (see
+// HeapFile::getFileId and HeapFile::getVersion). An index is only in
+// step with the relation if both match.
+
+const int Index::getRelFileId() const
+{
+  return headerPage->relFileId;
+}
+
+const int Index::getRelVersion() const
+{
+  return headerPage->relVersion;
+}
+
+void Index::setRelVersion(const int version)
+{
+  headerPage->relVersion = version;
+}
+
 // unpin the bucket and clear the scan table entry.
 const Status Index::endScan() 
 {
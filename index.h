@@ -4,7 +4,11 @@
 #include "heapfile.h"
 extern DB db;
 
-const int DIRSIZE = PAGESIZE - MAXNAMESIZE - 3*sizeof(int) - sizeof(Datatype);
+const int MAXINCLUDE = 4;   // max. # of attributes an index entry can carry besides the key
+const int MAXKEYATTRS = 4;  // max. # of attributes in a composite key
+const int DIRSIZE = (PAGESIZE - MAXNAMESIZE - 8*sizeof(int) - sizeof(Datatype)
+                     - 2*MAXINCLUDE*sizeof(short)
+                     - 3*MAXKEYATTRS*sizeof(short)) / sizeof(short);
 const int UNIQUE  = 1;
 const int NONUNIQUE = 0;
 
@@ -20,16 +24,26 @@ const int NONUNIQUE = 0;
 
 # else /* Using a hash index */
 
+// The header page of an index file. The fixed fields are laid out so that
+// the directory fills the rest of the page exactly (DIRSIZE entries).
 struct iHeaderPage
 {
-    char          fileName[MAXNAMESIZE];  // name of file
     int           offset;             // byte offset of the indexed attribute 
-    int           length;             // length of the attribute
+    int           length;             // length of the attribute (of the whole key)
     Datatype      type;               // datatype of the attribute
     int           depth;              // depth of the directory
     int           unique;             // enforce uniqueness on inserts
-    short         dir[1];         
-    char          data[DIRSIZE - 1];
+    int           relFileId;          // id of the relation file indexed
+    int           relVersion;         // relation version the entries reflect
+    int           keyCnt;             // # of attributes in the key
+    short         keyOffset[MAXKEYATTRS];    // offsets of the key attributes
+    short         keyLength[MAXKEYATTRS];    // lengths of the key attributes
+    short         keyType[MAXKEYATTRS];      // types of the key attributes
+    int           includeCnt;         // # of attributes included in the entries
+    short         includeOffset[MAXINCLUDE]; // offsets of the included attributes
+    short         includeLength[MAXINCLUDE]; // lengths of the included attributes
+    char          fileName[MAXNAMESIZE];  // name of file
+    short         dir[DIRSIZE];       // the directory of bucket page numbers
 };
 
 struct Bucket {
@@ -57,6 +71,31 @@ class Index {
 
   const Status hashIndex(const void *value, int& hashvalue);
 
+  // The entries of a bucket are stored as two arrays: the keys of all
+  // the slots, followed by the <rid, included attributes> parts of all
+  // the slots. Keeping the keys together lets a probe compare several
+  // INTEGER or DOUBLE keys with one SIMD instruction.
+  const char* slotKey(const Bucket* bucket, const int slot) const;
+  const char* slotRest(const Bucket* bucket, const int slot) const;
+
+  // copy the entry in 'slot' out of / into a bucket as one contiguous
+  // <key, rid, included attributes> record of recSize bytes
+  void getSlot(const Bucket* bucket, const int slot, char* entry) const;
+  void putSlot(Bucket* bucket, const int slot, const char* entry) const;
+
+  // return the first slot >= 'slot' whose key equals 'value', or
+  // bucket->slotCnt if there is none
+  int nextMatch(const Bucket* bucket, const void* value, int slot);
+
+  // open or build the index; shared by the constructors
+  void init(const string & name, const int keyCnt, const int keyOffset[],
+	    const int keyLength[], const Datatype keyType[], const int unique,
+	    const int includeCnt, const int includeOffset[],
+	    const int includeLength[], Status& status);
+
+  // insert a complete <key, rid, included attributes> entry
+  const Status insertRaw(const char* entry);
+
  public:
   Index(const string & name,// name of the relation being indexed
 	const int offset,   // offset of the attribute being indexed 
@@ -65,19 +104,78 @@ class Index {
 	const int unique,   // =1 if the index should only allow unique entries.
 	Status& status);    // return error codes
 
+  // Create a covering index: every entry also stores a copy of the
+  // attributes given by includeOffset/includeLength, so queries that only
+  // need those attributes can be answered without reading the relation.
+  // If the index already exists it is opened as is.
+  Index(const string & name,      // name of the relation being indexed
+	const int offset,         // offset of the attribute being indexed
+	const int length,         // length of the attribute being indexed
+	const Datatype type,      // type of the attribute being indexed
+	const int unique,         // =1 if the index should only allow unique entries.
+	const int includeCnt,     // # of included attributes (<= MAXINCLUDE)
+	const int includeOffset[],// offsets of the included attributes
+	const int includeLength[],// lengths of the included attributes
+	Status& status);          // return error codes
+
+  // Create a composite index whose key is the concatenation of several
+  // attributes. The index file is named after the relation and the offsets
+  // of all the key attributes.
+  Index(const string & name,      // name of the relation being indexed
+	const int keyCnt,         // # of key attributes (<= MAXKEYATTRS)
+	const int keyOffset[],    // offsets of the key attributes
+	const int keyLength[],    // lengths of the key attributes
+	const Datatype keyType[], // types of the key attributes
+	const int unique,         // =1 if the index should only allow unique entries.
+	Status& status);          // return error codes
+
   ~Index();
 
+  // build the key of the record 'tuple' into 'key' (the attribute value,
+  // or the concatenated normalized values for a composite index)
+  void makeKey(const char* tuple, char* key) const;
+
+  // build a key from one value per key attribute, in key order
+  void makeKey(const void* const values[], char* key) const;
+
+  // id of the relation file the index was built from, and the version
+  // of the relation the index was last brought up to date with
+  const int getRelFileId() const;
+  const int getRelVersion() const;
+  void setRelVersion(const int version);
+
   // insert an entry into the index. value should point to the index key (attribute)
+  // For a covering index the included attributes are read from the relation.
   const Status insertEntry(const void* value, RID rid);
 
+  // insert an entry into the index, taking the included attributes from rec
+  const Status insertEntry(const void* value, RID rid, const Record & rec);
+
   // delete an entry from the index. value should point to the index key (attribute)
   const Status deleteEntry(const void* value, const RID & rid);
   
   // initiate a indexed scan
   const Status startScan(const void* value);
   const Status scanNext(RID& outRid); // return next entry
+
+  // return next entry and copy the key and the included attributes into
+  // their positions in tuple, a buffer laid out like a record of the relation
+  // (at least coveredLength() bytes long)
+  const Status scanNext(RID& outRid, char* tuple);
   const Status endScan();      // end scan
 
+  // true if the attribute at (offset, length) is stored in the index entries
+  const bool covers(const int offset, const int length) const;
+
+  // size of the tuple buffer scanNext(outRid, tuple) fills in
+  const int coveredLength() const;
+
+  // the attributes included in the entries (at most MAXINCLUDE), so
+  // that the index can be built again the same way
+  void getIncludes(int & includeCnt,
+		   int includeOffset[],
+		   int includeLength[]) const;
+
 #ifdef DEBUGIND
   void printDir();
   void printBucs();
@@ -0,0 +1,328 @@
+#include <sstream>
+#include <cstring>
+#include <vector>
+#include "catalog.h"
+#include "index.h"
+
+/*
+ * Creates a covering index on attrName of relation rName. Every index
+ * entry stores, next to the key and the RID, a copy of the attributes
+ * listed in includeNames. The index file is built here and then
+ * registered in the catalogs through the regular addIndex, which finds
+ * the file already in place.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise
+ */
+const Status RelCatalog::addIndex(const string & rName,
+				  const string & attrName,
+				  const int includeCnt,
+				  const string includeNames[])
+{
+	Status status;
+	AttrDesc attrDesc;
+
+	if(rName.empty() || attrName.empty()) return BADCATPARM;
+	if(includeCnt < 0 || includeCnt > MAXINCLUDE) return BADCATPARM;
+
+	status = attrCat->getInfo(rName, attrName, attrDesc);
+	if(status != OK) return status;
+	if(attrDesc.indexed) return INDEXEXISTS;
+
+	// look up the included attributes
+	int includeOffset[MAXINCLUDE];
+	int includeLength[MAXINCLUDE];
+	for(int i = 0; i < includeCnt; i ++){
+		AttrDesc includeDesc;
+		status = attrCat->getInfo(rName, includeNames[i], includeDesc);
+		if(status != OK) return status;
+
+		includeOffset[i] = includeDesc.attrOffset;
+		includeLength[i] = includeDesc.attrLen;
+	}
+
+	// build the index file with the included attributes
+	{
+		Index index(rName, attrDesc.attrOffset, attrDesc.attrLen,
+			    static_cast<Datatype>(attrDesc.attrType), NONUNIQUE,
+			    includeCnt, includeOffset, includeLength, status);
+		if(status != OK) return status;
+	}
+
+	// and mark the attribute as indexed in the catalogs
+	return addIndex(rName, attrName);
+}
+
+
+/*
+ * Help function:
+ * 	name of the file of a composite index: the relation name followed
+ * 	by the offsets of the key attributes (the naming used by Index).
+ */
+static string compIndexFileName(const string & rName,
+				const int keyCnt,
+				const int keyOffset[])
+{
+	ostringstream outputString;
+	outputString << rName;
+	for(int i = 0; i < keyCnt; i ++)
+		outputString << '.' << keyOffset[i];
+	outputString << ends;
+	return outputString.str();
+}
+
+
+/*
+ * Opens the composite index catalog. The catalog file is created the
+ * first time it is opened.
+ */
+CompIndexCatalog::CompIndexCatalog(Status &status) :
+	HeapFileScan(COMPCATNAME, status)
+{
+}
+
+
+CompIndexCatalog::~CompIndexCatalog()
+{
+}
+
+
+/*
+ * Returns the composite indexes defined on relation rName. The array
+ * is allocated here and must be deleted by the caller.
+ *
+ * Returns:
+ * 	OK on success (indexCnt may be 0)
+ * 	an error code otherwise
+ */
+const Status CompIndexCatalog::getRelInfo(const string & rName,
+					  int &indexCnt,
+					  CompIndexDesc *&indexes)
+{
+	Status status;
+	RID rid;
+	Record rec;
+	vector<CompIndexDesc> found;
+
+	indexCnt = 0;
+	indexes = NULL;
+	if(rName.empty()) return BADCATPARM;
+
+	status = startScan(0, MAXNAME, STRING, rName.c_str(), EQ);
+	if(status != OK) return status;
+
+	while(scanNext(rid, rec) == OK){
+		CompIndexDesc desc;
+		memcpy(&desc, rec.data, sizeof(CompIndexDesc));
+		found.push_back(desc);
+	}
+
+	status = endScan();
+	if(status != OK) return status;
+
+	indexCnt = found.size();
+	if(indexCnt > 0){
+		indexes = new CompIndexDesc[indexCnt];
+		for(int i = 0; i < indexCnt; i ++)
+			indexes[i] = found[i];
+	}
+	return OK;
+}
+
+
+/*
+ * Looks up the offsets, lengths and types of the key attributes of a
+ * composite index in the attribute catalog.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise (e.g. the attribute no longer exists)
+ */
+const Status CompIndexCatalog::getKeyInfo(const CompIndexDesc & index,
+					  int keyOffset[],
+					  int keyLength[],
+					  Datatype keyType[])
+{
+	Status status;
+
+	for(int i = 0; i < index.keyCnt; i ++){
+		AttrDesc attrDesc;
+		status = attrCat->getInfo(index.relName, index.attrName[i], attrDesc);
+		if(status != OK) return status;
+
+		keyOffset[i] = attrDesc.attrOffset;
+		keyLength[i] = attrDesc.attrLen;
+		keyType[i] = static_cast<Datatype>(attrDesc.attrType);
+	}
+	return OK;
+}
+
+
+/*
+ * Creates a composite index on the attributes attrNames (in key order)
+ * of relation rName, builds it and records it in the catalog.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise
+ */
+const Status CompIndexCatalog::addIndex(const string & rName,
+					const int keyCnt,
+					const string attrNames[])
+{
+	Status status;
+	CompIndexDesc desc;
+
+	if(rName.empty() || rName.length() >= MAXNAME) return BADCATPARM;
+	if(keyCnt < 2 || keyCnt > MAXKEYATTRS) return BADCATPARM;
+
+	memset(&desc, 0, sizeof(CompIndexDesc));
+	strcpy(desc.relName, rName.c_str());
+	desc.keyCnt = keyCnt;
+	for(int i = 0; i < keyCnt; i ++){
+		if(attrNames[i].empty() || attrNames[i].length() >= MAXNAME) return BADCATPARM;
+		strcpy(desc.attrName[i], attrNames[i].c_str());
+	}
+
+	// refuse a second index on the same key
+	int indexCnt;
+	CompIndexDesc *indexes;
+	status = getRelInfo(rName, indexCnt, indexes);
+	if(status != OK) return status;
+	for(int i = 0; i < indexCnt; i ++){
+		if(!memcmp(&indexes[i], &desc, sizeof(CompIndexDesc))){
+			delete []indexes;
+			return INDEXEXISTS;
+		}
+	}
+	delete []indexes;
+
+	// build the index file
+	int keyOffset[MAXKEYATTRS];
+	int keyLength[MAXKEYATTRS];
+	Datatype keyType[MAXKEYATTRS];
+	status = getKeyInfo(desc, keyOffset, keyLength, keyType);
+	if(status != OK) return status;
+
+	{
+		Index index(rName, keyCnt, keyOffset, keyLength, keyType, NONUNIQUE, status);
+		if(status != OK) return status;
+	}
+
+	// inserts into the relation maintain its composite indexes from now on
+	{
+		HeapFile hf(rName, status);
+		if(status != OK) return status;
+		hf.addCatalogFlags(COMPINDEXFLAG);
+	}
+
+	// and record it in the catalog
+	RID rid;
+	Record rec = {&desc, sizeof(CompIndexDesc)};
+	return insertRecord(rec, rid);
+}
+
+
+/*
+ * Drops the composite index on the attributes attrNames of relation
+ * rName: the index file is destroyed and the catalog entry removed.
+ *
+ * Returns:
+ * 	OK on success
+ * 	BADCATPARM if there is no such index
+ * 	an error code otherwise
+ */
+const Status CompIndexCatalog::dropIndex(const string & rName,
+					 const int keyCnt,
+					 const string attrNames[])
+{
+	Status status;
+	RID rid;
+	Record rec;
+	bool found = false;
+
+	if(rName.empty()) return BADCATPARM;
+
+	status = startScan(0, MAXNAME, STRING, rName.c_str(), EQ);
+	if(status != OK) return status;
+
+	while(!found && scanNext(rid, rec) == OK){
+		CompIndexDesc *desc = (CompIndexDesc *)rec.data;
+		found = (desc->keyCnt == keyCnt);
+		for(int i = 0; found && i < keyCnt; i ++)
+			found = (attrNames[i] == desc->attrName[i]);
+	}
+
+	status = endScan();
+	if(status != OK) return status;
+	if(!found) return BADCATPARM;
+
+	CompIndexDesc desc;
+	memcpy(&desc, rec.data, sizeof(CompIndexDesc));
+	status = deleteRecord(rid);
+	if(status != OK) return status;
+
+	int keyOffset[MAXKEYATTRS];
+	int keyLength[MAXKEYATTRS];
+	Datatype keyType[MAXKEYATTRS];
+	status = getKeyInfo(desc, keyOffset, keyLength, keyType);
+	if(status != OK) return status;
+
+	return db.destroyFile(compIndexFileName(rName, keyCnt, keyOffset));
+}
+
+
+/*
+ * Opens a composite index for a query. Inserts through Updates::Insert
+ * keep the index up to date; anything else that changes the relation
+ * (loads, deletes) leaves the index behind the relation version, and in
+ * that case the index is dropped and built again from the relation. So
+ * is an index left over from an earlier relation of the same name.
+ *
+ * Returns:
+ * 	OK on success (indexPtr must be deleted by the caller)
+ * 	an error code otherwise
+ */
+const Status CompIndexCatalog::openIndex(const CompIndexDesc & index,
+					 Index *&indexPtr)
+{
+	Status status;
+	int keyOffset[MAXKEYATTRS];
+	int keyLength[MAXKEYATTRS];
+	Datatype keyType[MAXKEYATTRS];
+
+	indexPtr = NULL;
+	status = getKeyInfo(index, keyOffset, keyLength, keyType);
+	if(status != OK) return status;
+
+	int fileId, version;
+	{
+		HeapFile hf(index.relName, status);
+		if(status != OK) return status;
+		fileId = hf.getFileId();
+		version = hf.getVersion();
+	}
+
+	indexPtr = new Index(index.relName, index.keyCnt, keyOffset, keyLength,
+			     keyType, NONUNIQUE, status);
+	if(status == OK && indexPtr->getRelFileId() == fileId
+	   && indexPtr->getRelVersion() == version)
+		return OK;
+
+	delete indexPtr;
+	indexPtr = NULL;
+	if(status != OK) return status;
+
+	// the index is stale: rebuild it
+	status = db.destroyFile(compIndexFileName(index.relName, index.keyCnt, keyOffset));
+	if(status != OK) return status;
+
+	indexPtr = new Index(index.relName, index.keyCnt, keyOffset, keyLength,
+			     keyType, NONUNIQUE, status);
+	if(status != OK){
+		delete indexPtr;
+		indexPtr = NULL;
+	}
+	return status;
+}
@@ -1,77 +1,172 @@
 #include "catalog.h"
 #include "query.h"
 #include "index.h"
+#include "projection.h"
+#include <algorithm>
 #include <cstring>
 
 
+/*
+ * Help function:
+ * 	probe the index and collect the RIDs of all the matching entries.
+ * 	The RIDs are sorted in page order, so a following fetch visits every
+ * 	heap page once and in file order instead of in hash bucket order;
+ * 	with sorted false they are left in the order of the entries.
+ *
+ * Return:
+ * 	OK if success
+ * 	Error code otherwise
+ */
+Status Operators::CollectRIDs(Index &index,               // Index to probe
+			      const void *attrValue,      // The value to look up
+			      vector<RID> &rids,          // The resulting (sorted) RID list
+			      int &pageCnt,               // # of distinct heap pages in the list
+			      const bool sorted)          // Sort the list in page order
+{
+	Status status;
+	RID outRid;
+
+	rids.clear();
+	pageCnt = 0;
+
+	status = index.startScan(attrValue);
+	if(status != OK) return status;
+
+	while(index.scanNext(outRid) == OK){
+		rids.push_back(outRid);
+	}
+
+	status = index.endScan();
+	if(status != OK) return status;
+
+	if(sorted) sort(rids.begin(), rids.end());
+
+	for(unsigned int i = 0; i < rids.size(); i ++){
+		if(i == 0 || rids[i].pageNo != rids[i - 1].pageNo)
+			pageCnt ++;
+	}
+
+	return OK;
+}
+
+
 Status Operators::IndexSelect(const string& result,       // Name of the output relation
                               const int projCnt,          // Number of attributes in the projection
                               const AttrDesc projNames[], // Projection list (as AttrDesc)
                               const AttrDesc* attrDesc,   // Attribute in the selection predicate
                               const Operator op,          // Predicate operator
                               const void* attrValue,      // Pointer to the literal value in the predicate
-                              const int reclen)           // Length of a tuple in the output relation
+                              const int reclen,           // Length of a tuple in the output relation
+                              const bool bitmap)          // Fetch the tuples in page order
 {
-  	cout << "Algorithm: Index Select" << endl;
-
 	Status status;
-	
-	// create open the heap file which stores the resulting data
-	HeapFile hf(result, status);
-	if(status != OK) {
-		cerr << "Open heap file for storing the results of the index scan failed!" << endl;
-		return status;
-	}
 
-	// open the index file 	
+	// open the index file
 	string relName(projNames[0].relName);
 	const int offset = attrDesc->attrOffset;
 	const int length = attrDesc->attrLen;
 	const Datatype type = static_cast<Datatype>(attrDesc->attrType);
 	const int unique = 0;
-	
+
 	Index iscan(relName, offset, length, type, unique, status);
 	if(status != OK){
 		return status;
 	}
 
-	// start the index scan 
-	// insert the results into the opened result heap file
+	// If every projected attribute is stored in the index entries,
+	// the query is answered from the index without reading the relation
+	bool covered = true;
+	for(int i = 0; i < projCnt; i ++){
+		if(!iscan.covers(projNames[i].attrOffset, projNames[i].attrLen))
+			covered = false;
+	}
+	if(covered){
+		return Operators::IndexOnlySelect(result, projCnt, projNames, iscan, attrValue, reclen);
+	}
+
+	// Phase 1: collect the matching RIDs from the index, sorted by page
+	// for a bitmap fetch
+	vector<RID> rids;
+	int pageCnt;
+	status = Operators::CollectRIDs(iscan, attrValue, rids, pageCnt, bitmap);
+	if(status != OK) return status;
+
 	HeapFileScan hfs(relName, status);   // we need the hfs object to access the getRecord() function
 	if(status != OK) return status;
 
-	RID outRid;
-	Record rec;
+	// If the matches are spread over most of the relation, reading the
+	// pages in sequence is cheaper than fetching them one by one
+	if(pageCnt > BITMAP_SCAN_THRESHOLD * hfs.getPageCnt()){
+		return Operators::ScanSelect(result, projCnt, projNames, attrDesc, op, attrValue, reclen);
+	}
 
-	status = iscan.startScan(attrValue);
-	while(iscan.scanNext(outRid) == OK){
-		hfs.getRandomRecord(outRid, rec);
-	
-		int tempOffset = 0;
-
-		char* result = new char[reclen + 1];
-		result[reclen] = '\0';
-
-		for(int i = 0; i < projCnt; i ++){
-			char* sou = (char*)rec.data + projNames[i].attrOffset;
-			char* des = &(result[tempOffset]);
-			memcpy(des, sou, projNames[i].attrLen);
-		
-			tempOffset += projNames[i].attrLen;
-		}
+	if(bitmap)
+  		cout << "Algorithm: Bitmap Index Select" << endl;
+	else
+  		cout << "Algorithm: Index Select" << endl;
 
-		RID _outRid;
-		Record _rec = {result, reclen};
-		status = hf.insertRecord(_rec, _outRid);
+	// create open the heap file which stores the resulting data
+	HeapFile hf(result, status);
+	if(status != OK) {
+		cerr << "Open heap file for storing the results of the index scan failed!" << endl;
+		return status;
+	}
 
-		delete []result;
-		result = NULL;
+	// Phase 2: fetch the records (in page order for a bitmap fetch)
+	// insert the results into the opened result heap file
+	Record rec;
+	Projection proj(projCnt, projNames, reclen);
+
+	for(unsigned int r = 0; r < rids.size(); r ++){
+		status = hfs.getRandomRecord(rids[r], rec);
+		if(status != OK) return status;
 
+		status = proj.insert(hf, rec.data);
 		if(status != OK){
 			return status;
 		}
 	}
-	
-	status = iscan.endScan();
-  	return status;
+
+  	return hfs.endScan();
+}
+
+
+/*
+ * Select using only the entries of a covering index: the key and the
+ * included attributes of each matching entry are copied into a tuple
+ * buffer and the projection is taken from there.
+ */
+Status Operators::IndexOnlySelect(const string& result,       // Name of the output relation
+				  const int projCnt,          // Number of attributes in the projection
+				  const AttrDesc projNames[], // Projection list (as AttrDesc)
+				  Index &iscan,               // The covering index
+				  const void* attrValue,      // Pointer to the literal value in the predicate
+				  const int reclen)           // Length of a tuple in the output relation
+{
+  	cout << "Algorithm: Index Only Select" << endl;
+
+	Status status;
+
+	HeapFile hf(result, status);
+	if(status != OK) {
+		cerr << "Open heap file for storing the results of the index scan failed!" << endl;
+		return status;
+	}
+
+	char* tuple = new char[iscan.coveredLength()];
+	Projection proj(projCnt, projNames, reclen);
+	RID outRid;
+
+	status = iscan.startScan(attrValue);
+	while(status == OK && iscan.scanNext(outRid, tuple) == OK){
+		status = proj.insert(hf, tuple);
+	}
+
+	delete []tuple;
+
+	if(status != OK){
+		iscan.endScan();
+		return status;
+	}
+	return iscan.endScan();
 }
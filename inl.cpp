@@ -2,12 +2,30 @@
 #include "query.h"
 #include "sort.h"
 #include "index.h"
+#include "projection.h"
+#include "exec.h"
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
-/* 
- * Indexed nested loop evaluates joins with an index on the 
- * inner/right relation (attrDesc2)
+int calTupleLength(const AttrDesc &attrDesc);
+
+// A probe result: the RID of a matching inner tuple and the offset of the
+// outer tuple (in the in-memory batch) that it joins with.
+typedef struct {
+  RID rid;                              // RID of the matching inner tuple
+  int outer;                            // offset of the outer tuple in the batch
+} PROBEREC;
+
+static bool probecmp(const PROBEREC &p1, const PROBEREC &p2)
+{
+  return p1.rid < p2.rid;
+}
+
+/*
+ * Indexed nested loop evaluates joins with an index on the
+ * inner/right relation (attrDesc2). Without a hash index on the inner
+ * attribute, its adaptive index (adaptive.h) is probed instead.
  */
 
 Status Operators::INL(const string& result,           // Name of the output relation
@@ -23,66 +41,174 @@ Status Operators::INL(const string& result,           // Name of the output rela
 	Status status;
 	string relName1 = attrDesc1.relName;
 	string relName2 = attrDesc2.relName;
-	
+
+	if(attrDesc2.indexed != 1){
+		vector<AttrDesc> layout(projCnt);
+		JoinLayout(relName1, calTupleLength(attrDesc1), projCnt, attrDescArray, &layout[0]);
+
+		Iterator *join = new INLJoinIter(new ScanIter(relName1), attrDesc1, attrDesc2);
+		ProjectIter plan(join, projCnt, &layout[0], reclen);
+
+		cout << "Adaptive index: probed on " << relName2 << "." << attrDesc2.attrName << endl;
+		return Operators::Drain(plan, result);
+	}
+
 	// open the heap file for storing the resulting data
 	HeapFile result_hf(result, status);
 	if(status != OK){
 		cerr << "Open heap file for storing the results of INL join failed!" << endl;
 		return status;
 	}
-	
+
+	// the projection list, compiled once for all the result tuples
+	Projection proj(relName1, projCnt, attrDescArray, reclen);
+
 	// open the heap file for the outer relation
 	HeapFileScan hfs(relName1, status);
 	if(status != OK)   { 	return status;	}
-	
-	// Indexed-nested loops join: R is the outer relation, 
+
+	// Open the inner relation and its index once for the whole join.
+	// We need the inner HeapFileScan object to access the getRandomRecord() function
+	HeapFileScan inner_hfs(relName2, status);
+	if(status != OK) {	return status;   }
+
+	const Datatype type = static_cast<Datatype>(attrDesc2.attrType);
+	Index iscan(relName2, attrDesc2.attrOffset, attrDesc2.attrLen, type, 0, status);
+	if(status != OK)   { 	return status;	}
+
+	// If the index entries carry every projected attribute of the inner
+	// relation, the matches are answered from the index alone
+	bool covered = true;
+	for(int i = 0; i < projCnt; i ++){
+		if(relName2 != attrDescArray[i].relName) continue;
+		if(!iscan.covers(attrDescArray[i].attrOffset, attrDescArray[i].attrLen))
+			covered = false;
+	}
+	const int innerLen = iscan.coveredLength();
+	vector<char> innerTuple(innerLen);
+
+	// Semi-join reduction: if the inner relation is the smaller one, a Bloom
+	// filter over its join keys drops the outer tuples without a match
+	// before the index is probed for them
+	const int outerCnt = hfs.getRecCnt();
+	const int innerCnt = inner_hfs.getRecCnt();
+	const bool useFilter = innerCnt < outerCnt && SemiJoinApplies(attrDesc1, attrDesc2, true);
+	BloomFilter filter(useFilter ? innerCnt : 0, type, attrDesc2.attrLen);
+	if(useFilter){
+		status = BuildBloomFilter(attrDesc2, filter);
+		if(status != OK) return status;
+	}
+
+	// The outer tuples are processed in batches that fit into the unpinned
+	// part of the buffer pool (the same budget SMJ uses for its sort runs)
+	const unsigned int batchBytes = bufMgr->numUnpinnedPages() * 0.8 * PAGESIZE;
+
+	// Indexed-nested loops join: R is the outer relation,
 	//                            S is the inner relation
-	// 
+	//
 	// Algorithm:
-	// for each tuple r in R do                  
-	// 	Probe Index on S
-	//		for each matching tuple s do add <r, s> to the result heap file
+	// for each batch of tuples in R do
+	// 	for each tuple r in the batch do
+	//		Probe Index on S and remember <rid of s, r>
+	//	sort the probe results by the rid of s
+	//	for each matching tuple s (in page order) do add <r, s> to the result heap file
 	RID rid1, rid2;
 	Record rec1, rec2;
-	
-	// loop through the outer relation
-	while(hfs.scanNext(rid1, rec1) == OK){
-		//first get the desired attrbute value		
-	    	void* rec1_data = rec1.data;
-		int attrLen = attrDesc1.attrLen;
-		char* attrValue = new char[attrLen + 1];
-		attrValue[attrLen] = '\0';
-
-		memcpy(attrValue, (char*)rec1_data + attrDesc1.attrOffset, attrLen);
-		
-		// Create anohter HeapFileScan object for the inner relation, 
-		// We need use this object to access the getRandomRecord() function to get the record data
-		HeapFileScan inner_hfs(relName2, status);
-		if(status != OK) {	return status;   }
-
-		// open the indexed file for the inner relation
-		const Datatype type = static_cast<Datatype>(attrDesc2.attrType);
-		Index iscan(relName2, attrDesc2.attrOffset, attrDesc2.attrLen, type, 0, status);
-		if(status != OK)   { 	return status;	}
-
-		// loop through the inner relation
-		status = iscan.startScan((void*)attrValue);			
-		if(status != OK) return status;
-		while(iscan.scanNext(rid2) == OK){
-			inner_hfs.getRandomRecord(rid2, rec2);
-					
-			status = ProjectAndInsert(result_hf, relName1, relName2, rec1, rec2, projCnt, attrDescArray, reclen);
-			if(status != OK)   return status;
+	vector<char> batch;                  // copies of the outer tuples of the batch
+	vector<PROBEREC> probes;             // the index matches of the batch
+	int outerLen = 0;
+	bool outerDone = false;
+
+	while(!outerDone){
+		batch.clear();
+		probes.clear();
+
+		// Phase 1: read a batch of outer tuples and probe the index for each of them
+		while(outerLen == 0 || batch.size() + outerLen <= batchBytes){
+			status = hfs.scanNext(rid1, rec1);
+			if(status == FILEEOF){
+				outerDone = true;
+				break;
+			}
+			if(status != OK) return status;
+			if(useFilter && !filter.probe((char*)rec1.data + attrDesc1.attrOffset)) continue;
+
+			outerLen = rec1.length;
+			int outer = batch.size();
+			batch.insert(batch.end(), (char*)rec1.data, (char*)rec1.data + outerLen);
+
+			status = iscan.startScan(&batch[outer] + attrDesc1.attrOffset);
+			if(status != OK) return status;
+			if(covered){
+				// index-only: build the inner tuple from the index entry
+				rec1.data = &batch[outer];
+				rec2.data = &innerTuple[0];
+				rec2.length = innerLen;
+				while(iscan.scanNext(rid2, &innerTuple[0]) == OK){
+					status = proj.insert(result_hf, rec1.data, rec2.data);
+					if(status != OK)   return status;
+				}
+			}
+			else{
+				while(iscan.scanNext(rid2) == OK){
+					PROBEREC probe = {rid2, outer};
+					probes.push_back(probe);
+				}
+			}
+			status = iscan.endScan();
+			if(status != OK)  {   return status;    }
 		}
-		
+
+		if(probes.empty()) continue;
+
+		// Phase 2: sort the matches in page order of the inner relation
+		sort(probes.begin(), probes.end(), probecmp);
+
+		int pageCnt = 0;
+		for(unsigned int i = 0; i < probes.size(); i ++){
+			if(i == 0 || probes[i].rid.pageNo != probes[i - 1].rid.pageNo)
+				pageCnt ++;
+		}
+
+		// Phase 3: visit every inner page once. If most of the inner pages are
+		// needed, scan the inner relation sequentially and look each tuple up in
+		// the sorted match list; otherwise fetch only the pages holding matches
+		if(pageCnt > BITMAP_SCAN_THRESHOLD * inner_hfs.getPageCnt()){
+			status = inner_hfs.startScan(0, 0, type, NULL, op);
+			if(status != OK) return status;
+
+			while(inner_hfs.scanNext(rid2, rec2) == OK){
+				PROBEREC key;
+				key.rid = rid2;
+				vector<PROBEREC>::iterator probe = lower_bound(probes.begin(), probes.end(), key, probecmp);
+				for(; probe != probes.end() && probe->rid == rid2; probe ++){
+					rec1.data = &batch[probe->outer];
+					rec1.length = outerLen;
+
+					status = proj.insert(result_hf, rec1.data, rec2.data);
+					if(status != OK)   return status;
+				}
+			}
+		}
+		else{
+			for(unsigned int i = 0; i < probes.size(); i ++){
+				status = inner_hfs.getRandomRecord(probes[i].rid, rec2);
+				if(status != OK)   return status;
+
+				rec1.data = &batch[probes[i].outer];
+				rec1.length = outerLen;
+
+				status = proj.insert(result_hf, rec1.data, rec2.data);
+				if(status != OK)   return status;
+			}
+		}
+
 		status = inner_hfs.endScan();
 		if(status != OK)  {   return status;    }
-			
-		status = iscan.endScan();
-		if(status != OK)  {   return status;    }
 	}
-	
+
+	if(useFilter) filter.printStats();
+
 	status = hfs.endScan();
   	return status;
 }
-
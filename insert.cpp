@@ -1,6 +1,7 @@
 #include "catalog.h"
 #include "query.h"
 #include "index.h"
+#include "adaptive.h"
 #include <cstring>
 #include <iostream>
 
@@ -86,6 +87,10 @@ Status Updates::Insert(const string& relation,      // Name of the relation
 		return status;
 	}	
 	
+	// version of the relation before the insert: composite and adaptive
+	// indexes that are in step with it are maintained below
+	const int oldVersion = newHF.getVersion();
+
 	RID newRid;
 	status = newHF.insertRecord(newR, newRid);
 	if(status != OK){
@@ -113,10 +118,11 @@ Status Updates::Insert(const string& relation,      // Name of the relation
 			}	
 			
 			// insert the entry into the index
+			// (the record supplies the attributes a covering index carries)
 			char tempStr[length];
 			void* value = tempStr;
 			memcpy(value, rBuffer + offset, length);
-			status = index.insertEntry(value, newRid);
+			status = index.insertEntry(value, newRid, newR);
 			if(status != OK){
 				Error::print(status);
 				delete []attrs;
@@ -126,6 +132,60 @@ Status Updates::Insert(const string& relation,      // Name of the relation
 		}
 	}	
 
+	// insert the entry into each composite index of the relation. An
+	// index that is already behind the relation (or was built from an
+	// earlier relation of the same name) is left alone; it is rebuilt
+	// the next time a query opens it. So is an entry whose attributes
+	// the relation no longer has. Only the catalogs that have entries on
+	// the relation are opened (see HeapFile::getCatalogFlags)
+	const int catalogFlags = newHF.getCatalogFlags();
+	if(catalogFlags & COMPINDEXFLAG){
+		int indexCnt = 0;
+		CompIndexDesc *indexes;
+		CompIndexCatalog compCat(status);
+		if(status == OK)
+			status = compCat.getRelInfo(relation, indexCnt, indexes);
+		for(int k = 0; status == OK && k < indexCnt; k ++){
+			int keyOffset[MAXKEYATTRS];
+			int keyLength[MAXKEYATTRS];
+			Datatype keyType[MAXKEYATTRS];
+			if(compCat.getKeyInfo(indexes[k], keyOffset, keyLength, keyType) != OK)
+				continue;
+
+			Index index(relation, indexes[k].keyCnt, keyOffset, keyLength, keyType, 0, status);
+			if(status != OK) break;
+			if(index.getRelFileId() != newHF.getFileId()
+			   || index.getRelVersion() != oldVersion) continue;
+
+			char key[PAGESIZE];
+			index.makeKey(rBuffer, key);
+			status = index.insertEntry(key, newRid, newR);
+			if(status == OK)
+				index.setRelVersion(newHF.getVersion());
+		}
+		if(indexCnt > 0) delete []indexes;
+	}
+
+	// and the adaptive indexes (the others are dropped)
+	insertAdaptive(relation, rBuffer, newRid, newHF.getFileId(), oldVersion,
+		       newHF.getVersion());
+
+	// add the tuple to the statistics of the relation, if it has any
+	if(status == OK && (catalogFlags & STATSFLAG)){
+		StatCatalog statCat(status);
+		if(status == OK)
+			status = statCat.addTuple(relation, rBuffer, newHF.getPageCnt());
+	}
+
+	// a clustered relation stays in order if the tuple comes last in it
+	if(status == OK && (catalogFlags & CLUSTERFLAG)){
+		ClusterCatalog clustCat(status);
+		if(status == OK)
+			status = clustCat.addTuple(relation, rBuffer, newHF.getFileId(),
+						   oldVersion, newHF.getVersion());
+	}
+	if(status != OK) Error::print(status);
+
 	delete []attrs;
 	delete []rBuffer;		
 	return status;
@@ -2,7 +2,11 @@
 #include "query.h"
 #include "sort.h"
 #include "index.h"
+#include "exec.h"
+#include "cost.h"
+#include "adaptive.h"
 #include <cmath>
+#include <cfloat>
 #include <cstring>
 #include <cassert>
 
@@ -10,65 +14,142 @@
 #define DOUBLEERROR 1e-07
 
 
-/*  
- * Help function used in snl.cpp and sml.cpp:
- * 
- * Projection on the fly and insert the result record into 
- * the result heap file
- * 
- * return OK on success
- *        an error code otherwise
+/*
+ * Help functions used in inl.cpp and smj.cpp for semi-join reduction:
+ *
+ * A Bloom filter built from the values of one join attribute is probed
+ * with values of the other, so both must have the same type and length.
+ * A merge join compares DOUBLEs with a tolerance (see matchRec), which
+ * a filter on exact values would not respect.
  */
-Status Operators::ProjectAndInsert(HeapFile &result,     // Heap file storing reuslts 
-			const string &relName1,		 // Relation 1
-			const string &relName2,		 // Relation 2
-			Record &rec1, 			 // The record for relation 1
-			Record &rec2, 			 // The record for relation 2
-			const int projCnt, 		 // The # of attrs in projection
-			const AttrDesc attrDescArray[],	 // The projection list
-			const int reclen)		 // Length of a tuple in the result relation
-{	
+bool Operators::SemiJoinApplies(const AttrDesc &attrDesc1,	// one join attribute
+				const AttrDesc &attrDesc2,	// the other join attribute
+				const bool exact)		// the join matches exact values
+{
+	if(attrDesc1.attrType != attrDesc2.attrType || attrDesc1.attrLen != attrDesc2.attrLen)
+		return false;
+	return exact || attrDesc1.attrType != DOUBLE;
+}
+
+
+Status Operators::BuildBloomFilter(const AttrDesc &buildDesc,	// attribute the filter is built from
+				   BloomFilter &filter)		// the filter
+{
 	Status status;
 
-	void* rec1_data = rec1.data;
-	void* rec2_data = rec2.data;
-	int tempOffset = 0;
-	char* res_data = new char[reclen + 1];
-	res_data[reclen] = '\0';
+	HeapFileScan hfs(buildDesc.relName, status);
+	if(status != OK) return status;
 
-	for(int i = 0; i < projCnt; i ++){
-		void* source_data;
-
-		// If the projection attr is in the realtion 1
-		if(attrDescArray[i].relName == relName1)
-			source_data = rec1_data;
-		// Otherwise in the realtion 2
-		else{
-			assert(attrDescArray[i].relName == relName2);
-			source_data = rec2_data;
-		}
-	
-		// Copy the data
-		memcpy(res_data + tempOffset,
-		       (char*)source_data + attrDescArray[i].attrOffset,
-		       attrDescArray[i].attrLen);
-		
-		tempOffset += attrDescArray[i].attrLen;
+	RID rid;
+	Record rec;
+	while((status = hfs.scanNext(rid, rec)) == OK)
+		filter.add((char*)rec.data + buildDesc.attrOffset);
+	if(status != FILEEOF) return status;
+
+	return hfs.endScan();
+}
+
+
+/*
+ * Help function: return the number of tuples in a relation
+ */
+Status Operators::GetRecCnt(const string &relName,	// the relation
+			    int &recCnt)		// # of tuples in it
+{
+	Status status;
+	HeapFile hf(relName, status);
+	if(status != OK) return status;
+
+	recCnt = hf.getRecCnt();
+	return OK;
+}
+
+
+/*
+ * Help function: run a plan and insert all the tuples it produces into
+ * the heap file result, a batch at a time
+ */
+Status Operators::Drain(Iterator &plan,		// the plan
+			const string &result)	// name of the output relation
+{
+	Status status;
+
+	HeapFile hf(result, status);
+	if(status != OK){
+		cerr << "Open heap file for storing the results of the plan failed!" << endl;
+		return status;
 	}
-	
-	// Pack the output relation into record and insert the record into 
-	// the resulting heap file
-	RID res_rid;
-	Record res_rec = {res_data, reclen};
 
-	status = result.insertRecord(res_rec, res_rid);
+	status = plan.open();
 	if(status != OK) return status;
 
-	delete []res_data;
+	vector<char> tuples;
+	int tupleLen, tupleCnt;
+	while((status = plan.nextBatch(tuples, tupleLen, tupleCnt, EXECBATCHSIZE)) == OK){
+		for(int i = 0; i < tupleCnt; i ++){
+			RID rid;
+			Record rec = {&tuples[i * tupleLen], tupleLen};
+			status = hf.insertRecord(rec, rid);
+			if(status != OK) return status;
+		}
+	}
+	if(status != FILEEOF) return status;
 
-	return OK;
+	return plan.close();
 }
 
+
+/*
+ * Help function: the projection list of a join for the joined tuples of
+ * a join iterator, in which the tuple of relName1 comes first
+ */
+void Operators::JoinLayout(const string &relName1,		// the left relation
+			   const int leftLen,			// length of its tuples
+			   const int projCnt,			// # of attributes in the projection
+			   const AttrDesc attrDescArray[],	// the projection list
+			   AttrDesc layout[])			// the list for the joined tuples
+{
+	for(int i = 0; i < projCnt; i ++){
+		layout[i] = attrDescArray[i];
+		if(relName1 != attrDescArray[i].relName)
+			layout[i].attrOffset += leftLen;
+	}
+}
+
+
+/*
+ * Help function: whether the relation can be read in the order of an
+ * attribute without sorting it: it is clustered on the attribute or has
+ * a sorted copy on it, at its current version (see SortedFile)
+ */
+bool Operators::StoredInOrder(const AttrDesc &attrDesc)	// the attribute
+{
+	Status status;
+	const Datatype type = static_cast<Datatype>(attrDesc.attrType);
+
+	int fileId, version;
+	{
+		HeapFile hf(attrDesc.relName, status);
+		if(status != OK) return false;
+		fileId = hf.getFileId();
+		version = hf.getVersion();
+	}
+
+	ClusterCatalog clustCat(status);
+	if(status != OK) return false;
+	if(clustCat.isClustered(attrDesc.relName, attrDesc.attrOffset, attrDesc.attrLen, type,
+				fileId, version))
+		return true;
+
+	SortCatalog sortCat(status);
+	if(status != OK) return false;
+
+	SortCopyDesc desc;
+	return sortCat.getInfo(attrDesc.relName, attrDesc.attrOffset, attrDesc.attrLen, type, desc) == OK
+		&& desc.relFileId == fileId && desc.relVersion == version;
+}
+
+
 /*
  * Joins two relations
  *
@@ -114,22 +195,78 @@ Status Operators::Join(const string& result,           // Name of the output rel
 		return status;
 	}
 
-	// decide which join algorithm to use according to the index and op
-	// The order of PREFERENCE for the algorithms is:
-	// 	INL (indexed-nested loops join)   	// guaranteed that the second attr is the indexed one
-	//   -> SMJ (sort-merge join) 
-	//   -> SNL (simple nested-loops join)
-	if(op == EQ && attr_2->indexed == 1){
-		status = Operators::INL(result, projCnt, attr_n, *attr_1, op, *attr_2, reclen);	
+	// decide which join algorithm to use with the cost model (cost.h):
+	// for EQ the cheapest of
+	// 	INL (indexed-nested loops join)   	// in either direction, if the inner attr is indexed
+	//						// or has an adaptive index
+	// 	HJ (hash join)				// building on the smaller relation
+	// 	SMJ (sort-merge join)
+	// 	BNL (block nested-loops join)		// with the smaller relation outer
+	// for LT, LTE, GT and GTE the cheaper of BMJ (band merge join) and BNL,
+	// and BNL for NE. DOUBLE equi-joins stay with the merge join and the
+	// index, which compare DOUBLEs the way the other equi-joins do not
+	JOINSTATS stats1, stats2;
+	status = getJoinStats(*attr_1, stats1);
+	if(status == OK) status = getJoinStats(*attr_2, stats2);
+	if(status != OK){
+		delete attr_1;
+		delete attr_2;
+		delete [] attr_n;
+		return status;
 	}
-	else if(op == EQ && attr_2->indexed == 0 && attr_1->indexed == 1){
-		status = Operators::INL(result, projCnt, attr_n, *attr_2, op, *attr_1, reclen);	
+
+	const int frames = bufMgr->numUnpinnedPages() * 0.8;
+	const bool smallLeft = stats1.pageCnt <= stats2.pageCnt;
+	// hashing and BNL compare the keys exactly, which is safe unless they
+	// are DOUBLEs (see SemiJoinApplies)
+	const bool hashable = SemiJoinApplies(*attr_1, *attr_2, false);
+
+	enum { ALG_INL12, ALG_INL21, ALG_HJ, ALG_SMJ, ALG_BMJ, ALG_BNL } alg = ALG_BNL;
+	double best = smallLeft ? costBNL(stats1, stats2, frames) : costBNL(stats2, stats1, frames);
+
+	if(op == EQ){
+		if(!hashable) best = DBL_MAX;
+		const double costs[4] = {
+			attr_2->indexed == 1 || findAdaptiveIndex(*attr_2) ? costINL(stats1, stats2, frames) : DBL_MAX,
+			attr_1->indexed == 1 || findAdaptiveIndex(*attr_1) ? costINL(stats2, stats1, frames) : DBL_MAX,
+			!hashable ? DBL_MAX : smallLeft ? costHJ(stats2, stats1) : costHJ(stats1, stats2),
+			costSMJ(stats1, stats2, frames) };
+		for(int a = 3; a >= 0; a --){
+			if(costs[a] <= best){
+				best = costs[a];
+				alg = (a == 0) ? ALG_INL12 : (a == 1) ? ALG_INL21 : (a == 2) ? ALG_HJ : ALG_SMJ;
+			}
+		}
 	}
-	else if(op == EQ && attr_1->indexed == 0 && attr_2->indexed == 0){
-		status = Operators::SMJ(result, projCnt, attr_n, *attr_1, op, *attr_2, reclen);	
+	else if(op == LT || op == LTE || op == GT || op == GTE){
+		if(costSMJ(stats1, stats2, frames) <= best) alg = ALG_BMJ;
 	}
-	else{
-		status = Operators::SNL(result, projCnt, attr_n, *attr_1, op, *attr_2, reclen);	
+
+	switch(alg){
+	case ALG_INL12:
+		status = Operators::INL(result, projCnt, attr_n, *attr_1, op, *attr_2, reclen);
+		break;
+	case ALG_INL21:
+		status = Operators::INL(result, projCnt, attr_n, *attr_2, op, *attr_1, reclen);
+		break;
+	case ALG_HJ:
+		if(smallLeft)
+			status = Operators::HJ(result, projCnt, attr_n, *attr_2, op, *attr_1, reclen);
+		else
+			status = Operators::HJ(result, projCnt, attr_n, *attr_1, op, *attr_2, reclen);
+		break;
+	case ALG_SMJ:
+		status = Operators::SMJ(result, projCnt, attr_n, *attr_1, op, *attr_2, reclen);
+		break;
+	case ALG_BMJ:
+		status = Operators::BMJ(result, projCnt, attr_n, *attr_1, op, *attr_2, reclen);
+		break;
+	case ALG_BNL:
+		if(smallLeft)
+			status = Operators::BNL(result, projCnt, attr_n, *attr_1, op, *attr_2, reclen);
+		else
+			status = Operators::BNL(result, projCnt, attr_n, *attr_2, flipOp(op), *attr_1, reclen);
+		break;
 	}
 
 	delete attr_1;
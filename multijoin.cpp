@@ -0,0 +1,291 @@
+#include "catalog.h"
+#include "query.h"
+#include "exec.h"
+#include "cost.h"
+#include "adaptive.h"
+#include <cfloat>
+#include <cstring>
+#include <cmath>
+
+int calTupleLength(const AttrDesc &attrDesc);
+
+// A join predicate after the attributes have been looked up in the catalog
+typedef struct {
+  AttrDesc attrDesc1;                   // left attr in the join predicate
+  Operator op;                          // predicate operation
+  AttrDesc attrDesc2;                   // right attr in the join predicate
+  int rel1, rel2;                       // positions of their relations in relNames
+  JOINSTATS stats1, stats2;             // statistics of attrDesc1 and attrDesc2
+} JoinDesc;
+
+// The ways of joining the next relation to the plan
+enum JoinStep { STEP_INL, STEP_HJ, STEP_SMJ, STEP_BNL };
+
+
+/*
+ * Return the position of a relation in the list, -1 if it is not there
+ */
+static int relIndex(const char* relName,	// the relation
+		    const int relCnt,		// # of relations
+		    const string relNames[])	// the relations
+{
+	for(int i = 0; i < relCnt; i ++){
+		if(relNames[i] == relName) return i;
+	}
+	return -1;
+}
+
+
+/*
+ * An attribute of a relation of the plan at its position in the joined tuples
+ */
+static AttrDesc shifted(const AttrDesc &attrDesc, const int offset)
+{
+	AttrDesc desc = attrDesc;
+	desc.attrOffset += offset;
+	return desc;
+}
+
+
+/*
+ * Joins any number of relations
+ *
+ * The plan is left-deep and its order is picked greedily with the
+ * cost model (cost.h): it starts with the smallest relation, and each
+ * step joins the relation connected to the ones already joined that
+ * gives the smallest intermediate result (a cross product if there is
+ * none), with the cheapest of
+ * 	INL        if the predicate is EQ and the new relation has an index on it
+ * 	hash join  if the predicate is EQ
+ * 	BNL        (block nested loops) for any predicate
+ * As in the join of two relations, an EQ predicate on DOUBLEs is joined
+ * with INL or a merge join (which matches DOUBLEs with a tolerance, see
+ * matchRec), never by hashing or BNL, which compare them exactly. Past
+ * the first step the merge join writes the plan to a temporary file to
+ * sort it.
+ * Predicates between relations already joined filter the joined tuples.
+ * The joined tuples go through the plan one at a time; only the
+ * projected final result is written.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise
+ */
+Status Operators::Join(const string& result,           // Name of the output relation
+                       const int projCnt,              // Number of attributes in the projection
+    	               const attrInfo projNames[],     // List of projection attributes
+    	               const int relCnt,               // Number of relations
+    	               const string relNames[],        // The relations
+    	               const int joinCnt,              // Number of join predicates
+    	               const joinInfo joins[])         // The join predicates
+{
+	Status status;
+
+	// two relations and one predicate: the join of two relations
+	if(relCnt == 2 && joinCnt == 1){
+		return Operators::Join(result, projCnt, projNames, &joins[0].attr1, joins[0].op, &joins[0].attr2);
+	}
+
+	if(relCnt < 1) return BADCATPARM;
+	for(int i = 0; i < relCnt; i ++){
+		if(relIndex(relNames[i].c_str(), i, relNames) >= 0) return BADCATPARM;
+	}
+
+	// convert the join predicates and the projection list to AttrDesc
+	vector<JoinDesc> preds(joinCnt);
+	for(int i = 0; i < joinCnt; i ++){
+		status = attrCat->getInfo(joins[i].attr1.relName, joins[i].attr1.attrName, preds[i].attrDesc1);
+		if(status != OK) return status;
+		status = attrCat->getInfo(joins[i].attr2.relName, joins[i].attr2.attrName, preds[i].attrDesc2);
+		if(status != OK) return status;
+		if(preds[i].attrDesc1.attrType != preds[i].attrDesc2.attrType) return ATTRTYPEMISMATCH;
+
+		preds[i].op = joins[i].op;
+		preds[i].rel1 = relIndex(preds[i].attrDesc1.relName, relCnt, relNames);
+		preds[i].rel2 = relIndex(preds[i].attrDesc2.relName, relCnt, relNames);
+		if(preds[i].rel1 < 0 || preds[i].rel2 < 0) return RELNOTFOUND;
+
+		status = getJoinStats(preds[i].attrDesc1, preds[i].stats1);
+		if(status != OK) return status;
+		status = getJoinStats(preds[i].attrDesc2, preds[i].stats2);
+		if(status != OK) return status;
+	}
+
+	int reclen = 0;
+	vector<AttrDesc> proj_n(projCnt);
+	status = Operators::ConvertFromInfoToDesc(projNames, projCnt, &proj_n[0], reclen);
+	if(status != OK) return status;
+
+	vector<int> proj_rel(projCnt);
+	for(int i = 0; i < projCnt; i ++){
+		proj_rel[i] = relIndex(proj_n[i].relName, relCnt, relNames);
+		if(proj_rel[i] < 0) return RELNOTFOUND;
+	}
+
+	// the sizes of the relations
+	vector<JOINSTATS> relStats(relCnt);
+	vector<int> relLens(relCnt);
+	AttrDesc relDesc;                     // names a relation (for calTupleLength)
+	memset(&relDesc, 0, sizeof(relDesc));
+	for(int r = 0; r < relCnt; r ++){
+		strcpy(relDesc.relName, relNames[r].c_str());
+		status = getJoinStats(relDesc, relStats[r]);
+		if(status != OK) return status;
+		relLens[r] = calTupleLength(relDesc);
+	}
+
+	const int frames = bufMgr->numUnpinnedPages() * 0.8;
+
+	// offset of each relation in the joined tuples, -1 until it is joined
+	vector<int> offsets(relCnt, -1);
+	vector<bool> applied(joinCnt, false);
+
+	// the plan starts with the smallest relation
+	int first = 0;
+	for(int r = 1; r < relCnt; r ++){
+		if(relStats[r].recCnt < relStats[first].recCnt) first = r;
+	}
+
+	Iterator *plan = new ScanIter(relNames[first]);
+	JOINSTATS planStats = relStats[first];
+	int planLen = relLens[first];
+	offsets[first] = 0;
+	string steps = relNames[first];
+
+	for(int step = 1; step < relCnt; step ++){
+		bool connected = false;
+		for(int i = 0; i < joinCnt; i ++){
+			if((offsets[preds[i].rel1] < 0) != (offsets[preds[i].rel2] < 0)) connected = true;
+		}
+
+		// the next relation: of those that a predicate connects to the
+		// plan (all of them if there are none) the one that gives the
+		// fewest tuples, and of those the cheapest one to join. It is
+		// joined on an equality predicate if there is one.
+		int rel = -1, via = -1;
+		JoinStep method = STEP_BNL;
+		double bestCard = DBL_MAX, bestCost = DBL_MAX;
+
+		for(int r = 0; r < relCnt; r ++){
+			if(offsets[r] >= 0) continue;
+
+			double card = planStats.recCnt * relStats[r].recCnt;
+			const double pairs = max(card, 1.0);
+			int rvia = -1;
+			for(int i = 0; i < joinCnt; i ++){
+				const bool rIsRight = (preds[i].rel2 == r && offsets[preds[i].rel1] >= 0);
+				const bool rIsLeft = (preds[i].rel1 == r && offsets[preds[i].rel2] >= 0);
+				if(!rIsRight && !rIsLeft) continue;
+
+				JOINSTATS planSide = planStats, relSide = relStats[r];
+				planSide.distinct = min((rIsRight ? preds[i].stats1 : preds[i].stats2).distinct, planStats.recCnt);
+				relSide.distinct = (rIsRight ? preds[i].stats2 : preds[i].stats1).distinct;
+				card *= joinCard(planSide, relSide, preds[i].op) / pairs;
+
+				if(rvia < 0 || (preds[i].op == EQ && preds[rvia].op != EQ)) rvia = i;
+			}
+			if(connected && rvia < 0) continue;
+
+			// the cheapest way to join it
+			JoinStep rmethod = STEP_BNL;
+			double cost = costBNL(planStats, relStats[r], frames);
+			if(rvia >= 0 && preds[rvia].op == EQ){
+				const AttrDesc &relAttr = (preds[rvia].rel2 == r) ? preds[rvia].attrDesc2 : preds[rvia].attrDesc1;
+				if(!SemiJoinApplies(preds[rvia].attrDesc1, preds[rvia].attrDesc2, false)){
+					// the plan is written out and sorted unless it is a relation
+					cost = costSMJ(planStats, relStats[r], frames)
+						+ (step > 1 ? planStats.pageCnt : 0);
+					rmethod = STEP_SMJ;
+				}
+				const double hj = rmethod == STEP_SMJ ? DBL_MAX : costHJ(planStats, relStats[r]);
+				if(hj <= cost){
+					cost = hj;
+					rmethod = STEP_HJ;
+				}
+				const bool indexed = relAttr.indexed == 1 || findAdaptiveIndex(relAttr);
+				const double inl = indexed ? costINL(planStats, relStats[r], frames) : DBL_MAX;
+				if(inl <= cost){
+					cost = inl;
+					rmethod = STEP_INL;
+				}
+			}
+
+			if(card < bestCard || (card == bestCard && cost < bestCost)){
+				rel = r;
+				via = rvia;
+				method = rmethod;
+				bestCard = card;
+				bestCost = cost;
+			}
+		}
+
+		strcpy(relDesc.relName, relNames[rel].c_str());
+		const int blockBytes = frames * PAGESIZE;
+
+		if(via < 0){
+			plan = new NLJoinIter(plan, relDesc, NOTSET, new ScanIter(relNames[rel]), relDesc, blockBytes);
+			steps += ", Cross Product " + relNames[rel];
+		}
+		else{
+			// orient the predicate as "plan attribute op new attribute"
+			const bool newIsRight = (preds[via].rel2 == rel);
+			const AttrDesc &planAttr = newIsRight ? preds[via].attrDesc1 : preds[via].attrDesc2;
+			const AttrDesc &relAttr = newIsRight ? preds[via].attrDesc2 : preds[via].attrDesc1;
+			const Operator op = newIsRight ? preds[via].op : flipOp(preds[via].op);
+			const AttrDesc leftAttr = shifted(planAttr, offsets[newIsRight ? preds[via].rel1 : preds[via].rel2]);
+
+			if(method == STEP_INL){
+				plan = new INLJoinIter(plan, leftAttr, relAttr);
+				steps += ", Indexed NL Join " + relNames[rel];
+			}
+			else if(method == STEP_HJ){
+				plan = new HashJoinIter(plan, leftAttr, new ScanIter(relNames[rel]), relAttr);
+				steps += ", Hash Join " + relNames[rel];
+			}
+			else if(method == STEP_SMJ){
+				// the first relation is sorted as it is
+				if(step == 1){
+					delete plan;
+					plan = new SMJoinIter(planAttr, relAttr);
+				}
+				else
+					plan = new SMJoinIter(plan, planLen, leftAttr, relAttr);
+				steps += ", SM Join " + relNames[rel];
+			}
+			else{
+				plan = new NLJoinIter(plan, leftAttr, op, new ScanIter(relNames[rel]), relAttr, blockBytes);
+				steps += ", Block NL Join " + relNames[rel];
+			}
+			applied[via] = true;
+		}
+
+		offsets[rel] = planLen;
+		planLen += relLens[rel];
+		planStats.recCnt = bestCard;
+		planStats.pageCnt = ceil(bestCard * planLen / PAGESIZE);
+
+		// the other predicates between relations of the plan
+		for(int i = 0; i < joinCnt; i ++){
+			if(applied[i] || offsets[preds[i].rel1] < 0 || offsets[preds[i].rel2] < 0) continue;
+			plan = new CompareIter(plan, shifted(preds[i].attrDesc1, offsets[preds[i].rel1]), preds[i].op,
+					       shifted(preds[i].attrDesc2, offsets[preds[i].rel2]));
+			applied[i] = true;
+		}
+	}
+
+	// predicates within the first relation, if it is the only one
+	for(int i = 0; i < joinCnt; i ++){
+		if(applied[i]) continue;
+		plan = new CompareIter(plan, preds[i].attrDesc1, preds[i].op, preds[i].attrDesc2);
+	}
+
+  	cout << "Algorithm: Multi-way Join (" << steps << ")" << endl;
+
+	// the projection list for the joined tuples
+	for(int i = 0; i < projCnt; i ++){
+		proj_n[i].attrOffset += offsets[proj_rel[i]];
+	}
+
+	ProjectIter top(plan, projCnt, &proj_n[0], reclen);
+	return Operators::Drain(top, result);
+}
@@ -0,0 +1,70 @@
+#include <string.h>
+#include "normkey.h"
+
+// INTEGER: flip the sign bit so that negative numbers sort before
+// positive ones, then store the bits most significant byte first.
+//
+// DOUBLE: for positive numbers flip the sign bit, for negative numbers
+// flip all bits (larger magnitude means smaller value), then store most
+// significant byte first. -0.0 is mapped to 0.0 so that the two compare
+// equal, as they do for the hash index and the scan predicates.
+//
+// CHAR(n): copied up to the terminating NUL and padded with NULs, so that
+// the key compares like strncmp on the value.
+
+void normalizeKey(const char* src, const Datatype type, const int length,
+		  unsigned char* dst)
+{
+  switch(type) {
+  case INTEGER:
+    {
+      int ival;
+      memcpy(&ival, src, sizeof(int));
+      unsigned int bits = (unsigned int)ival ^ 0x80000000u;
+      for (int i = sizeof(int) - 1; i >= 0; i--) {
+	dst[i] = bits & 0xff;
+	bits >>= 8;
+      }
+    }
+    break;
+  case DOUBLE:
+    {
+      double dval;
+      unsigned long long bits;
+      memcpy(&dval, src, sizeof(double));
+      if (dval == 0.0)
+	dval = 0.0;                     // fold -0.0 into 0.0
+      memcpy(&bits, &dval, sizeof(double));
+      if (bits & 0x8000000000000000ull)
+	bits = ~bits;
+      else
+	bits ^= 0x8000000000000000ull;
+      for (int i = sizeof(double) - 1; i >= 0; i--) {
+	dst[i] = bits & 0xff;
+	bits >>= 8;
+      }
+    }
+    break;
+  default:
+    // bytes after the terminating NUL are not part of the value
+    strncpy((char *)dst, src, length);
+    break;
+  }
+}
+
+
+unsigned long long keyPrefix(const char* src, const Datatype type,
+			     const int length)
+{
+  const int prefixLen = sizeof(unsigned long long);
+  unsigned char norm[sizeof(unsigned long long)];
+  unsigned long long prefix = 0;
+
+  // CHAR(n) normalization is prefix-preserving, so only the first
+  // bytes need to be normalized
+  const int len = length < prefixLen ? length : prefixLen;
+  normalizeKey(src, type, len, norm);
+  for (int i = 0; i < prefixLen; i++)
+    prefix = (prefix << 8) | (i < len ? norm[i] : 0);
+  return prefix;
+}
@@ -0,0 +1,24 @@
+#ifndef NORMKEY_H
+#define NORMKEY_H
+
+#include "datatypes.h"
+
+// Normalized keys are byte strings that compare with memcmp in the same
+// order as the attribute values they are built from, and are equal exactly
+// when the values are equal. INTEGER and DOUBLE values become big-endian
+// bit patterns of the same length; CHAR(n) values are copied up to the
+// terminating NUL and padded with NULs.
+
+// Write the normalized form of the attribute value at src to dst
+// (length bytes in both).
+void normalizeKey(const char* src, const Datatype type, const int length,
+		  unsigned char* dst);
+
+// Return the first 8 bytes of the normalized form of the attribute value
+// at src as an integer (padded with zero bytes), so that prefixes compare
+// with < in the order of the values. INTEGER and DOUBLE values are
+// covered completely; equal prefixes of longer strings need a full compare.
+unsigned long long keyPrefix(const char* src, const Datatype type,
+			     const int length);
+
+#endif
@@ -0,0 +1,183 @@
+#include "catalog.h"
+#include "query.h"
+#include "sort.h"
+#include "sortkernel.h"
+#include "projection.h"
+#include <algorithm>
+#include <cstring>
+
+int calTupleLength(const AttrDesc &attrDesc);
+
+
+/*
+ * Orders a relation, optionally keeping only its first tuples
+ *
+ * A limit whose tuples fit in the unpinned buffer pages is served by a
+ * bounded heap in one scan, unless the relation can be read in order
+ * already (clustered or with a sorted copy), in which case reading its
+ * first tuples is cheaper still. Everything else is sorted.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise
+ */
+Status Operators::OrderBy(const string& result,		// Name of the output relation
+			  const int projCnt,		// Number of attributes in the projection
+			  const attrInfo projNames[],	// List of projection attributes
+			  const attrInfo* sortAttr,	// The attribute to order by
+			  const int limit)		// # of tuples wanted, 0 for all
+{
+	Status status;
+
+	if(!sortAttr) return ATTRNOTFOUND;
+	if(limit < 0) return BADCATPARM;
+
+	AttrDesc sortDesc;
+	status = attrCat->getInfo(sortAttr->relName, sortAttr->attrName, sortDesc);
+	if(status != OK) return status;
+
+	// convert the data structure of all the attrs from attrInfo to AttrDesc
+	vector<AttrDesc> proj_n(projCnt + 1);
+	int reclen = 0;
+	status = Operators::ConvertFromInfoToDesc(projNames, projCnt, &proj_n[0], reclen);
+	if(status != OK) return status;
+
+	for(int i = 0; i < projCnt; i ++)
+		if(strcmp(proj_n[i].relName, sortDesc.relName)) return BADCATPARM;
+
+	const int tupleLen = calTupleLength(sortDesc);
+	const int pages = bufMgr->numUnpinnedPages() * 0.8;
+	if(limit > 0 && (double)limit * tupleLen <= (double)pages * PAGESIZE
+	   && !Operators::StoredInOrder(sortDesc))
+		return Operators::TopN(result, projCnt, &proj_n[0], sortDesc, limit, reclen);
+
+	return Operators::SortOrderBy(result, projCnt, &proj_n[0], sortDesc, limit, reclen);
+}
+
+
+/*
+ * Top-N: the relation is scanned once, keeping the limit smallest tuples
+ * seen so far in a max-heap (ordered as in a SortedFile, see
+ * SortRecLess). A tuple that is smaller than the top of a full heap
+ * replaces it; all others are dropped at once, so nothing is written
+ * before the heap is sorted and projected into the result.
+ */
+Status Operators::TopN(const string& result,		// Name of the output relation
+		       const int projCnt,		// Number of attributes in the projection
+		       const AttrDesc projNames[],	// Projection list (as AttrDesc)
+		       const AttrDesc& sortDesc,	// The attribute to order by
+		       const int limit,			// # of tuples wanted
+		       const int reclen)		// Length of a tuple in the result relation
+{
+  	cout << "Algorithm: Top-N Heap" << endl;
+
+	Status status;
+	const Datatype type = static_cast<Datatype>(sortDesc.attrType);
+	SortRecLess less(sortDesc.attrOffset, sortDesc.attrLen, type);
+
+	HeapFileScan hfs(sortDesc.relName, status);
+	if(status != OK) return status;
+
+	// the kept tuples are copied into arena, one slot each
+	vector<char> arena;
+	vector<SORTREC> heap;
+	heap.reserve(limit);
+
+	int tupleCnt = 0, replaceCnt = 0;
+	RID rid;
+	Record rec;
+	while((status = hfs.scanNext(rid, rec)) == OK){
+		tupleCnt ++;
+
+		SORTREC item;
+		item.prefix = keyPrefix((char*)rec.data + sortDesc.attrOffset, type, sortDesc.attrLen);
+		item.tuple = (char*)rec.data;
+		item.length = rec.length;
+		item.run = 0;
+
+		if((int)heap.size() < limit){
+			if(arena.empty()) arena.resize((size_t)limit * rec.length);
+			item.tuple = &arena[heap.size() * rec.length];
+			memcpy(item.tuple, rec.data, rec.length);
+			heap.push_back(item);
+			push_heap(heap.begin(), heap.end(), less);
+		}
+		else if(less(item, heap.front())){
+			pop_heap(heap.begin(), heap.end(), less);
+			SORTREC &slot = heap.back();
+			memcpy(slot.tuple, rec.data, rec.length);
+			slot.prefix = item.prefix;
+			push_heap(heap.begin(), heap.end(), less);
+			replaceCnt ++;
+		}
+	}
+	if(status != FILEEOF) return status;
+
+	status = hfs.endScan();
+	if(status != OK) return status;
+
+	cout << "Top-N: kept " << heap.size() << " of " << tupleCnt << " tuples ("
+	     << replaceCnt << " replacements)" << endl;
+
+	sort_heap(heap.begin(), heap.end(), less);
+
+	HeapFile hf(result, status);
+	if(status != OK){
+		cerr << "Open heap file for storing the results of the top-N failed!" << endl;
+		return status;
+	}
+
+	Projection proj(projCnt, projNames, reclen);
+	for(unsigned int i = 0; i < heap.size(); i ++){
+		status = proj.insert(hf, heap[i].tuple);
+		if(status != OK) return status;
+	}
+
+	return OK;
+}
+
+
+/*
+ * Order by sorting: the relation is read through a SortedFile (keeping
+ * a sorted copy, as for SMJ) and the projections of its first limit
+ * tuples, or all of them, are inserted into the result.
+ */
+Status Operators::SortOrderBy(const string& result,		// Name of the output relation
+			      const int projCnt,		// Number of attributes in the projection
+			      const AttrDesc projNames[],	// Projection list (as AttrDesc)
+			      const AttrDesc& sortDesc,		// The attribute to order by
+			      const int limit,			// # of tuples wanted, 0 for all
+			      const int reclen)			// Length of a tuple in the result relation
+{
+  	cout << "Algorithm: Sort" << endl;
+
+	Status status;
+
+	// The relation is sorted as in SMJ (see smj.cpp)
+	const RunGenerator runGen = SortedFile::sortThreads() > 1 ? PARALLEL_RUNS : REPLACEMENT_SELECTION;
+	const int pages = bufMgr->numUnpinnedPages() * 0.8;
+	const int maxItems = max(2, (int)(pages * PAGESIZE) / calTupleLength(sortDesc));
+	SortedFile sorted(sortDesc.relName, sortDesc.attrOffset, sortDesc.attrLen,
+			  static_cast<Datatype>(sortDesc.attrType), maxItems, status,
+			  0, runGen, true);
+	if(status != OK) return status;
+
+	HeapFile hf(result, status);
+	if(status != OK){
+		cerr << "Open heap file for storing the results of the sort failed!" << endl;
+		return status;
+	}
+
+	Projection proj(projCnt, projNames, reclen);
+	Record rec;
+	for(int cnt = 0; limit == 0 || cnt < limit; cnt ++){
+		status = sorted.next(rec);
+		if(status == FILEEOF) break;
+		if(status != OK) return status;
+
+		status = proj.insert(hf, rec.data);
+		if(status != OK) return status;
+	}
+
+	return OK;
+}
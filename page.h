@@ -11,6 +11,12 @@ struct RID{
   {
     return ((other.pageNo == pageNo) && (other.slotNo == slotNo));
   }
+  // order RIDs by page first, then by slot (i.e. physical file order)
+  bool operator < (const RID & other) const
+  {
+    return (pageNo < other.pageNo) ||
+           (pageNo == other.pageNo && slotNo < other.slotNo);
+  }
 
   RID() {reset();}
   void reset() {pageNo = -1; slotNo = -1;}
@@ -0,0 +1,131 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "catalog.h"
+
+// Global variables
+DB db;                 // a handle for the DB class
+Error error;           // a handle for the error class
+
+BufMgr *bufMgr;        // pointer to the buffer manager
+RelCatalog *relCat;    // pointer to the relation catalogs
+AttrCatalog *attrCat;  // pointer to the attribute catalogs
+
+#define CALL(c)    {Status s;if((s=c)!=OK){error.print(s);exit(1);}}
+
+#define BENCHREL   "probebench"
+#define PROBES     200000
+
+// the DOUBLE key of a record (the hash of doubles adds up their bytes,
+// which spreads these values over the directory well enough)
+#define DKEY(ikey) ((ikey) + 0.5)
+
+// the relation used for the benchmark
+typedef struct {
+  int    ikey;
+  double dkey;
+} BENCHREC;
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Probe the index PROBES times with keys drawn from [0, distinct) and
+// report the throughput. Every probe hashes the key, pins its bucket
+// and compares all the keys of the bucket.
+static void bench(const char* name, Index & index, const Datatype type,
+		  const int distinct)
+{
+  RID rid;
+  long matches = 0;
+
+  srand(1);
+  double start = now();
+  for (int i = 0; i < PROBES; i++) {
+    int ikey = rand() % distinct;
+    double dkey = DKEY(ikey);
+    const void* value = (type == INTEGER) ? (void *)&ikey : (void *)&dkey;
+
+    CALL(index.startScan(value));
+    while (index.scanNext(rid) == OK)
+      matches++;
+    CALL(index.endScan());
+  }
+  double secs = now() - start;
+
+  printf("%-8s %8d probes  %8.1f ns/probe  %10.0f probes/s  %6.2f matches/probe\n",
+	 name, PROBES, secs * 1e9 / PROBES, PROBES / secs, (double)matches / PROBES);
+}
+
+// Microbenchmark for the bucket probe of the hash index. Usage:
+//   probebench dbname [records] [distinct keys]
+// The database directory is created (like dbcreate) and left behind.
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    cerr << "Usage: " << argv[0] << " dbname [records] [distinct keys]" << endl;
+    return 1;
+  }
+  const int recCnt = argc > 2 ? atoi(argv[2]) : 5000;
+  const int distinct = argc > 3 ? atoi(argv[3]) : 500;
+
+  if (mkdir(argv[1], S_IRUSR | S_IWUSR | S_IXUSR) < 0) {
+    perror("mkdir");
+    exit(1);
+  }
+  if (chdir(argv[1]) < 0) {
+    perror("chdir");
+    exit(1);
+  }
+
+  bufMgr = new BufMgr(100);
+
+#if defined(__AVX512F__)
+  cout << "SIMD probe: AVX-512" << endl;
+#elif defined(__AVX2__)
+  cout << "SIMD probe: AVX2" << endl;
+#elif defined(__SSE2__)
+  cout << "SIMD probe: SSE2" << endl;
+#else
+  cout << "SIMD probe: none (scalar)" << endl;
+#endif
+
+  Status status;
+  {
+    HeapFile hf(BENCHREL, status);
+    CALL(status);
+
+    srand(0);
+    for (int i = 0; i < recCnt; i++) {
+      BENCHREC rec;
+      rec.ikey = rand() % distinct;
+      rec.dkey = DKEY(rec.ikey);
+      Record r = {&rec, sizeof(BENCHREC)};
+      RID rid;
+      CALL(hf.insertRecord(r, rid));
+    }
+  }
+
+  cout << recCnt << " records, " << distinct << " distinct keys" << endl;
+  {
+    Index iindex(BENCHREL, 0, sizeof(int), INTEGER, NONUNIQUE, status);
+    CALL(status);
+    bench("INTEGER", iindex, INTEGER, distinct);
+  }
+  {
+    Index dindex(BENCHREL, offsetof(BENCHREC, dkey), sizeof(double), DOUBLE, NONUNIQUE, status);
+    CALL(status);
+    bench("DOUBLE", dindex, DOUBLE, distinct);
+  }
+
+  delete bufMgr;
+  return 0;
+}
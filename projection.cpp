@@ -0,0 +1,71 @@
+#include <cstring>
+#include "projection.h"
+
+
+Projection::Projection(const int projCnt, const AttrDesc projNames[],
+		       const int reclen)
+  : tuple(reclen > 0 ? reclen : 1)
+{
+  compile(NULL, projCnt, projNames);
+}
+
+
+Projection::Projection(const string & relName1, const int projCnt,
+		       const AttrDesc projNames[], const int reclen)
+  : tuple(reclen > 0 ? reclen : 1)
+{
+  compile(&relName1, projCnt, projNames);
+}
+
+
+// Turn the projection list into copy operations, the output attributes
+// following each other. An attribute that continues the previous copy
+// on the same side extends it.
+
+void Projection::compile(const string* relName1, const int projCnt,
+			 const AttrDesc projNames[])
+{
+  int dstOffset = 0;
+
+  for (int i = 0; i < projCnt; i++) {
+    PROJOP op;
+    op.side = (relName1 && *relName1 != projNames[i].relName) ? 1 : 0;
+    op.srcOffset = projNames[i].attrOffset;
+    op.dstOffset = dstOffset;
+    op.length = projNames[i].attrLen;
+    dstOffset += op.length;
+
+    if (!ops.empty()) {
+      PROJOP & last = ops.back();
+      if (last.side == op.side && last.srcOffset + last.length == op.srcOffset) {
+	last.length += op.length;
+	continue;
+      }
+    }
+    ops.push_back(op);
+  }
+}
+
+
+const char* Projection::project(const void* tuple1, const void* tuple2)
+{
+  const char* side[2] = {(const char *)tuple1, (const char *)tuple2};
+
+  for (unsigned int i = 0; i < ops.size(); i++) {
+    const PROJOP & op = ops[i];
+    memcpy(&tuple[op.dstOffset], side[op.side] + op.srcOffset, op.length);
+  }
+
+  return &tuple[0];
+}
+
+
+const Status Projection::insert(HeapFile & result, const void* tuple1,
+				const void* tuple2)
+{
+  project(tuple1, tuple2);
+
+  RID rid;
+  Record rec = {&tuple[0], (int)tuple.size()};
+  return result.insertRecord(rec, rid);
+}
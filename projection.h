@@ -0,0 +1,59 @@
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include <vector>
+#include "heapfile.h"
+#include "catalog.h"
+
+// One copy operation of a compiled projection: length bytes at
+// srcOffset of the input tuple of the given side go to dstOffset of
+// the output tuple.
+typedef struct {
+  int side;                             // 0: first input tuple, 1: second
+  int srcOffset;                        // offset in the input tuple
+  int dstOffset;                        // offset in the output tuple
+  int length;                           // # of bytes to copy
+} PROJOP;
+
+
+// A projection list compiled once per query into copy operations.
+// Attributes that are adjacent in both the input and the output tuple
+// are copied together, so projecting all the attributes of a relation
+// in order is a single copy. The output tuple is assembled in a buffer
+// owned by the projection and inserted into the result heap file.
+
+class Projection {
+ public:
+  // projection of the tuples of one relation
+  Projection(const int projCnt,              // # of attributes in the projection
+	     const AttrDesc projNames[],     // the projection list
+	     const int reclen);              // length of an output tuple
+
+  // projection of joined pairs of tuples: the attributes of relName1
+  // come from the first tuple, all the others from the second
+  Projection(const string & relName1,        // relation of the first tuple
+	     const int projCnt,              // # of attributes in the projection
+	     const AttrDesc projNames[],     // the projection list
+	     const int reclen);              // length of an output tuple
+
+  // project the input tuple(s); the output tuple stays valid until
+  // the next call
+  const char* project(const void* tuple1,
+		      const void* tuple2 = NULL);
+
+  // project the input tuple(s) and insert the result into result
+  const Status insert(HeapFile & result,
+		      const void* tuple1,
+		      const void* tuple2 = NULL);
+
+  const int getLength() const { return tuple.size(); }
+
+ private:
+  void compile(const string* relName1, const int projCnt,
+	       const AttrDesc projNames[]);
+
+  std::vector<PROJOP> ops;              // the copy operations
+  std::vector<char> tuple;              // the output tuple
+};
+
+#endif
@@ -1,13 +1,70 @@
 #ifndef QUERY_H
 #define QUERY_H
 
+#include <vector>
 #include "heapfile.h"
 #include "index.h"
+#include "catalog.h"
+#include "bloom.h"
+
+// Index lookups first collect the matching RIDs and sort them in page order
+// so that every heap page is fetched at most once. If more than this fraction
+// of the heap pages would be touched, a plain sequential scan is used instead.
+#define BITMAP_SCAN_THRESHOLD 0.5
 
 //
 // Prototypes for query layer functions
 //
 
+// One conjunct of a conjunctive selection predicate: attr op attrValue
+typedef struct {
+  attrInfo attr;                        // attribute in the predicate
+  Operator op;                          // predicate operation
+  const void *attrValue;                // literal value in the predicate
+} predInfo;
+
+// A conjunct after the attribute has been looked up in the catalog
+typedef struct {
+  AttrDesc attrDesc;                    // attribute in the predicate
+  Operator op;                          // predicate operation
+  const void *attrValue;                // literal value in the predicate
+} PredDesc;
+
+// One predicate of a multi-way join: attr1 op attr2
+typedef struct {
+  attrInfo attr1;                       // left attr in the join predicate
+  Operator op;                          // predicate operation
+  attrInfo attr2;                       // right attr in the join predicate
+} joinInfo;
+
+// Hash aggregation keeps its groups in memory as long as they fit in the
+// unpinned buffer pages; the tuples of the groups that do not fit are
+// sent by hash to AGGPARTITIONS temporary files, which are aggregated
+// in turn. Partitions still too large after AGGMAXLEVELS levels are
+// aggregated by sorting them.
+#define AGGPARTITIONS 8
+#define AGGMAXLEVELS  3
+
+// The aggregate functions
+enum AggFunc { AGG_COUNT, AGG_SUM, AGG_AVG, AGG_MIN, AGG_MAX };
+
+// One aggregate of an aggregation: func(attr). For COUNT(*) the
+// attribute name is empty (the relation name is still needed).
+typedef struct {
+  AggFunc func;                         // the aggregate function
+  attrInfo attr;                        // attribute aggregated
+} aggInfo;
+
+// An aggregate after its attribute has been looked up in the catalog
+typedef struct {
+  AggFunc func;                         // the aggregate function
+  AttrDesc attrDesc;                    // attribute aggregated (COUNT(*): any)
+  int offset;                           // offset of the value in the result tuple
+} AggDesc;
+
+class Iterator;                         // a plan of the execution engine (exec.h)
+class CrackerIndex;                     // an adaptive index (adaptive.h)
+
 //
 // The class for encapsulating the query operators: selects and joins
 // Projections are folded into the selects and joins
@@ -31,6 +88,15 @@ public:
 		       const void *attrValue);    // literal value in the predicate
 #endif // BTREE_INDEX
 
+  // The select operator for a conjunction of predicates on one relation.
+  // If a composite index has all of its key attributes bound by
+  // equality predicates, the index is used; otherwise the relation is scanned.
+  static Status Select(const string & result,      // name of the output relation
+	               const int projCnt,          // number of attributes in the projection
+		       const attrInfo projNames[], // the list of projection attributes
+		       const int predCnt,          // number of predicates (ANDed together)
+		       const predInfo preds[]);    // the predicates
+
    // The join operator
    static Status Join(const string & result,      // name of the output relation 
                       const int projCnt,          // number of attributes in the projection
@@ -39,6 +105,43 @@ public:
 	              const Operator op,          // the predicate operation 
 	              const attrInfo *attr2);     // right attr in the join predicate
 
+   // The join operator for any number of relations. The relations are
+   // joined in a left-deep pipeline in the order the cost model picks,
+   // and only the final result is written to the output relation.
+   static Status Join(const string & result,      // name of the output relation
+                      const int projCnt,          // number of attributes in the projection
+	              const attrInfo projNames[], // the list of projection attributes
+	              const int relCnt,           // number of relations
+	              const string relNames[],    // the relations
+	              const int joinCnt,          // number of join predicates (ANDed together)
+	              const joinInfo joins[]);    // the join predicates
+
+   // The aggregation operator: the tuples of a relation are grouped on
+   // the grouping attributes and the aggregates computed for each group.
+   // The output relation has the grouping attributes followed by the
+   // aggregates, in the order given: COUNT as an INTEGER, SUM and AVG as
+   // DOUBLEs, MIN and MAX like their attribute. Without grouping
+   // attributes, the aggregates of the whole relation make up one tuple.
+   // An empty relation has no SUM, AVG, MIN or MAX, and minirel has no
+   // NULLs to stand for them, so it gives no tuple at all unless all the
+   // aggregates are COUNTs, which give one tuple of zeros.
+   static Status Aggregate(const string & result,      // name of the output relation
+			   const int groupCnt,         // number of grouping attributes
+			   const attrInfo groupNames[],// the grouping attributes
+			   const int aggCnt,           // number of aggregates
+			   const aggInfo aggs[]);      // the aggregates
+
+   // The order-by operator: the projections of the tuples of a relation
+   // in ascending order of an attribute, only the first limit of them if
+   // limit > 0 (ORDER BY ... LIMIT). The first limit tuples are picked in
+   // one pass with a bounded heap if they fit in the unpinned buffer
+   // pages; the relation is sorted (SortedFile) otherwise.
+   static Status OrderBy(const string & result,      // name of the output relation
+			 const int projCnt,          // number of attributes in the projection
+			 const attrInfo projNames[], // the list of projection attributes
+			 const attrInfo *sortAttr,   // the attribute to order by
+			 const int limit = 0);       // # of tuples wanted, 0 for all
+
 
 private: 
    // Help function 1:
@@ -49,17 +152,74 @@ private:
 				             AttrDesc* proj_n,      // the resulting array
 				             int & reclen);         // the length of the output relation
 
+public:
+  // The help functions below are shared with the iterators of the
+  // execution engine (exec.h).
+
   // Help function 2:
-  // Projection on the fly and insert the result record into the result 
-  // heap file. (from two relations) 
-  static Status ProjectAndInsert(HeapFile &result,                      // result heap file
-		  		 const string &relName1,		// relation 1
-				 const string &relName2,		// relation 2
-				 Record &rec1,				// Record for realtion 1
-				 Record &rec2,				// Record for relation 2
-				 const int projCnt,			// # if attrs
-				 const AttrDesc attrDescArray[],	// Projection list
-				 const int reclen);			// the length of output relation
+  // Probe the index with the given value and collect all the matching RIDs,
+  // sorted in page order unless sorted is false. pageCnt returns the number
+  // of heap pages the RIDs fall on (of page changes along an unsorted list).
+  static Status CollectRIDs(Index &index,                         // index to probe
+		  	    const void *attrValue,                // the value to look up
+			    std::vector<RID> &rids,               // the sorted RID list
+			    int &pageCnt,                         // # of distinct pages in rids
+			    const bool sorted = true);            // sort rids in page order
+
+  // Help function 3:
+  // Whether a Bloom filter built from one join attribute can reduce the
+  // relation of the other: the attributes must have the same type and
+  // length, and DOUBLEs only qualify if exact (matchRec compares them
+  // with a tolerance)
+  static bool SemiJoinApplies(const AttrDesc &attrDesc1,             // one join attribute
+			      const AttrDesc &attrDesc2,             // the other join attribute
+			      const bool exact);                     // the join matches exact values
+
+  // Help function 4:
+  // Add the values of the join attribute of every tuple of its relation
+  // to a Bloom filter
+  static Status BuildBloomFilter(const AttrDesc &buildDesc,          // attribute the filter is built from
+				 BloomFilter &filter);               // the filter
+
+  // Help function 5:
+  // Return the number of tuples in a relation
+  static Status GetRecCnt(const string &relName,                  // the relation
+			  int &recCnt);                           // # of tuples in it
+
+   // true if the record satisfies every predicate in preds
+   static bool MatchPredicates(const Record & rec,         // the record
+			       const int predCnt,          // number of predicates
+			       const PredDesc preds[]);    // the predicates
+
+   // Function to match two record based on the predicate. Returns 0 if the two attributes 
+   // are equal, a negative number if the left (attrDesc1) attribute is less that the right 
+   // attribute, otherwise this function returns a positive number.
+   static int matchRec(const Record & outerRec,     // Left record
+                       const Record & innerRec,     // Right record
+                       const AttrDesc & attrDesc1,  // Left attribute in the predicate
+                       const AttrDesc & attrDesc2); // Right attribute in the predicate
+
+private:
+  // Help function 6:
+  // Run a plan and insert all the tuples it produces into the heap file
+  // result
+  static Status Drain(Iterator &plan,                             // the plan
+		      const string &result);                      // name of the output relation
+
+  // Help function 7:
+  // The projection list of a join for the tuples of a join iterator, in
+  // which the tuple of the relation relName1 (leftLen bytes) comes first:
+  // the offsets of the attributes of the other relation move by leftLen
+  static void JoinLayout(const string &relName1,                  // the left relation
+			 const int leftLen,                       // length of its tuples
+			 const int projCnt,                       // # of attributes in the projection
+			 const AttrDesc attrDescArray[],          // the projection list
+			 AttrDesc layout[]);                      // the list for the joined tuples
+
+  // Help function 8:
+  // Whether the relation of an attribute can be read in the order of the
+  // attribute without sorting it (clustered, or with a current sorted copy)
+  static bool StoredInOrder(const AttrDesc &attrDesc);             // the attribute
    
    
    // A simple scan select using a heap file scan
@@ -82,19 +242,105 @@ private:
                              const Operator op2,
                              const void *attrValue2,
 #endif // BTREE_INDEX
-                             const int reclen);          // length of a tuple in the result relation
+                             const int reclen,           // length of a tuple in the result relation
+                             const bool bitmap);         // fetch the tuples in page order
 
-   // Function to match two record based on the predicate. Returns 0 if the two attributes 
-   // are equal, a negative number if the left (attrDesc1) attribute is less that the right 
-   // attribute, otherwise this function returns a positive number.
-   static int matchRec(const Record & outerRec,     // Left record
-                       const Record & innerRec,     // Right record
-                       const AttrDesc & attrDesc1,  // Left attribute in the predicate
-                       const AttrDesc & attrDesc2); // Right attribute in the predicate
+   // A scan select evaluating a conjunction of predicates
+   static Status ConjScanSelect(const string & result,      // name of the output relation
+				const int projCnt,          // number of attributes in the projection
+				const AttrDesc projNames[], // The projection list (as AttrDesc)
+				const int predCnt,          // number of predicates
+				const PredDesc preds[],     // the predicates
+				const int reclen);          // length of a tuple in the result relation
+
+   // Select using a composite index whose key is bound by equality
+   // predicates; all the predicates are checked on the fetched tuples
+   static Status CompositeIndexSelect(const string & result,      // name of the output relation
+				      const int projCnt,          // number of attributes in the projection
+				      const AttrDesc projNames[], // The projection list (as AttrDesc)
+				      Index & iscan,              // the composite index
+				      const void *key,            // the key to look up (see Index::makeKey)
+				      const int predCnt,          // number of predicates
+				      const PredDesc preds[],     // the predicates
+				      const int reclen);          // length of a tuple in the result relation
+
+   // Select using the intersection of the RIDs that several indexes
+   // return for equality predicates; the residual predicates are checked
+   // on the fetched tuples
+   static Status IndexIntersectSelect(const string & result,      // name of the output relation
+				      const int projCnt,          // number of attributes in the projection
+				      const AttrDesc projNames[], // The projection list (as AttrDesc)
+				      const int idxCnt,           // number of predicates answered by indexes
+				      const PredDesc idxPreds[],  // those predicates (EQ on indexed attributes)
+				      const int predCnt,          // number of residual predicates
+				      const PredDesc preds[],     // the residual predicates
+				      const int reclen);          // length of a tuple in the result relation
+
+   // Select using the adaptive index on the attribute of the first
+   // predicate; all the predicates are checked on the fetched tuples
+   static Status AdaptiveIndexSelect(const string & result,      // name of the output relation
+				     const int projCnt,          // number of attributes in the projection
+				     const AttrDesc projNames[], // The projection list (as AttrDesc)
+				     CrackerIndex & column,      // the adaptive index
+				     const int predCnt,          // number of predicates
+				     const PredDesc preds[],     // the predicates
+				     const int reclen);          // length of a tuple in the result relation
+
+   // Select using only the entries of a covering index (no heap access)
+   static Status IndexOnlySelect(const string & result,      // name of the output relation
+				 const int projCnt,          // number of attributes in the projection
+				 const AttrDesc projNames[], // The projection list (as AttrDesc)
+				 Index & iscan,              // the covering index on the predicate attribute
+				 const void *attrValue,      // a pointer to the literal value in the predicate
+				 const int reclen);          // length of a tuple in the result relation
+
+   // Hash aggregation of the tuples of a heap file (the relation or one
+   // of the partitions spilled at the level before)
+   static Status HashAggregate(HeapFile & result,          // the output relation
+			       const string & fileName,    // the heap file to aggregate
+			       const int tupleLen,         // length of its tuples
+			       const int groupCnt,         // number of grouping attributes
+			       const AttrDesc groups[],    // the grouping attributes
+			       const int aggCnt,           // number of aggregates
+			       const AggDesc aggs[],       // the aggregates
+			       const int reclen,           // length of a tuple in the result relation
+			       const int level);           // # of partitioning levels above
+
+   // Aggregation of the tuples of a heap file sorted (by a SortedFile) on
+   // a grouping attribute, a run of equal values at a time; the grouping
+   // attributes before it have the same values in all the tuples
+   static Status SortAggregate(HeapFile & result,          // the output relation
+			       const string & fileName,    // the heap file to aggregate
+			       const int tupleLen,         // length of its tuples
+			       const int groupCnt,         // number of grouping attributes (> 0)
+			       const AttrDesc groups[],    // the grouping attributes
+			       const int aggCnt,           // number of aggregates
+			       const AggDesc aggs[],       // the aggregates
+			       const int reclen,           // length of a tuple in the result relation
+			       const int sortGroup,        // the grouping attribute to sort on
+			       const bool cache);          // use a sorted copy or clustering
+
+   // ORDER BY ... LIMIT with a max-heap of the limit smallest tuples seen
+   // so far, which a tuple only enters if it is smaller than the largest
+   static Status TopN(const string & result,      // name of the output relation
+		      const int projCnt,          // number of attributes in the projection
+		      const AttrDesc projNames[], // The projection list (as AttrDesc)
+		      const AttrDesc & sortDesc,  // the attribute to order by
+		      const int limit,            // # of tuples wanted (> 0)
+		      const int reclen);          // length of a tuple in the result relation
+
+   // ORDER BY by sorting the relation, stopping after limit tuples if
+   // limit > 0
+   static Status SortOrderBy(const string & result,      // name of the output relation
+			     const int projCnt,          // number of attributes in the projection
+			     const AttrDesc projNames[], // The projection list (as AttrDesc)
+			     const AttrDesc & sortDesc,  // the attribute to order by
+			     const int limit,            // # of tuples wanted, 0 for all
+			     const int reclen);          // length of a tuple in the result relation
 
    // The various join algorithms are declared below.
-   // Simple nested loops
-   static Status SNL(const string & result,          // output relation name
+   // Block nested loops
+   static Status BNL(const string & result,          // output relation name
 	             const int projCnt,              // number of attributes in the projection
                      const AttrDesc attrDescArray[], // The projection list (as AttrDesc)
                      const AttrDesc & attrDesc1,     // The left attribute in the join predicate
@@ -119,6 +365,24 @@ private:
                      const Operator op,              // The join operation
                      const AttrDesc & attrDesc2,     // The left attribute in the join predicate
                      const int reclen);              // The lenght of a tuple in the result relation
+
+   // In-memory hash join, building on the right relation
+   static Status HJ(const string & result,          // output relation name
+	            const int projCnt,              // number of attributes in the projection
+                    const AttrDesc attrDescArray[], // The projection list (as AttrDesc)
+                    const AttrDesc & attrDesc1,     // The left attribute in the join predicate
+                    const Operator op,              // The join operation
+                    const AttrDesc & attrDesc2,     // The left attribute in the join predicate
+                    const int reclen);              // The lenght of a tuple in the result relation
+
+   // Band (range) merge join for inequality predicates
+   static Status BMJ(const string & result,          // output relation name
+	             const int projCnt,              // number of attributes in the projection
+                     const AttrDesc attrDescArray[], // The projection list (as AttrDesc)
+                     const AttrDesc & attrDesc1,     // The left attribute in the join predicate
+                     const Operator op,              // The join operation
+                     const AttrDesc & attrDesc2,     // The left attribute in the join predicate
+                     const int reclen);              // The lenght of a tuple in the result relation
 };
 
 
@@ -1,6 +1,8 @@
 #include "catalog.h"
 #include "query.h"
 #include "index.h"
+#include "exec.h"
+#include "adaptive.h"
 #include <cstdlib>
 #include <cstring>
 
@@ -17,80 +19,32 @@ Status Operators::ScanSelect(const string& result,       // Name of the output r
                              const int reclen)           // Length of a tuple in the result relation
 {
   	cout << "Algorithm: File Scan" << endl;
-  
-	Status status;
-	
-	// get the heapfile for the relation
-	string relName(projNames[0].relName);
 
-	// create or open the heapfile which stores the resulting data	
-	HeapFile hf(result, status);
-	if(status != OK){
-		cerr << "Open heap file for storing the results of heap file scan failed!" << endl;
-		return status;
-	}
+	// the plan: a (filtered) scan of the relation, projected
+	string relName(projNames[0].relName);
 
-	// opend the heap file 
-	// which constructor to use depends on whether it is a filtered scan or not
-	HeapFileScan *hfs = NULL;
+	// an attribute that is filtered on again and again gets an
+	// adaptive index, built by this scan (see adaptive.h)
+	ScanIter *scan = NULL;
 	if(!attrDesc){
-		hfs = new HeapFileScan(relName, status);
+		scan = new ScanIter(relName);
 	}
 	else{
-		const int offset = attrDesc->attrOffset;
-		const int length = attrDesc->attrLen;
-		const Datatype type = static_cast<Datatype>(attrDesc->attrType);
-		const char* filter = (char*)attrValue;
-
-		hfs = new HeapFileScan(relName, offset, length, type, filter, op, status);
-	}
-	
-	if(status != OK){
-		cerr << "Open heap file for filtered HeapFileScan failed!" << endl;
-		delete hfs;
-		return status;
+		scan = new ScanIter(relName, *attrDesc, op, attrValue, noteAdaptiveUse(*attrDesc, op));
 	}
-		
-			
-	// scan the whole heap file and get the projection attrs
-	// insert the reuslts into the result heap file
-	RID outRid;
-	RID lastRid;
-	Record rec;
+	ProjectIter plan(scan, projCnt, projNames, reclen);
 
-	while(hfs->scanNext(outRid, rec) == OK && !(outRid == lastRid)){
-		int tempOffset = 0;
-  		
-		char* result = new char[reclen + 1];
-		result[reclen] = '\0';
-		
-		for(int i = 0; i < projCnt; i ++){
-			char* sou = (char*)rec.data + projNames[i].attrOffset;
-			char* des = &(result[tempOffset]);
-			memcpy(des, sou, projNames[i].attrLen);
+	HeapFileScan::clearScanStats();
+	Status status = Operators::Drain(plan, result);
 
-			tempOffset += projNames[i].attrLen;			
-		}		
-			
-		lastRid = outRid;
-		
-		// pack the result into record and insert it into the result hap file		
-		RID _outRid;
-		Record _rec = {result, reclen};
-		status = hf.insertRecord(_rec, _outRid);	
-
-		delete []result;
-		result = NULL;	
-
-		if(status != OK){
-			delete hfs;
-			return status;
-		}
+	// pages the zone maps of the relation let the scan skip
+	const ScanStats &stats = HeapFileScan::scanStats;
+	if(stats.pagesSkipped > 0){
+		cout << "Zone map: skipped " << stats.pagesSkipped << " of "
+		     << stats.pagesRead + stats.pagesSkipped << " pages" << endl;
 	}
-
-	status = hfs->endScan();
-	if(status != OK)  return status;
-	
-	delete hfs;
-	return OK;
+	if(status == OK && scan->indexBuilt()){
+		cout << "Adaptive index: built on " << relName << "." << attrDesc->attrName << endl;
+	}
+	return status;
 }
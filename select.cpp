@@ -1,6 +1,14 @@
 #include "catalog.h"
 #include "query.h"
 #include "index.h"
+#include "cost.h"
+#include "stats.h"
+#include "adaptive.h"
+#include <algorithm>
+#include <cstring>
+
+// The ways of reading the tuples that satisfy a selection
+enum AccessPath { PATH_SCAN, PATH_INDEX, PATH_BITMAP };
 
 /* 
  * Help function:
@@ -29,6 +37,109 @@ Status Operators::ConvertFromInfoToDesc(const attrInfo* projNames,   // Projecti
 
 
 
+/*
+ * Help function:
+ * 	estimate the # of tuples that satisfy "attrDesc op attrValue", an
+ * 	equality on the attribute of the open index, from the catalog
+ * 	statistics of the attribute (scaled to the current size of the
+ * 	relation), or else by counting the entries in the index bucket of
+ * 	the value. source names the one used.
+ *
+ * Return:
+ * 	OK if success
+ *	Error code otherwise
+ */
+static Status EstimateMatches(Index &index,                 // Index on the attribute
+			      const AttrDesc &attrDesc,     // Attribute in the predicate
+			      const Operator op,            // Predicate operation
+			      const void* attrValue,        // Literal value in the predicate
+			      const double recCnt,          // # of tuples of the relation
+			      double &matches,              // The estimate
+			      const char* &source)          // Where it comes from
+{
+	Status status;
+	AttrStatsDesc desc;
+
+	if(getAttrStats(attrDesc, desc) == OK){
+		matches = estimateSelectivity(desc, op, attrValue) * recCnt;
+		source = "statistics";
+		return OK;
+	}
+
+	RID rid;
+	matches = 0;
+	status = index.startScan(attrValue);
+	if(status != OK) return status;
+	while(index.scanNext(rid) == OK) matches ++;
+	source = "index";
+	return index.endScan();
+}
+
+
+/*
+ * Help function:
+ * 	pick the access path for "attrDesc op attrValue", an equality on an
+ * 	indexed attribute, by estimated I/O (see cost.h). A covering index
+ * 	answers the query from the index alone. The choice is logged with
+ * 	its estimate.
+ *
+ * Return:
+ * 	OK if success
+ *	Error code otherwise
+ */
+static Status ChooseAccessPath(const AttrDesc* projNames,    // Projection list
+			       const int projCnt,            // # of attrs in the projection list
+			       const AttrDesc* attrDesc,     // Attribute in the predicate
+			       const Operator op,            // Predicate operation
+			       const void* attrValue,        // Literal value in the predicate
+			       AccessPath &path)             // The chosen access path
+{
+	Status status;
+
+	HeapFile hf(attrDesc->relName, status);
+	if(status != OK) return status;
+	const double recCnt = hf.getRecCnt();
+	const double pageCnt = hf.getPageCnt();
+
+	Index index(attrDesc->relName, attrDesc->attrOffset, attrDesc->attrLen,
+		    static_cast<Datatype>(attrDesc->attrType), 0, status);
+	if(status != OK) return status;
+
+	double matches;
+	const char* source;
+	status = EstimateMatches(index, *attrDesc, op, attrValue, recCnt, matches, source);
+	if(status != OK) return status;
+
+	bool covered = true;
+	for(int i = 0; i < projCnt; i ++){
+		if(!index.covers(projNames[i].attrOffset, projNames[i].attrLen))
+			covered = false;
+	}
+
+	const double scan = costSeqScan(pageCnt);
+	const double fetch = covered ? 1 : costIndexFetch(matches);
+	const double bitmap = costBitmapFetch(matches, pageCnt);
+
+	double cost = scan;
+	path = PATH_SCAN;
+	if(bitmap < cost){
+		cost = bitmap;
+		path = PATH_BITMAP;
+	}
+	if(fetch <= cost){
+		cost = fetch;
+		path = PATH_INDEX;
+	}
+
+	const char* name = (path == PATH_SCAN) ? "File Scan"
+			 : (path == PATH_BITMAP) ? "Bitmap Index Select"
+			 : covered ? "Index Only Select" : "Index Select";
+	cout << "Access path: " << name << " (~" << (int)(matches + 0.5) << " of " << recCnt
+	     << " tuples from " << source << ", ~" << cost << " page reads)" << endl;
+	return OK;
+}
+
+
 /*
  * Selects records from the specified relation.
  *
@@ -73,16 +184,35 @@ Status Operators::Select(const string & result,      // name of the output relat
 		}
 	}	
 
-	// if it meets the two requirements of index select:
-	// 1. the attribute in the predicate is indexed
-	// 2. operation is Equality
+	// the hash index can only answer an equality; if there is one, the
+	// cheapest of an index fetch, a bitmap fetch and a scan is used
+	AccessPath path = PATH_SCAN;
 	if(relAttrs && relAttrs->indexed == 1 && op == EQ){
-		status = Operators::IndexSelect(result, projCnt, proj_n, relAttrs, op, attrValue, reclen);
+		status = ChooseAccessPath(proj_n, projCnt, relAttrs, op, attrValue, path);
+		if(status != OK){
+			delete relAttrs;
+			delete []proj_n;
+			return status;
+		}
 	}
-	// otherwise, just use scan select
-	else{
+
+	// without a usable index, the attribute may have an adaptive one
+	CrackerIndex* column = NULL;
+	if(path == PATH_SCAN && relAttrs && op != NE){
+		column = findAdaptiveIndex(*relAttrs);
+	}
+
+	if(column){
+		PredDesc pred = {*relAttrs, op, attrValue};
+		status = Operators::AdaptiveIndexSelect(result, projCnt, proj_n, *column, 1, &pred, reclen);
+	}
+	else if(path == PATH_SCAN){
 		status = Operators::ScanSelect(result, projCnt, proj_n, relAttrs, op, attrValue, reclen);
-	}	
+	}
+	else{
+		status = Operators::IndexSelect(result, projCnt, proj_n, relAttrs, op, attrValue, reclen,
+						path == PATH_BITMAP);
+	}
 	
 	if(relAttrs) delete relAttrs;
 	delete []proj_n;
@@ -91,3 +221,262 @@ Status Operators::Select(const string & result,      // name of the output relat
 }
 
 
+
+
+
+/*
+ * Help function:
+ * 	order a conjunction of predicates so that those most likely to
+ * 	reject a tuple for the least work are checked first: by increasing
+ * 	(selectivity - 1) / cost (see cost.h). The first predicate is the
+ * 	one a scan pushes into the heap file scan.
+ */
+static void OrderPredicates(const int predCnt,       // # of predicates
+			    PredDesc preds[])        // The predicates, reordered
+{
+	vector<pair<double, int> > ranks(predCnt);
+	for(int i = 0; i < predCnt; i ++){
+		const double sel = selectivity(preds[i].attrDesc, preds[i].op, preds[i].attrValue);
+		ranks[i] = make_pair((sel - 1) / predicateCost(preds[i].attrDesc), i);
+	}
+	stable_sort(ranks.begin(), ranks.end());
+
+	vector<PredDesc> ordered(predCnt);
+	for(int i = 0; i < predCnt; i ++){
+		ordered[i] = preds[ranks[i].second];
+	}
+	copy(ordered.begin(), ordered.end(), preds);
+}
+
+
+/*
+ * Help function:
+ * 	pick the equality predicates on indexed attributes whose indexes
+ * 	to intersect before fetching any tuples. The indexes are taken in
+ * 	order of the selectivity of their predicates for as long as one more
+ * 	probe saves more page reads than it costs, with the predicates taken
+ * 	to be independent; none if a scan is cheaper. The other predicates
+ * 	are the residual ones, in their order. The choice is logged with its
+ * 	estimate.
+ *
+ * Return:
+ * 	OK if success
+ *	Error code otherwise
+ */
+static Status ChooseIndexes(const int predCnt,                // # of predicates
+			    const PredDesc preds[],           // The predicates
+			    vector<PredDesc> &idxPreds,       // Those answered by indexes
+			    vector<PredDesc> &residual)       // The others
+{
+	Status status;
+
+	HeapFile hf(preds[0].attrDesc.relName, status);
+	if(status != OK) return status;
+	const double recCnt = hf.getRecCnt();
+	const double pageCnt = hf.getPageCnt();
+
+	// the candidates (one per attribute), by selectivity
+	vector<pair<double, int> > cands;
+	for(int i = 0; i < predCnt; i ++){
+		const AttrDesc &attr = preds[i].attrDesc;
+		if(preds[i].op != EQ || attr.indexed != 1) continue;
+
+		bool dup = false;
+		for(unsigned int c = 0; c < cands.size(); c ++){
+			if(preds[cands[c].second].attrDesc.attrOffset == attr.attrOffset) dup = true;
+		}
+		if(dup) continue;
+
+		Index index(attr.relName, attr.attrOffset, attr.attrLen,
+			    static_cast<Datatype>(attr.attrType), 0, status);
+		if(status != OK) return status;
+
+		double matches;
+		const char* source;
+		status = EstimateMatches(index, attr, preds[i].op, preds[i].attrValue, recCnt, matches, source);
+		if(status != OK) return status;
+
+		cands.push_back(make_pair(recCnt > 0 ? matches / recCnt : 0, i));
+	}
+	sort(cands.begin(), cands.end());
+
+	// each probe reads a bucket page (counted in costBitmapFetch for the first)
+	double cost = costSeqScan(pageCnt);
+	double matches = recCnt;
+	double fraction = 1;
+	unsigned int useCnt = 0;
+	for(unsigned int c = 0; c < cands.size(); c ++){
+		fraction *= cands[c].first;
+		const double intersect = c + costBitmapFetch(recCnt * fraction, pageCnt);
+		if(intersect < cost){
+			cost = intersect;
+			matches = recCnt * fraction;
+			useCnt = c + 1;
+		}
+	}
+
+	vector<bool> used(predCnt, false);
+	for(unsigned int c = 0; c < useCnt; c ++){
+		idxPreds.push_back(preds[cands[c].second]);
+		used[cands[c].second] = true;
+	}
+	for(int i = 0; i < predCnt; i ++){
+		if(!used[i]) residual.push_back(preds[i]);
+	}
+
+	cout << "Access path: ";
+	if(useCnt == 0)
+		cout << "File Scan";
+	else if(useCnt == 1)
+		cout << "Bitmap Index Select on " << idxPreds[0].attrDesc.attrName;
+	else{
+		cout << "Index Intersection Select on " << idxPreds[0].attrDesc.attrName;
+		for(unsigned int c = 1; c < useCnt; c ++) cout << ", " << idxPreds[c].attrDesc.attrName;
+	}
+	cout << " (~" << (int)(matches + 0.5) << " of " << recCnt << " tuples, ~" << cost << " page reads)" << endl;
+	return OK;
+}
+
+
+/*
+ * Selects records from the specified relation using a conjunction of
+ * predicates.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise
+ */
+Status Operators::Select(const string & result,      // name of the output relation
+	                 const int projCnt,          // number of attributes in the projection
+		         const attrInfo projNames[], // the list of projection attributes
+		         const int predCnt,          // number of predicates (ANDed together)
+		         const predInfo preds[])     // the predicates
+{
+	Status status;
+
+	// zero or one predicate: nothing to combine
+	if(predCnt == 0){
+		return Operators::Select(result, projCnt, projNames, NULL, EQ, NULL);
+	}
+	if(predCnt == 1){
+		return Operators::Select(result, projCnt, projNames, &preds[0].attr,
+					 preds[0].op, preds[0].attrValue);
+	}
+
+	// convert the predicates and the projection list to AttrDesc
+	PredDesc* pred_n = new PredDesc[predCnt];
+	for(int i = 0; i < predCnt; i ++){
+		status = attrCat->getInfo(preds[i].attr.relName, preds[i].attr.attrName, pred_n[i].attrDesc);
+		if(status != OK){
+			delete []pred_n;
+			return status;
+		}
+		pred_n[i].op = preds[i].op;
+		pred_n[i].attrValue = preds[i].attrValue;
+	}
+
+	OrderPredicates(predCnt, pred_n);
+
+	int reclen = 0;
+	AttrDesc* proj_n = new AttrDesc[projCnt];
+	status = Operators::ConvertFromInfoToDesc(projNames, projCnt, proj_n, reclen);
+	if(status != OK){
+		delete []pred_n;
+		delete []proj_n;
+		return status;
+	}
+
+	// look for the composite index with the longest key that is bound
+	// by equality predicates
+	int indexCnt = 0;
+	CompIndexDesc* indexes;
+	CompIndexCatalog compCat(status);
+	if(status == OK)
+		status = compCat.getRelInfo(proj_n[0].relName, indexCnt, indexes);
+	if(status != OK){
+		delete []pred_n;
+		delete []proj_n;
+		return status;
+	}
+
+	int best = -1;
+	const void* values[MAXKEYATTRS];
+	for(int k = 0; k < indexCnt; k ++){
+		if(best >= 0 && indexes[k].keyCnt <= indexes[best].keyCnt) continue;
+
+		bool bound = true;
+		for(int j = 0; bound && j < indexes[k].keyCnt; j ++){
+			bound = false;
+			for(int i = 0; i < predCnt; i ++){
+				if(pred_n[i].op == EQ
+				   && !strcmp(pred_n[i].attrDesc.attrName, indexes[k].attrName[j])){
+					bound = true;
+					break;
+				}
+			}
+		}
+		if(bound) best = k;
+	}
+
+	Index* iscan = NULL;
+	if(best >= 0){
+		status = compCat.openIndex(indexes[best], iscan);
+		if(status != OK) iscan = NULL;
+	}
+
+	if(iscan){
+		// build the key from the literals, in key order
+		for(int j = 0; j < indexes[best].keyCnt; j ++){
+			for(int i = 0; i < predCnt; i ++){
+				if(pred_n[i].op == EQ
+				   && !strcmp(pred_n[i].attrDesc.attrName, indexes[best].attrName[j])){
+					values[j] = pred_n[i].attrValue;
+					break;
+				}
+			}
+		}
+		char key[PAGESIZE];
+		iscan->makeKey(values, key);
+
+		status = Operators::CompositeIndexSelect(result, projCnt, proj_n, *iscan, key,
+							 predCnt, pred_n, reclen);
+		delete iscan;
+	}
+	// otherwise intersect the RIDs from the indexes on the attributes
+	// of equality predicates, or use the adaptive index of the first
+	// predicate that has one, or scan the relation
+	else{
+		vector<PredDesc> idxPreds, residual;
+		status = ChooseIndexes(predCnt, pred_n, idxPreds, residual);
+
+		int adaptive = -1;
+		CrackerIndex* column = NULL;
+		for(int i = 0; status == OK && idxPreds.empty() && !column && i < predCnt; i ++){
+			if(pred_n[i].op == NE) continue;
+			column = findAdaptiveIndex(pred_n[i].attrDesc);
+			adaptive = i;
+		}
+
+		if(status == OK && !idxPreds.empty()){
+			status = Operators::IndexIntersectSelect(result, projCnt, proj_n,
+								 idxPreds.size(), &idxPreds[0],
+								 residual.size(), residual.empty() ? NULL : &residual[0],
+								 reclen);
+		}
+		else if(status == OK && column){
+			// its predicate goes first
+			rotate(pred_n, pred_n + adaptive, pred_n + adaptive + 1);
+			status = Operators::AdaptiveIndexSelect(result, projCnt, proj_n, *column,
+								predCnt, pred_n, reclen);
+		}
+		else if(status == OK){
+			status = Operators::ConjScanSelect(result, projCnt, proj_n, predCnt, pred_n, reclen);
+		}
+	}
+
+	if(indexCnt > 0) delete []indexes;
+	delete []pred_n;
+	delete []proj_n;
+
+	return status;
+}
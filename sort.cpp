@@ -1,85 +1,182 @@
 #include <sstream>
+#include <algorithm>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "sort.h"
+#include "normkey.h"
+#include "sortkernel.h"
+#include "catalog.h"
+#include "bloom.h"
 
-#define MIN(a,b)   ((a) < (b) ? (a) : (b))
+// The heap functions of <algorithm> keep the largest element on
+// top; replacement selection wants the smallest.
 
+class HeapOrder {
+ public:
+  HeapOrder(const SortRecLess & less) : less(less) {}
 
-// These comparison functions are visible only within this
-// source file. reccmp is the comparison routine (much like
-// strcmp or memcmp) that accepts integers, floats, and strings.
-// It returns -1 if p1 is less than p2, +1 if p1 is greater
-// than p2, or zero otherwise.
+  bool operator()(const SORTREC & r1, const SORTREC & r2) const
+  {
+    return less(r2, r1);
+  }
+
+ private:
+  SortRecLess less;
+};
+
+
+// Sorts an array of SORTRECs with several threads. A sample of the
+// keys gives one splitter per thread boundary; the items are then
+// partitioned on the splitters into one bucket per thread, each
+// thread sorts its bucket, and the buckets in order are the sorted
+// array, so no merge is needed. Classifying and scattering the items
+// are split over the threads as well. The threads only touch memory:
+// the buffer manager is not thread-safe, so all the file I/O of the
+// sort stays with the calling thread.
+
+#define SAMPLESPERTHREAD 32
+
+class ParallelSort {
+ public:
+  ParallelSort(SORTREC* items, int n, int threadCnt, const SortRecLess & less)
+    : items(items), n(n), threadCnt(threadCnt), less(less),
+      bucket(n), count(threadCnt * threadCnt), start(threadCnt + 1) {}
+
+  void run();
+
+ private:
+  typedef void (ParallelSort::*Phase)(int);
+
+  typedef struct {
+    ParallelSort* sort;
+    Phase phase;
+    int id;
+  } WORKER;
 
-static int reccmp(char* p1, char* p2, int p1Len, int p2Len, Datatype type)
+  static void* work(void* arg);
+  void runPhase(Phase phase);           // run phase(id) for every thread id
+
+  void classify(int id);                // find the bucket of each item of a slice
+  void scatter(int id);                 // move the items of a slice to their buckets
+  void sortBucket(int id);              // sort one bucket
+
+  int sliceBegin(int id) const { return (long long)n * id / threadCnt; }
+
+  SORTREC* items;                       // the items to sort
+  int n;                                // # of items
+  int threadCnt;                        // # of threads (and buckets)
+  SortRecLess less;
+  std::vector<SORTREC> splitters;       // upper bounds of buckets 0..threadCnt-2
+  std::vector<unsigned char> bucket;    // bucket of each item
+  std::vector<int> count;               // # of items of slice t in bucket b,
+                                        // then where the next one goes
+  std::vector<int> start;               // first position of each bucket
+  std::vector<SORTREC> sorted;          // the items partitioned into buckets
+};
+
+
+void* ParallelSort::work(void* arg)
 {
-  float diff = 0.0;
-
-  switch(type) {
-  case INTEGER:
-    int iattr, ifltr;                   // word-alignment problem possible
-    memcpy(&iattr, p1, sizeof(int));
-    memcpy(&ifltr, p2, sizeof(int));
-    diff = iattr - ifltr;
-    break;
-  case DOUBLE:
-    double fattr, ffltr;                 // word-alignment problem possible
-    memcpy(&fattr, p1, sizeof(double));
-    memcpy(&ffltr, p2, sizeof(double));
-    diff = fattr - ffltr;
-    break;
-  case STRING:
-    diff = memcmp(p1, p2, MIN(p1Len, p2Len));
-    break;
-  default:
-    break;
+  WORKER* worker = (WORKER*)arg;
+  (worker->sort->*(worker->phase))(worker->id);
+  return NULL;
+}
+
+
+// Run a phase on threadCnt threads and wait for all of them. The
+// calling thread takes the first share; if a thread cannot be
+// started, its share is done by the calling thread too.
+
+void ParallelSort::runPhase(Phase phase)
+{
+  std::vector<pthread_t> threads(threadCnt);
+  std::vector<WORKER> workers(threadCnt);
+  std::vector<bool> started(threadCnt, false);
+
+  for(int t = 1; t < threadCnt; t++) {
+    WORKER worker = {this, phase, t};
+    workers[t] = worker;
+    started[t] = pthread_create(&threads[t], NULL, work, &workers[t]) == 0;
   }
 
-  if (diff < 0)
-    diff = -1;
-  else if (diff > 0)
-    diff = 1;
+  (this->*phase)(0);
 
-  return (int)diff;
+  for(int t = 1; t < threadCnt; t++) {
+    if (started[t])
+      pthread_join(threads[t], NULL);
+    else
+      (this->*phase)(t);
+  }
 }
 
 
-// These three comparison routines are jacketed versions of
-// reccmp. This is because qsort(3) takes only a function pointer
-// but no additional parameters. The objects pointed to by p1
-// and p2 are of type SORTREC which has a pointer to the field
-// to be compared as well as its length (used for strings).
+void ParallelSort::run()
+{
+  // Choose the splitters from an evenly spaced sample of the items.
+
+  const int sampleCnt = threadCnt * SAMPLESPERTHREAD;
+  std::vector<SORTREC> sample(sampleCnt);
+  for(int i = 0; i < sampleCnt; i++)
+    sample[i] = items[(long long)n * i / sampleCnt];
+  sort(sample.begin(), sample.end(), less);
+
+  for(int b = 1; b < threadCnt; b++)
+    splitters.push_back(sample[b * SAMPLESPERTHREAD]);
 
-#define SR(p)  ((SORTREC*)p)
+  runPhase(&ParallelSort::classify);
+
+  // Bucket b starts after all the items of buckets 0..b-1; within a
+  // bucket the items of slice t follow those of slices 0..t-1.
+
+  int pos = 0;
+  for(int b = 0; b < threadCnt; b++) {
+    start[b] = pos;
+    for(int t = 0; t < threadCnt; t++) {
+      int cnt = count[t * threadCnt + b];
+      count[t * threadCnt + b] = pos;
+      pos += cnt;
+    }
+  }
+  start[threadCnt] = pos;
 
-static int intcmp(const void* p1, const void* p2)
+  sorted.resize(n);
+  runPhase(&ParallelSort::scatter);
+  runPhase(&ParallelSort::sortBucket);
+
+  memcpy(items, &sorted[0], n * sizeof(SORTREC));
+}
+
+
+void ParallelSort::classify(int id)
 {
- p1 = (char*) p1;
- p2 = (char*) p2;
-  return reccmp(SR(p1)->field, SR(p2)->field,
-		SR(p1)->length, SR(p2)->length,
-		INTEGER);
+  int* cnt = &count[id * threadCnt];
+
+  for(int b = 0; b < threadCnt; b++)
+    cnt[b] = 0;
+
+  for(int i = sliceBegin(id); i < sliceBegin(id + 1); i++) {
+    int b = upper_bound(splitters.begin(), splitters.end(), items[i], less)
+            - splitters.begin();
+    bucket[i] = b;
+    cnt[b]++;
+  }
 }
 
 
-static int floatcmp(const void* p1, const void* p2)
+void ParallelSort::scatter(int id)
 {
- p1 = (char*) p1;
- p2 = (char*) p2;
-  return reccmp(SR(p1)->field, SR(p2)->field,
-		SR(p1)->length, SR(p2)->length,
-		DOUBLE);
+  int* pos = &count[id * threadCnt];
+
+  for(int i = sliceBegin(id); i < sliceBegin(id + 1); i++)
+    sorted[pos[bucket[i]]++] = items[i];
 }
 
 
-static int stringcmp(const void* p1, const void* p2)
+void ParallelSort::sortBucket(int id)
 {
- p1 = (char*) p1;
- p2 = (char*) p2;
-  return reccmp(SR(p1)->field, SR(p2)->field,
-		SR(p1)->length, SR(p2)->length,
-		STRING);
+  sortRecs(&sorted[0] + start[id], start[id + 1] - start[id], less);
 }
 
 
@@ -87,14 +184,30 @@ static int stringcmp(const void* p1, const void* p2)
 // Sorting is based on attribute that is defined by offset, len,
 // and type. maxItems is the maximum number of items that a sorted
 // sub-run can hold (usually derived from amount of memory available).
+// maxFrames is the number of buffer pool frames the merge may keep
+// pinned (0: half of the frames unpinned when the merge starts),
+// runGen selects how the sub-runs are formed, and with cache a
+// result that comes out as a single run is kept as a sorted copy (see
+// SortCatalog), which later sorts of the unchanged relation read
+// instead. The tuples whose sort attribute a given filter rejects are
+// left out (unless a sorted copy is read); such a sort keeps no copy.
 // Status code is returned in variable status.
 
 SortedFile::SortedFile(const string & fileName, 
 		       int offset, int len, Datatype type,
-		       int maxItems, Status& status)
+		       int maxItems, Status& status, int maxFrames,
+		       RunGenerator runGen, bool cache, BloomFilter* filter)
       : fileName(fileName), type(type), offset(offset), 
-	length(len), maxItems(maxItems)
+	length(len), buffer(NULL), arena(NULL), arenaSize(0),
+	maxItems(maxItems), maxFrames(maxFrames), runGen(runGen),
+	cache(cache), keepRun(false), filter(filter)
 {
+  stats.runCnt = 0;
+  stats.passCnt = 0;
+  stats.threadCnt = 1;
+  stats.fromCache = false;
+  stats.clustered = false;
+
   // Check incoming parameters.
 
   status = OK;
@@ -124,13 +237,12 @@ SortedFile::SortedFile(const string & fileName,
 
 // Sort file into sub-runs. The source file is split into runs
 // which have at most maxItems records each. That many records
-// are read into memory, sorted using qsort(3), and then written
-// to a temporary file.
+// are copied into the arena, sorted, and then written to a
+// temporary file in one sequential pass.
 
 Status SortedFile::sortFile()
 {
   Status status;
-  Record rec;
 
   // Open source file.
 
@@ -142,34 +254,39 @@ Status SortedFile::sortFile()
   if (status != OK)
     return status;
 
+  // A sorted copy made from the current version of the file is
+  // read instead of sorting again.
+
+  const int fileId = file->getFileId();
+  const int version = file->getVersion();
+
+  if (cache) {
+    if ((status = findCopy(fileId, version)) != OK)
+      return status;
+    if (keepRun) {
+      delete file;
+      stats.fromCache = true;
+      return startScans();
+    }
+  }
+
   // As long as the source file has more records, collect up to
   // maxItems records into buffer and then dump records into
   // temporary file.
 
-  do {
+  if (runGen == REPLACEMENT_SELECTION) {
+    if ((status = selectRuns()) != OK)
+      return status;
+  }
+  else do {
     for(numItems = 0; numItems < maxItems; numItems++) {
 
       // Fetch next record from source file, check if end of file.
 
-      if ((status = file->scanNext(buffer[numItems].rid)) == FILEEOF)
+      if ((status = readTuple(numItems, buffer[numItems])) == FILEEOF)
 	break;
       else if (status != OK)
 	return status;
-      if ((status = file->getRecord(buffer[numItems].rid,
-				    rec)) != OK)
-	return status;
-
-      // Create space for holding a copy of the sorting attribute
-      // only (rest of record is read when temporary file is
-      // written). Copy sorting attribute from source record and
-      // store the length of the attribute (reccmp is general-
-      // purpose and can be shared by multiple instances of
-      // SortedFile!).
-
-      if (!(buffer[numItems].field = new char [length]))
-	return INSUFMEM;
-      memcpy(buffer[numItems].field, (char *)rec.data + offset, length);
-      buffer[numItems].length = length;
     }
     
     // If at least 1 record in sub-run, sort records and write out
@@ -178,14 +295,27 @@ Status SortedFile::sortFile()
     if (numItems > 0) {
       if ((status = generateRun(numItems)) != OK)
 	return status;
-      for(int i = 0; i < numItems; i++)
-	delete [] buffer[i].field;
     }
   } while (numItems > 0);
 
   // Terminate sequential scan on source file and close file.
 
   delete file;
+  stats.runCnt = runs.size();
+
+  // Merge the runs down to as many as can be scanned at once.
+
+  if ((status = mergeRuns()) != OK)
+    return status;
+
+  if (cache && !filter && runs.size() == 1
+      && (status = keepCopy(fileId, version)) != OK)
+    return status;
+
+#ifdef DEBUGSORT
+  cout << "%%  " << stats.runCnt << " runs generated, "
+       << stats.passCnt << " merge passes" << endl;
+#endif
 
   // Prepare a sequential scan on each sub-run so that next()
   // can fetch next record from each run.
@@ -197,107 +327,417 @@ Status SortedFile::sortFile()
 }
 
 
-// Sort the records in buffer[] (actually, the sorting attribute
-// plus the associated RID) and then dump records into temporary
-// file.
+// Read the next tuple of the source file (that passes the filter)
+// into slot 'slot' of the arena and set up 'item' for it. Returns
+// FILEEOF at the end of the source file.
 
-Status SortedFile::generateRun(int items)
+Status SortedFile::readTuple(int slot, SORTREC & item)
 {
   Status status;
+  RID rid;
+  Record rec;
 
-  // Sort buffer using library function qsort (quick sort). Use
-  // the appropriate comparison function for integers, floats,
-  // or strings (qsort can't take type as a parameter).
+  do {
+    if ((status = file->scanNext(rid, rec)) != OK)
+      return status;
+  } while (filter && !filter->probe((char *)rec.data + offset));
 
-  if (type == INTEGER)
-    qsort(buffer, items, sizeof(SORTREC), intcmp);
-  else if (type == DOUBLE)
-    qsort(buffer, items, sizeof(SORTREC), floatcmp);
-  else
-    qsort(buffer, items, sizeof(SORTREC), stringcmp);
+  // All the tuples of a relation have the same length, so the
+  // arena is sized by the first one.
 
-  // If this is the first sub-run, malloc space for a RUN object,
-  // otherwise realloc more space. Note that on most systems
-  // realloc(NULL) could be used even when runs == NULL, but
-  // this doesn't work on all systems.
+  if (!arena) {
+    arenaSize = maxItems * rec.length;
+    if (!(arena = new char [arenaSize]))
+      return INSUFMEM;
+  }
+  if ((slot + 1) * rec.length > arenaSize)
+    return BADSORTPARM;
 
-  RUN newRun;
-  runs.push_back(newRun);
+  // Copy the whole tuple into the arena; the run is written from
+  // there, so the source file is read only once.
+
+  item.tuple = arena + slot * rec.length;
+  item.length = rec.length;
+  memcpy(item.tuple, rec.data, rec.length);
+  item.prefix = keyPrefix(item.tuple + offset, type, length);
+  item.run = 0;
+
+  return OK;
+}
+
+
+// Generate the sub-runs by replacement selection. The tuples in
+// memory form a heap ordered on (run, key). The smallest one is
+// appended to the current run and its slot is refilled from the
+// source file; the new tuple joins the current run if its key is
+// not smaller than the key just written, and the next run otherwise.
+// On random input the runs are about twice as long as the memory
+// holds, and input that is already (nearly) sorted becomes one run.
 
-  // If failed to create space for an additional run.
+Status SortedFile::selectRuns()
+{
+  Status status;
+  SortRecLess less(offset, length, type);
+  HeapOrder order(less);
+  vector<char> lastKey(length);         // key of the last tuple written
+  unsigned long long lastPrefix = 0;
+  int runNo = -1;                       // run being written
+  int runLen = 0;                       // # of tuples in it so far
+  bool eof = false;
+
+  // Fill the memory and build the heap.
+
+  for(numItems = 0; numItems < maxItems; numItems++) {
+    if ((status = readTuple(numItems, buffer[numItems])) == FILEEOF)
+      break;
+    else if (status != OK)
+      return status;
+  }
+  make_heap(buffer, buffer + numItems, order);
+
+  while (numItems > 0) {
+    SORTREC & top = buffer[0];
+
+    // The smallest tuple belongs to the next run: close the current
+    // run file and start a new one.
+
+    if (top.run != runNo) {
+      if (runNo >= 0) {
+	delete runs.back().file;
+	runs.back().file = NULL;
+	stats.runLengths.push_back(runLen);
+      }
+      RUN newRun;
+      runs.push_back(newRun);
+      if ((status = createRun(runs.back())) != OK)
+	return status;
+      runNo = top.run;
+      runLen = 0;
+    }
 
-   RUN & run = runs.back();
+    RID rid;
+    Record record = {top.tuple, top.length};
+    if ((status = runs.back().file->insertRecord(record, rid)) != OK)
+      return status;
+    runLen++;
+    memcpy(&lastKey[0], top.tuple + offset, length);
+    lastPrefix = top.prefix;
 
-  // Generate file name for temporary file.
+    // Move the written tuple to the end of the heap and refill its
+    // slot, or drop it at the end of the source file.
 
-  ostringstream outputString;
-  outputString << fileName << ".sort." << runs.size() << ends;
-  run.name = outputString.str();
-  /* 
-  char *tmpString = outputString.str();
-  run.name = string(tmpString);
-  delete [] tmpString;
-  */
+    pop_heap(buffer, buffer + numItems, order);
+    SORTREC & item = buffer[numItems - 1];
+    const int slot = (item.tuple - arena) / item.length;
+
+    if (!eof && (status = readTuple(slot, item)) == FILEEOF)
+      eof = true;
+    else if (!eof && status != OK)
+      return status;
+
+    if (eof) {
+      numItems--;
+      continue;
+    }
+
+    bool smaller = item.prefix < lastPrefix;
+    if (item.prefix == lastPrefix && less.prefixPartial())
+      smaller = strncmp(item.tuple + offset, &lastKey[0], length) < 0;
+    item.run = smaller ? runNo + 1 : runNo;
+    push_heap(buffer, buffer + numItems, order);
+  }
 
+  if (runNo >= 0) {
+    delete runs.back().file;
+    runs.back().file = NULL;
+    stats.runLengths.push_back(runLen);
+  }
+
+  return OK;
+}
+
+
+// Sort the records in buffer[] (the key prefixes and pointers to
+// the tuples in the arena) and then dump the tuples into a
+// temporary file.
+
+Status SortedFile::generateRun(int items)
+{
+  Status status;
+
+  sortItems(items);
+
+  // Add a RUN object for the new sub-run
+
+  RUN newRun;
+  runs.push_back(newRun);
+  RUN & run = runs.back();
+
+  if ((status = createRun(run)) != OK)
+    return status;
 
 #ifdef DEBUGSORT
-  cout << "%%  Writing " << items << " tuples to file " << run->name
+  cout << "%%  Writing " << items << " tuples to file " << run.name
        << endl;
 #endif
 
-  // Make sure temporary file does not exist already. We don't
-  // want to corrupt somebody else's sorted files (on another
-  // attribute, for example).
+  // Append the tuples to the temporary file in sorted order.
 
-  if ((status = db.createFile(run.name)) != OK)
-    return status;                      // file must not exist already
-  if ((status = db.destroyFile(run.name)) != OK)
+  for(int i = 0; i < items; i++) {
+    RID rid;
+    Record record = {buffer[i].tuple, buffer[i].length};
+
+    if ((status = run.file->insertRecord(record, rid)) != OK)
+      return status;
+  }
+
+  delete run.file;
+  run.file = NULL;
+  stats.runLengths.push_back(items);
+
+  return OK;
+}
+
+
+// Sort the first 'items' entries of buffer[]. With PARALLEL_RUNS a
+// large enough load is sorted by several threads.
+
+void SortedFile::sortItems(int items)
+{
+  SortRecLess less(offset, length, type);
+  const int threads = sortThreads();
+
+  if (runGen != PARALLEL_RUNS || threads < 2 || items < PARALLELSORTMIN) {
+    sortRecs(buffer, items, less);
+    return;
+  }
+
+  ParallelSort(buffer, items, threads, less).run();
+  if (threads > stats.threadCnt)
+    stats.threadCnt = threads;
+}
+
+
+// Create the temporary file of a new sub-run and open it for
+// appending tuples.
+
+Status SortedFile::createRun(RUN & run)
+{
+  Status status;
+
+  run.file = NULL;
+
+  // Generate file name for temporary file. The sequence number is
+  // shared by all sorts, so two sorts of the same relation (e.g. in
+  // a self-join) do not pick the same names. Names of existing
+  // files are skipped: we don't want to corrupt somebody else's
+  // sorted files (on another attribute, for example, or a sorted
+  // copy kept by an earlier run of the program).
+
+  static int runFileCnt = 0;
+  string name;
+  do {
+    ostringstream outputString;
+    outputString << fileName << ".sort." << ++runFileCnt;
+    name = outputString.str();
+  } while ((status = db.createFile(name)) == FILEEXISTS);
+
+  if (status != OK)
+    return status;
+  if ((status = db.destroyFile(name)) != OK)
     return status;                      // delete if successful
+  run.name = name;
 
   // Open a heap file. This will also create the temporary file.
 
   if (!(run.file = new HeapFileScan(run.name, 0, 0, STRING, NULL, EQ, status)))
     return INSUFMEM;
 
-  if (status != OK)
-    return status;
+  return status;
+}
+
+
+// Merge the sub-runs in passes until no more than fanIn of them are
+// left. Every run being merged pins the header page and one data page
+// of its file, and an intermediate pass also appends to one output
+// run, so fanIn follows from the buffer frames granted to the sort.
+// Each pass merges groups of fanIn runs into one longer run, written
+// sequentially; the final merge is then done by next().
+
+Status SortedFile::mergeRuns()
+{
+  Status status = OK;
+
+  const int frames = maxFrames > 0 ? maxFrames : bufMgr->numUnpinnedPages() / 2;
+  int fanIn = (frames - 2) / 2;
+  if (fanIn < 2)
+    fanIn = 2;
+
+  while ((int)runs.size() > fanIn) {
+    vector<RUN> input;
+    vector<RUN> output;
+    input.swap(runs);
+
+    for(unsigned int first = 0; first < input.size(); first += fanIn) {
+      unsigned int last = min(first + fanIn, (unsigned int)input.size());
+
+      if (last - first == 1) {
+	output.push_back(input[first]);
+	continue;
+      }
 
-  // Open an unfiltered sequential scan on the source file. The scan
-  // is not actually needed for anything else than just getting
-  // a scanId which getRandomRecord requires.
+      // Merge input[first..last-1] into a new run.
+
+      RUN merged;
+      runs.assign(input.begin() + first, input.begin() + last);
+      if ((status = startScans()) == OK
+	  && (status = createRun(merged)) == OK) {
+	Record rec;
+	RID rid;
+	while ((status = next(rec)) == OK)
+	  if ((status = merged.file->insertRecord(rec, rid)) != OK)
+	    break;
+	if (status == FILEEOF)
+	  status = OK;
+      }
+
+#ifdef DEBUGSORT
+      cout << "%%  Merged " << last - first << " runs into " << merged.name
+	   << endl;
+#endif
+
+      // The merged runs are no longer needed.
+
+      for(unsigned int i = 0; i < runs.size(); i++) {
+	delete runs[i].file;
+	(void)db.destroyFile(runs[i].name);
+      }
+      runs.clear();
+      delete merged.file;
+      merged.file = NULL;
+      if (!merged.name.empty())
+	output.push_back(merged);
 
-  HeapFileScan scan (fileName, 0, 0, STRING, NULL, EQ, status);
+      // On failure leave the remaining runs to the destructor.
 
+      if (status != OK) {
+	runs.swap(output);
+	runs.insert(runs.end(), input.begin() + last, input.end());
+	return status;
+      }
+    }
+
+    runs.swap(output);
+    stats.passCnt++;
+  }
+
+  return OK;
+}
+
+
+// A source file clustered on the sort attribute (see ClusterCatalog) is
+// in order already and becomes the only run itself. Otherwise look up
+// the sorted copy of the source file on the sort attribute: if it was
+// made from the given version of the file with the given id, it becomes
+// the only run. In both cases keepRun is set; a stale copy (also one of
+// an earlier file of the same name) is dropped.
+
+Status SortedFile::findCopy(int fileId, int version)
+{
+  Status status;
+  SortCopyDesc desc;
+  RUN run;
+
+  {
+    ClusterCatalog clustCat(status);
+    if (status != OK)
+      return status;
+
+    if (clustCat.isClustered(fileName, offset, length, type, fileId, version)) {
+      run.name = fileName;
+      run.file = NULL;
+      runs.push_back(run);
+      keepRun = true;
+      stats.clustered = true;
+      return OK;
+    }
+  }
+
+  SortCatalog sortCat(status);
   if (status != OK)
     return status;
 
-  // For each sort record (attribute plus RID) in the buffer, fetch
-  // the whole record from the source file and then insert it into
-  // the temporary file.
+  status = sortCat.getInfo(fileName, offset, length, type, desc);
+  if (status == RECNOTFOUND)
+    return OK;
+  if (status != OK)
+    return status;
 
-  for(int i = 0; i < items; i++) {
-    SORTREC* rec = &buffer[i];
-    RID rid;
-    Record record;
+  if (desc.relFileId != fileId || desc.relVersion != version) {
+    status = sortCat.dropCopy(desc);
+    return status == FILEOPEN ? OK : status;  // read by another sort
+  }
 
-    if ((status = scan.getRandomRecord(rec->rid, record)) != OK)
-      return status;
+  run.name = desc.fileName;
+  run.file = NULL;
+  runs.push_back(run);
+  keepRun = true;
 
-    if ((status = run.file->insertRecord(record, rid)) != OK)
+  return OK;
+}
+
+
+// Record the single run as the sorted copy of the given version of
+// the source file, so that the destructor keeps it. A run too large
+// for the space of the sorted copies (SORTCOPYPAGES), or for which the
+// earlier copy cannot be dropped because it is being read, is not kept.
+
+Status SortedFile::keepCopy(int fileId, int version)
+{
+  Status status;
+  SortCopyDesc desc;
+
+  if (fileName.length() >= MAXNAME
+      || runs[0].name.length() >= sizeof(desc.fileName))
+    return OK;                          // not worth failing the sort
+
+  memset(&desc, 0, sizeof(SortCopyDesc));
+  strcpy(desc.relName, fileName.c_str());
+  desc.attrOffset = offset;
+  desc.attrLen = length;
+  desc.attrType = type;
+  desc.relFileId = fileId;
+  desc.relVersion = version;
+  strcpy(desc.fileName, runs[0].name.c_str());
+  {
+    HeapFile run(runs[0].name, status);
+    if (status != OK)
       return status;
+    desc.fileId = run.getFileId();
+    desc.pageCnt = run.getPageCnt();
   }
+  if (desc.pageCnt > SORTCOPYPAGES)
+    return OK;
 
-  delete run.file;
+  SortCatalog sortCat(status);
+  if (status != OK)
+    return status;
+
+  // the earlier copy is being read: this one is dropped instead
+  if ((status = sortCat.addCopy(desc)) == FILEOPEN)
+    return OK;
+  if (status != OK)
+    return status;
+  keepRun = true;
 
   return OK;
 }
 
 
 // Prepare a sequential scan on each sub-run so that next()
-// can fetch the next record from each run. The valid bit of
-// each run is marked false to indicate that the (first)
-// record has not been fetched yet. next() must therefore
-// fetch it.
+// can fetch the next record from each run. The first block of
+// each run is read and the tournament tree is built over the
+// run heads.
 
 Status SortedFile::startScans()
 {
@@ -316,24 +756,164 @@ Status SortedFile::startScans()
 
       if (status != OK)
 	return status;
-      run->valid = false;
-      run->rid.pageNo = -1;
-      run->rid.slotNo = -1;
+      run->eof = false;
+      run->recLen = 0;
       run->mark.pageNo = -1;
       run->mark.slotNo = -1;
+      if ((status = fillBlock(*run, NULL)) != OK)
+	return status;
     }
 #ifdef DEBUGSORT
     cout << endl;
 #endif
 
+  lastWinner = -1;
+  buildTree();
+
   return OK;
 }
 
 
+// Copy the next block of tuples of a run into memory: the rest of
+// the current page of the run file and RUNBLOCKPAGES - 1 pages of
+// read-ahead. If first is given, it is the marked tuple of the run,
+// which the scan of the run file has just been positioned on; it
+// starts the block.
+
+Status SortedFile::fillBlock(RUN & run, const Record * first)
+{
+  Status status;
+  RID rid;
+  Record rec;
+  int pages = 0;
+  int lastPage = -1;
+
+  run.block.clear();
+  run.rids.clear();
+  run.cur = 0;
+
+  if (first) {
+    run.recLen = first->length;
+    run.block.insert(run.block.end(), (char *)first->data,
+		     (char *)first->data + first->length);
+    run.rids.push_back(run.mark);
+    pages = 1;
+    lastPage = run.mark.pageNo;
+  }
+
+  while (!run.eof) {
+    if ((status = run.file->scanNext(rid, rec)) == FILEEOF) {
+      run.eof = true;
+      break;
+    }
+    else if (status != OK)
+      return status;
+
+    run.recLen = rec.length;
+    run.block.insert(run.block.end(), (char *)rec.data,
+		     (char *)rec.data + rec.length);
+    run.rids.push_back(rid);
+
+    // the block ends with the first tuple past its last page
+    if (rid.pageNo != lastPage && pages++ == RUNBLOCKPAGES)
+      break;
+    lastPage = rid.pageNo;
+  }
+
+  if (!run.rids.empty())
+    run.prefix = keyPrefix(&run.block[0] + offset, type, length);
+
+  return OK;
+}
+
+
+// Move a run to its next tuple, reading the next block when the
+// current one is used up.
+
+Status SortedFile::advance(RUN & run)
+{
+  if (++run.cur < (int)run.rids.size()) {
+    run.prefix = keyPrefix(&run.block[run.cur * run.recLen] + offset,
+			   type, length);
+    return OK;
+  }
+  return fillBlock(run, NULL);
+}
+
+
+// True if the head of run r1 sorts before the head of run r2. A run
+// that is used up sorts after everything. The cached key prefixes
+// decide unless they are equal and do not cover the attribute.
+
+bool SortedFile::headLess(int r1, int r2) const
+{
+  const RUN & run1 = runs[r1];
+  const RUN & run2 = runs[r2];
+
+  if (run1.cur >= (int)run1.rids.size())
+    return false;
+  if (run2.cur >= (int)run2.rids.size())
+    return true;
+
+  if (run1.prefix != run2.prefix)
+    return run1.prefix < run2.prefix;
+  if (type != STRING || length <= (int)sizeof(run1.prefix))
+    return false;
+  return strncmp(&run1.block[run1.cur * run1.recLen] + offset,
+		 &run2.block[run2.cur * run2.recLen] + offset, length) < 0;
+}
+
+
+// Build the tournament tree. Run r is the leaf at position
+// runs.size() + r; every internal node keeps the loser of the match
+// between the winners of its two subtrees.
+
+void SortedFile::buildTree()
+{
+  const int k = runs.size();
+  vector<int> winner(2 * k);
+
+  tree.assign(k > 1 ? k : 1, 0);
+  for(int r = 0; r < k; r++)
+    winner[k + r] = r;
+  for(int i = k - 1; i >= 1; i--) {
+    int w1 = winner[2 * i];
+    int w2 = winner[2 * i + 1];
+    if (headLess(w2, w1)) {
+      winner[i] = w2;
+      tree[i] = w1;
+    } else {
+      winner[i] = w1;
+      tree[i] = w2;
+    }
+  }
+  tree[0] = (k > 1) ? winner[1] : 0;
+}
+
+
+// The head of run r has changed: replay the matches on the path
+// from its leaf to the root, log2(runs) comparisons.
+
+void SortedFile::replay(int r)
+{
+  const int k = runs.size();
+  int w = r;
+
+  for(int i = (k + r) / 2; i >= 1; i /= 2) {
+    if (headLess(tree[i], w)) {
+      int loser = w;
+      w = tree[i];
+      tree[i] = loser;
+    }
+  }
+  tree[0] = w;
+}
+
+
 // Retrieve the next smallest record from the set of sorted sub-runs.
-// The next record of each sub-run is peeked to find out the
-// smallest of all. The pointer in the chosen sub-run is then
-// advanced.
+// The run that supplied the previous record is advanced first (its
+// tuple had to stay valid until now) and the tournament is replayed
+// for it; the winner of the tree has the smallest head.
 
 Status SortedFile::next(Record & rec)
 {
@@ -345,64 +925,33 @@ Status SortedFile::next(Record & rec)
   if (runs.size() <= 0)
     return FILEEOF;
 
-  // Find the run which has the smallest next record. If a run
-  // has false valid bit, it doesn't have the next record in memory
-  // yet.
-
-  // RUN* smallest = NULL;
-  bool foundSmallest = false;
-  vector<RUN>::iterator run, smallest;
-
-  for(run = runs.begin(); run != runs.end(); run++)
-    {
-      if (run->valid == false) {          // no record fetched yet for this run?
-	status = run->file->scanNext(run->rid);
-	if (status == FILEEOF)            // reached end of this run file?
-	  run->rid.pageNo = -1;           // mark end of file
-	else if (status != OK)
-	  return status;
-	else {                            // if next record exists, fetch it
-	  if ((status = run->file->getRecord(run->rid, run->rec)) != OK)
-	    return status;
-	}
-	run->valid = true;                // a record is now in memory
-      }
+  if (lastWinner >= 0) {
+    if ((status = advance(runs[lastWinner])) != OK)
+      return status;
+    replay(lastWinner);
+    lastWinner = -1;
+  }
 
-      if (run->rid.pageNo < 0)            // end of run already?
-	continue;
-
-      if (!foundSmallest)                 // select first one as smallest
-      {
-	smallest = run;
-        foundSmallest = true;
-      }
-      else if (reccmp((char *)smallest->rec.data + offset,
-		      (char *)run->rec.data + offset,
-		      length, length, type) > 0)
-      {
-	smallest = run;                   // current run had smaller next
-        foundSmallest = true;
-      }
-    }
-  
-  if (!foundSmallest)                     // no next record found?
-    return FILEEOF;
+  RUN & smallest = runs[tree[0]];
+  if (smallest.cur >= (int)smallest.rids.size())
+    return FILEEOF;                     // all runs are used up
 
 #ifdef DEBUGSORT
-  cout << "%%  Retrieved smallest from " << smallest->name << endl;
+  cout << "%%  Retrieved smallest from " << smallest.name << endl;
 #endif
 
-  rec = smallest->rec;                    // give record pointers to caller
-
-  smallest->valid = false;                // must fetch new record next time
+  rec.data = &smallest.block[smallest.cur * smallest.recLen];
+  rec.length = smallest.recLen;
+  lastWinner = tree[0];
 
   return OK;
 }
 
 
 // Remember a position in the sorted output so that the caller
-// can later return to this spot. The current RID of each sub-run
-// is recorded in a separate field.
+// can later return to this spot. The RID of the head of each
+// sub-run is recorded; for the run that supplied the last record
+// that is the last record itself.
 
 Status SortedFile::setMark()
 {
@@ -414,10 +963,14 @@ Status SortedFile::setMark()
 
   for(run = runs.begin(); run != runs.end(); run++)
     {
-      run->mark.pageNo = run->rid.pageNo;
-      run->mark.slotNo = run->rid.slotNo;
+      if (run->cur < (int)run->rids.size())
+	run->mark = run->rids[run->cur];
+      else {
+	run->mark.pageNo = -1;
+	run->mark.slotNo = -1;
+      }
 #ifdef DEBUGSORT
-      cout << "%%  Run " << i << " is at page " << run->mark.pageNo
+      cout << "%%  Run " << run->name << " is at page " << run->mark.pageNo
 	   << ", slot " << run->mark.slotNo << endl;
 #endif
     }
@@ -426,10 +979,11 @@ Status SortedFile::setMark()
 }
 
 
-// Restore sort position by fetching the last marked record
-// of each sub-run using getRandomRecord. This allows the caller
-// to back up in the sorted sequence (used in sort-merge join
-// in case of duplicates).
+// Restore sort position to the last mark. A run whose marked tuple
+// is still in its block just moves back in the block; otherwise the
+// run file is positioned with getRandomRecord and the block is read
+// again from there. This allows the caller to back up in the sorted
+// sequence (used in sort-merge join in case of duplicates).
 
 Status SortedFile::gotoMark()
 {
@@ -442,36 +996,59 @@ Status SortedFile::gotoMark()
 
   for(run = runs.begin(); run != runs.end(); run++)
     {
-      run->rid.pageNo = run->mark.pageNo;
-      run->rid.slotNo = run->mark.slotNo;
+      // A run that had ended at the mark is ended again.
 
-#ifdef DEBUGSORT
-      if (run->rid.pageNo >= 0) {
-	cout << "%%  Run " << i << " going to page " << run->rid.pageNo
-	     << ", slot " << run->rid.slotNo << endl;
-      } else {
-	cout << "%%  Run " << i << " is already at eof" << endl;
+      if (run->mark.pageNo < 0) {
+	run->cur = run->rids.size();
+	continue;
       }
-#endif
 
-      // Restore file position only if last marked position is
-      // something else than end of file.
+      int pos = run->rids.size() - 1;
+      while (pos >= 0 && !(run->rids[pos] == run->mark))
+	pos--;
 
-      if (run->rid.pageNo >= 0) {
-	if ((status = run->file->getRandomRecord(run->rid, run->rec)) != OK)
+      if (pos >= 0) {
+	run->cur = pos;
+	run->prefix = keyPrefix(&run->block[pos * run->recLen] + offset,
+				type, length);
+      } else {
+	Record rec;
+	if ((status = run->file->getRandomRecord(run->mark, rec)) != OK)
+	  return status;
+	run->eof = false;
+	if ((status = fillBlock(*run, &rec)) != OK)
 	  return status;
       }
-
-      // Current record is already in memory so next() must not
-      // advance in the temporary file.
-
-      run->valid = true;
     }
 
+  lastWinner = -1;
+  buildTree();
+
   return OK;
 }
 
 
+// Run and merge statistics of the sort.
+
+const SORTSTATS & SortedFile::getStats() const
+{
+  return stats;
+}
+
+
+// The number of threads a PARALLEL_RUNS sort uses: one per online
+// processor, at most MAXSORTTHREADS.
+
+int SortedFile::sortThreads()
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (cpus < 1)
+    return 1;
+  return cpus < MAXSORTTHREADS ? cpus : MAXSORTTHREADS;
+}
+
+
 // Deallocate all space allocated for this sorted file and
 // delete temporary files.
 
@@ -479,8 +1056,10 @@ SortedFile::~SortedFile()
 {
   for(unsigned int i = 0; i < runs.size(); i++) {
     delete runs[i].file;
-    (void)db.destroyFile(runs[i].name);
+    if (!keepRun)
+      (void)db.destroyFile(runs[i].name);
   }   
 
   delete [] buffer;
+  delete [] arena;
 }
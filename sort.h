@@ -4,50 +4,115 @@
 #include <vector>
 #include "heapfile.h"
 
+class BloomFilter;
+
 // define if debug output wanted
 //#define DEBUGSORT
 
+// The merge copies the tuples of each run into memory a block at a
+// time: the page being merged plus read-ahead, RUNBLOCKPAGES pages
+// in all. The run file is then not touched until the block is used up.
+#define RUNBLOCKPAGES 2
+
+// Parallel run generation sorts each memory load with up to
+// MAXSORTTHREADS threads (one per processor); loads of fewer than
+// PARALLELSORTMIN tuples are sorted by a single thread.
+#define MAXSORTTHREADS   8
+#define PARALLELSORTMIN  4096
+
 
-// SORTREC is an in-memory sort record that qsort(3) sorts.
-// The sort attribute as well as the associated RID are
-// stored in the record. The RID is used for fetching the
-// full record when it is needed.
+// SORTREC is an in-memory sort record. The tuples of a sub-run
+// are copied into one contiguous arena; a SORTREC points to its
+// tuple and carries a normalized prefix of the sort attribute
+// (see normkey.h), so most comparisons do not touch the tuple.
 
 typedef struct {
-  RID rid;                              // record id of current record
-  char* field;                          // pointer to field
-  int length;                           // length of field
+  unsigned long long prefix;            // normalized prefix of the sort attribute
+  char* tuple;                          // pointer to the tuple in the arena
+  int length;                           // length of the tuple
+  int run;                              // sub-run the tuple goes to
 } SORTREC;
 
 
+// The ways of forming the initial sub-runs: load maxItems tuples,
+// sort them and write them out, the same with the sorting of each
+// load spread over several threads, or replacement selection, which
+// gives fewer and longer runs.
+
+enum RunGenerator { QUICKSORT_RUNS, PARALLEL_RUNS, REPLACEMENT_SELECTION };
+
+
+// Statistics of a sort, to measure run generation and merging.
+
+typedef struct {
+  int runCnt;                           // # of sub-runs generated
+  std::vector<int> runLengths;          // # of tuples in each generated sub-run
+  int passCnt;                          // # of intermediate merge passes
+  int threadCnt;                        // most threads that sorted one sub-run
+  bool fromCache;                       // a cached sorted copy was read instead
+  bool clustered;                       // the file was read as it is (clustered)
+} SORTSTATS;
+
+
 class SortedFile {
  public:
   SortedFile(const string & fileName, 
 	     int offset,// sort source file on the given
 	     int length, Datatype type, // attribute
-	     int maxItems, Status& status);
+	     int maxItems, Status& status,
+	     int maxFrames = 0,                  // frames the merge may pin
+	     RunGenerator runGen = QUICKSORT_RUNS,
+	     bool cache = false,                 // use and keep a sorted copy
+	     BloomFilter* filter = NULL);        // drop tuples the filter rejects
 
-  Status next(Record & rec);            // fetch next record in sort order
+  // fetch next record in sort order. rec points into memory owned by
+  // the SortedFile and stays valid until the next call of next() or
+  // gotoMark()
+  Status next(Record & rec);
   Status setMark();                     // record a position in sort sequence
   Status gotoMark();                    // go to last recorded spot
+  const SORTSTATS & getStats() const;   // run and merge statistics
+  static int sortThreads();             // # of threads PARALLEL_RUNS may use
   ~SortedFile();                        // destroy temporary structures / files
 
  private:
   Status sortFile();                    // split source file into sub-runs
   Status generateRun(int numItems);     // generate one sub-run of file
+  void sortItems(int numItems);         // sort the items in buffer
+  Status selectRuns();                  // generate all sub-runs by replacement selection
+  Status readTuple(int slot, SORTREC & item); // read next source tuple into the arena
   Status startScans();                  // start a scan on each sorted run
+  Status mergeRuns();                   // merge runs down to the fan-in
+  Status findCopy(int fileId, int version); // use the file if clustered, or a valid sorted copy
+  Status keepCopy(int fileId, int version); // keep the merged run as sorted copy
 
   typedef struct {
     string name;                        // name of run file
     HeapFileScan* file;                 // ptr to sorted run of file
-    int valid;                          // TRUE if recPtr has a record
-    Record rec;
-    RID rid;                            // RID of current record of run
+    std::vector<char> block;            // copies of the next tuples of the run
+    std::vector<RID> rids;              // RIDs of the tuples in block
+    int recLen;                         // length of a tuple
+    int cur;                            // index of the head tuple in block
+    bool eof;                           // scan of the run file has ended
+    unsigned long long prefix;          // key prefix of the head tuple
     RID mark;                           // last marked spot (RID) in file
   } RUN;
 
   std::vector<RUN> runs;                     // holds info about each sub-run
 
+  // The merge is a tournament (loser) tree over the run heads:
+  // tree[0] is the run with the smallest head, tree[1..] hold the
+  // loser of the match played at each internal node.
+  std::vector<int> tree;
+  int lastWinner;                       // run whose head next() returned last
+
+  Status createRun(RUN & run);          // create the file of a new run
+  Status fillBlock(RUN & run, const Record * first);  // read next block of a run
+  Status advance(RUN & run);            // move a run to its next tuple
+  bool headLess(int r1, int r2) const;  // compare the heads of two runs
+  void buildTree();                     // play all the matches of the tree
+  void replay(int r);                   // replay matches after run r changed
+
   HeapFileScan* file;                   // source file to sort
   string fileName;                      // name of source file to sort
   Datatype type;                        // type of sort attribute
@@ -55,8 +120,16 @@ class SortedFile {
   int length;                           // length of sort attribute
 
   SORTREC *buffer;                      // in-memory sort buffer
+  char *arena;                          // copies of the tuples in buffer
+  int arenaSize;                        // size of arena in bytes
   int maxItems;                         // max. # of items/tuples in buffer
   int numItems;                         // current # of items in buffer
+  int maxFrames;                        // buffer frames the merge may pin
+  RunGenerator runGen;                  // how the sub-runs are formed
+  bool cache;                           // use and keep sorted copies
+  bool keepRun;                         // runs[0] is a sorted copy to keep
+  BloomFilter* filter;                  // semi-join filter on the sort attribute
+  SORTSTATS stats;                      // run and merge statistics
 };
 
 #endif
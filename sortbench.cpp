@@ -0,0 +1,194 @@
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "sortkernel.h"
+#include "normkey.h"
+
+#define TUPLELEN   64                   // length of the generated tuples
+#define ROUNDS     5                    // sorts per kernel and type
+
+#define MIN(a,b)   ((a) < (b) ? (a) : (b))
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+// The sort as it was before normalized keys: qsort(3) with one
+// comparison function per type, all going through reccmp.
+
+typedef struct {
+  char* field;                          // pointer to the sort attribute
+  int length;                           // length of the sort attribute
+} QSORTREC;
+
+static int reccmp(char* p1, char* p2, int p1Len, int p2Len, Datatype type)
+{
+  float diff = 0.0;
+
+  switch(type) {
+  case INTEGER:
+    int iattr, ifltr;
+    memcpy(&iattr, p1, sizeof(int));
+    memcpy(&ifltr, p2, sizeof(int));
+    diff = iattr - ifltr;
+    break;
+  case DOUBLE:
+    double fattr, ffltr;
+    memcpy(&fattr, p1, sizeof(double));
+    memcpy(&ffltr, p2, sizeof(double));
+    diff = fattr - ffltr;
+    break;
+  case STRING:
+    diff = memcmp(p1, p2, MIN(p1Len, p2Len));
+    break;
+  default:
+    break;
+  }
+
+  if (diff < 0)
+    diff = -1;
+  else if (diff > 0)
+    diff = 1;
+
+  return (int)diff;
+}
+
+#define QR(p)  ((QSORTREC*)p)
+
+static int intcmp(const void* p1, const void* p2)
+{
+  return reccmp(QR(p1)->field, QR(p2)->field, QR(p1)->length, QR(p2)->length, INTEGER);
+}
+
+static int floatcmp(const void* p1, const void* p2)
+{
+  return reccmp(QR(p1)->field, QR(p2)->field, QR(p1)->length, QR(p2)->length, DOUBLE);
+}
+
+static int stringcmp(const void* p1, const void* p2)
+{
+  return reccmp(QR(p1)->field, QR(p2)->field, QR(p1)->length, QR(p2)->length, STRING);
+}
+
+
+// Fill the arena with n tuples whose attribute at offset 0 is random.
+
+static void generate(std::vector<char> & arena, const int n,
+		     const Datatype type, const int length)
+{
+  arena.assign((size_t)n * TUPLELEN, 0);
+  srand(1);
+
+  for (int i = 0; i < n; i++) {
+    char* attr = &arena[(size_t)i * TUPLELEN];
+    if (type == INTEGER) {
+      int v = rand() - RAND_MAX / 2;
+      memcpy(attr, &v, sizeof(int));
+    }
+    else if (type == DOUBLE) {
+      double v = (rand() - RAND_MAX / 2) / 1000.0;
+      memcpy(attr, &v, sizeof(double));
+    }
+    else {
+      // long strings share a prefix, so their prefixes rarely decide
+      int shared = length > 16 ? 12 : 0;
+      memset(attr, 'c', shared);
+      for (int j = shared; j < length - 1; j++)
+	attr[j] = 'a' + rand() % 26;
+    }
+  }
+}
+
+
+static void report(const char* kernel, const int n, const double secs, const bool ok)
+{
+  printf("  %-22s %8.1f ns/tuple  %7.2f Mtuples/s%s\n", kernel,
+	 secs * 1e9 / ((double)n * ROUNDS), (double)n * ROUNDS / secs / 1e6,
+	 ok ? "" : "  NOT SORTED");
+}
+
+
+// Sort n tuples on an attribute of the given type with each kernel.
+// The SORTREC kernels include building the key prefixes, which the
+// qsort path did not need.
+
+static void bench(const char* name, const int n, const Datatype type, const int length)
+{
+  std::vector<char> arena;
+  generate(arena, n, type, length);
+  SortRecLess less(0, length, type);
+
+  printf("%s, %d tuples\n", name, n);
+
+  // qsort with reccmp
+  {
+    std::vector<QSORTREC> recs(n);
+    double secs = 0;
+    bool ok = true;
+    for (int r = 0; r < ROUNDS; r++) {
+      for (int i = 0; i < n; i++) {
+	recs[i].field = &arena[(size_t)i * TUPLELEN];
+	recs[i].length = length;
+      }
+      double start = now();
+      qsort(&recs[0], n, sizeof(QSORTREC),
+	    type == INTEGER ? intcmp : type == DOUBLE ? floatcmp : stringcmp);
+      secs += now() - start;
+    }
+    for (int i = 1; i < n; i++)
+      if (reccmp(recs[i - 1].field, recs[i].field, length, length, type) > 0)
+	ok = false;
+    report("qsort (reccmp)", n, secs, ok);
+  }
+
+  // comparison sort and radix sort of SORTRECs
+  for (int kernel = 0; kernel < 2; kernel++) {
+    std::vector<SORTREC> recs(n);
+    double secs = 0;
+    bool ok = true;
+    for (int r = 0; r < ROUNDS; r++) {
+      double start = now();
+      for (int i = 0; i < n; i++) {
+	recs[i].tuple = &arena[(size_t)i * TUPLELEN];
+	recs[i].length = TUPLELEN;
+	recs[i].prefix = keyPrefix(recs[i].tuple, type, length);
+	recs[i].run = 0;
+      }
+      if (kernel == 0)
+	std::sort(recs.begin(), recs.end(), less);
+      else
+	sortRecs(&recs[0], n, less);
+      secs += now() - start;
+    }
+    for (int i = 1; i < n; i++)
+      if (less(recs[i], recs[i - 1]))
+	ok = false;
+    report(kernel == 0 ? "std::sort (prefix)" : "radix (prefix)", n, secs, ok);
+  }
+}
+
+
+// Microbenchmark of the in-memory sort of a sub-run. Usage:
+//   sortbench [tuples]
+int main(int argc, char *argv[])
+{
+  const int n = argc > 1 ? atoi(argv[1]) : 1000000;
+
+  if (n < 1) {
+    fprintf(stderr, "Usage: %s [tuples]\n", argv[0]);
+    return 1;
+  }
+
+  bench("INTEGER", n, INTEGER, sizeof(int));
+  bench("DOUBLE", n, DOUBLE, sizeof(double));
+  bench("CHAR(8)", n, STRING, 8);
+  bench("CHAR(32)", n, STRING, 32);
+  return 0;
+}
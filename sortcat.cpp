@@ -0,0 +1,188 @@
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "catalog.h"
+
+
+SortCatalog::SortCatalog(Status &status) :
+	HeapFileScan(SORTCATNAME, status)
+{
+}
+
+
+SortCatalog::~SortCatalog()
+{
+}
+
+
+/*
+ * Looks up the sorted copy of relation rName on the attribute given by
+ * attrOffset, attrLen and attrType.
+ *
+ * Returns:
+ * 	OK on success
+ * 	RECNOTFOUND if there is no such copy
+ * 	an error code otherwise
+ */
+const Status SortCatalog::getInfo(const string & rName,
+				  const int attrOffset,
+				  const int attrLen,
+				  const Datatype attrType,
+				  SortCopyDesc &desc)
+{
+	Status status;
+	RID rid;
+	Record rec;
+	bool found = false;
+
+	if(rName.empty()) return BADCATPARM;
+
+	status = startScan(0, MAXNAME, STRING, rName.c_str(), EQ);
+	if(status != OK) return status;
+
+	while(!found && scanNext(rid, rec) == OK){
+		memcpy(&desc, rec.data, sizeof(SortCopyDesc));
+		found = (desc.attrOffset == attrOffset && desc.attrLen == attrLen
+			 && desc.attrType == attrType);
+	}
+
+	status = endScan();
+	if(status != OK) return status;
+
+	return found ? OK : RECNOTFOUND;
+}
+
+
+/*
+ * Help function: whether a sorted copy was made from a relation file
+ * that is gone or has changed since
+ */
+static bool isStale(const SortCopyDesc & copy)
+{
+	Status status;
+	File* file;
+
+	// opening a heap file that does not exist would create it
+	if(db.openFile(copy.relName, file) != OK) return true;
+	(void)db.closeFile(file);
+
+	HeapFile hf(copy.relName, status);
+	return status != OK || hf.getFileId() != copy.relFileId
+		|| hf.getVersion() != copy.relVersion;
+}
+
+
+/*
+ * Help function: orders sorted copies from the oldest to the newest
+ */
+static bool olderCopy(const SortCopyDesc & a, const SortCopyDesc & b)
+{
+	return a.fileId < b.fileId;
+}
+
+
+/*
+ * Records a sorted copy. An earlier copy of the relation on the same
+ * attribute and all stale copies are dropped first, and then as many
+ * of the oldest copies as it takes to keep the copies within
+ * SORTCOPYPAGES pages. Copies that are being read are left alone; if
+ * the earlier copy on the same attribute is one of them, the new copy
+ * is not recorded.
+ *
+ * Returns:
+ * 	OK on success
+ * 	BADCATPARM if the copy alone is larger than SORTCOPYPAGES
+ * 	FILEOPEN if the earlier copy on the same attribute is being read
+ * 	an error code otherwise
+ */
+const Status SortCatalog::addCopy(const SortCopyDesc & desc)
+{
+	Status status;
+	RID rid;
+	Record rec;
+
+	if(!desc.relName[0] || !desc.fileName[0]) return BADCATPARM;
+	if(desc.pageCnt > SORTCOPYPAGES) return BADCATPARM;
+
+	vector<SortCopyDesc> copies;
+	status = startScan(0, 0, STRING, NULL, EQ);
+	if(status != OK) return status;
+
+	while(scanNext(rid, rec) == OK){
+		SortCopyDesc copy;
+		memcpy(&copy, rec.data, sizeof(SortCopyDesc));
+		copies.push_back(copy);
+	}
+
+	status = endScan();
+	if(status != OK) return status;
+
+	int pageCnt = desc.pageCnt;
+	bool replaced = true;
+	vector<SortCopyDesc> kept;
+	for(unsigned int i = 0; i < copies.size(); i ++){
+		const SortCopyDesc &copy = copies[i];
+		const bool sameKey = !strcmp(copy.relName, desc.relName)
+			&& copy.attrOffset == desc.attrOffset
+			&& copy.attrLen == desc.attrLen && copy.attrType == desc.attrType;
+		if(sameKey || isStale(copy)){
+			status = dropCopy(copy);
+			if(status == FILEOPEN && sameKey) replaced = false;
+			else if(status != OK && status != FILEOPEN) return status;
+		}
+		else{
+			kept.push_back(copy);
+			pageCnt += copy.pageCnt;
+		}
+	}
+
+	// one copy per relation and attribute, or getInfo could find either
+	if(!replaced) return FILEOPEN;
+
+	sort(kept.begin(), kept.end(), olderCopy);
+	for(unsigned int i = 0; pageCnt > SORTCOPYPAGES && i < kept.size(); i ++){
+		status = dropCopy(kept[i]);
+		if(status == OK) pageCnt -= kept[i].pageCnt;
+		else if(status != FILEOPEN) return status;
+	}
+
+	rec.data = (void *)&desc;
+	rec.length = sizeof(SortCopyDesc);
+	return insertRecord(rec, rid);
+}
+
+
+/*
+ * Drops a sorted copy: the file holding the copy is destroyed and the
+ * catalog entry removed. A copy whose file is open (being read by a
+ * sort) is left as it is.
+ *
+ * Returns:
+ * 	OK on success
+ * 	RECNOTFOUND if the copy is not in the catalog
+ * 	FILEOPEN if the file of the copy is open
+ * 	an error code otherwise
+ */
+const Status SortCatalog::dropCopy(const SortCopyDesc & desc)
+{
+	Status status;
+	RID rid;
+	Record rec;
+	bool found = false;
+
+	status = startScan(0, MAXNAME, STRING, desc.relName, EQ);
+	if(status != OK) return status;
+
+	while(!found && scanNext(rid, rec) == OK)
+		found = !strcmp(((SortCopyDesc *)rec.data)->fileName, desc.fileName);
+
+	status = endScan();
+	if(status != OK) return status;
+	if(!found) return RECNOTFOUND;
+
+	// a copy whose file has gone already is only removed from the catalog
+	status = db.destroyFile(desc.fileName);
+	if(status == FILEOPEN) return status;
+
+	return deleteRecord(rid);
+}
@@ -0,0 +1,106 @@
+#include <vector>
+#include <algorithm>
+#include "sortkernel.h"
+
+#define RADIXBITS    8
+#define RADIXVALUES  (1 << RADIXBITS)
+#define RADIXPASSES  ((int)sizeof(unsigned long long) * 8 / RADIXBITS)
+
+
+// Radix sort n items on their prefixes, using tmp (n items) as the
+// second buffer.
+
+static void radixSort(SORTREC* items, const int n, SORTREC* tmp)
+{
+  // Count the values of every digit of the prefixes in one pass
+  // over the items.
+
+  std::vector<int> count(RADIXPASSES * RADIXVALUES, 0);
+  for(int i = 0; i < n; i++) {
+    unsigned long long prefix = items[i].prefix;
+    for(int d = 0; d < RADIXPASSES; d++, prefix >>= RADIXBITS)
+      count[d * RADIXVALUES + (prefix & (RADIXVALUES - 1))]++;
+  }
+
+  // One stable distribution pass per digit, least significant digit
+  // first. A digit that is the same in all the items (e.g. the zero
+  // padding of INTEGER prefixes) needs no pass.
+
+  SORTREC* src = items;
+  SORTREC* dst = tmp;
+
+  for(int d = 0; d < RADIXPASSES; d++) {
+    int* cnt = &count[d * RADIXVALUES];
+    const int shift = d * RADIXBITS;
+
+    if (cnt[(items[0].prefix >> shift) & (RADIXVALUES - 1)] == n)
+      continue;
+
+    int pos = 0;
+    for(int v = 0; v < RADIXVALUES; v++) {
+      int c = cnt[v];
+      cnt[v] = pos;
+      pos += c;
+    }
+
+    for(int i = 0; i < n; i++)
+      dst[cnt[(src[i].prefix >> shift) & (RADIXVALUES - 1)]++] = src[i];
+
+    SORTREC* t = src;
+    src = dst;
+    dst = t;
+  }
+
+  if (src != items)
+    memcpy(items, src, n * sizeof(SORTREC));
+}
+
+
+// The items are sorted on the prefixes of their strings from byte
+// pos on. Sort each group of equal prefixes on the next 8 bytes;
+// the prefixes are restored afterwards. A prefix ending in a zero
+// byte covers the end of the string, so its group is all equal.
+
+static void sortGroups(SORTREC* items, const int n, SORTREC* tmp,
+		       const SortRecLess & less, const int pos)
+{
+  const int next = pos + sizeof(unsigned long long);
+
+  for(int first = 0; first < n; ) {
+    const unsigned long long prefix = items[first].prefix;
+    int last = first + 1;
+    while (last < n && items[last].prefix == prefix)
+      last++;
+
+    if (last - first > 1 && (prefix & (RADIXVALUES - 1)) != 0) {
+      for(int i = first; i < last; i++)
+	items[i].prefix = less.prefixAt(items[i], next);
+
+      if (last - first < RADIXSORTMIN)
+	sort(items + first, items + last, less);
+      else {
+	radixSort(items + first, last - first, tmp);
+	sortGroups(items + first, last - first, tmp, less, next);
+      }
+
+      for(int i = first; i < last; i++)
+	items[i].prefix = prefix;
+    }
+    first = last;
+  }
+}
+
+
+void sortRecs(SORTREC* items, const int n, const SortRecLess & less)
+{
+  if (n < RADIXSORTMIN) {
+    sort(items, items + n, less);
+    return;
+  }
+
+  std::vector<SORTREC> tmp(n);
+  radixSort(items, n, &tmp[0]);
+
+  if (less.prefixPartial())
+    sortGroups(items, n, &tmp[0], less, 0);
+}
@@ -0,0 +1,62 @@
+#ifndef SORTKERNEL_H
+#define SORTKERNEL_H
+
+#include <string.h>
+#include "sort.h"
+#include "normkey.h"
+
+// Fewer items than this are sorted by comparison only; the passes
+// of the radix sort do not pay off for them.
+#define RADIXSORTMIN 64
+
+
+// Orders SORTRECs on the sub-run they belong to (replacement
+// selection) and then on the sort attribute. The normalized prefixes
+// decide unless they are equal and do not cover the whole attribute
+// (strings longer than the prefix); those are compared in full.
+
+class SortRecLess {
+ public:
+  SortRecLess(int offset, int length, Datatype type)
+    : offset(offset), length(length), type(type) {}
+
+  bool operator()(const SORTREC & r1, const SORTREC & r2) const
+  {
+    if (r1.run != r2.run)
+      return r1.run < r2.run;
+    if (r1.prefix != r2.prefix)
+      return r1.prefix < r2.prefix;
+    if (!prefixPartial())
+      return false;
+    return strncmp(r1.tuple + offset, r2.tuple + offset, length) < 0;
+  }
+
+  // true if equal prefixes do not imply equal attribute values
+  bool prefixPartial() const
+  {
+    return type == STRING && length > (int)sizeof(unsigned long long);
+  }
+
+  // the key prefix of the part of a STRING attribute from byte pos
+  // on, or 0 (an empty string) past its end
+  unsigned long long prefixAt(const SORTREC & r, const int pos) const
+  {
+    return pos < length ? keyPrefix(r.tuple + offset + pos, STRING, length - pos) : 0;
+  }
+
+ private:
+  int offset;
+  int length;
+  Datatype type;
+};
+
+
+// Sort n SORTRECs of the same sub-run. The normalized key prefixes
+// are sorted with a least-significant-byte-first radix sort. Items
+// whose prefixes are equal but do not decide the order (long
+// strings) are sorted again, most significant part first, on the
+// prefix of the next 8 bytes of the string; small groups of them
+// are sorted by comparison (std::sort, an introsort).
+void sortRecs(SORTREC* items, const int n, const SortRecLess & less);
+
+#endif
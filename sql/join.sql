@@ -1,13 +1,20 @@
 -- Test selection queries
 
 CREATE INDEX DA (ikey);
-SELECT * FROM DA, DB WHERE DA.ikey = DB.ikey; -- use INL
+SELECT * FROM DA, DB WHERE DA.ikey = DB.ikey; -- use INL or HJ (by cost)
+
+CREATE TABLE DC (ikey INTEGER, tag CHAR(8));
+INSERT INTO DC (ikey, tag) VALUES (11618, 'first');
+INSERT INTO DC (ikey, tag) VALUES (578, 'ninth');
+INSERT INTO DC (ikey, tag) VALUES (1, 'none');
+SELECT * FROM DC, DA WHERE DC.ikey = DA.ikey; -- use INL (few outer tuples)
 
 DROP INDEX DA (ikey);
-SELECT * FROM DA, DB WHERE DA.ikey = DB.ikey; -- use SMJ
+SELECT * FROM DA, DB WHERE DA.ikey = DB.ikey; -- use HJ or SMJ (by cost)
 
-SELECT DA.ikey, DB.serial FROM DA, DB WHERE DA.ikey < DB.serial; -- use SNL
+SELECT DA.ikey, DB.serial FROM DA, DB WHERE DA.ikey < DB.serial; -- use BMJ or BNL (by cost)
 
 
 DROP TABLE DA;
 DROP TABLE DB;
+DROP TABLE DC;
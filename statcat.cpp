@@ -0,0 +1,129 @@
+#include <cstring>
+#include "catalog.h"
+#include "stats.h"
+
+
+StatCatalog::StatCatalog(Status &status) :
+	HeapFileScan(STATCATNAME, status)
+{
+}
+
+
+StatCatalog::~StatCatalog()
+{
+}
+
+
+/*
+ * Looks up the statistics of attribute attrName of relation rName.
+ *
+ * Returns:
+ * 	OK on success
+ * 	RECNOTFOUND if the attribute has not been analyzed
+ * 	an error code otherwise
+ */
+const Status StatCatalog::getInfo(const string & rName,
+				  const string & attrName,
+				  AttrStatsDesc &desc)
+{
+	Status status;
+	RID rid;
+	Record rec;
+	bool found = false;
+
+	if(rName.empty() || attrName.empty()) return BADCATPARM;
+
+	status = startScan(0, MAXNAME, STRING, rName.c_str(), EQ);
+	if(status != OK) return status;
+
+	while(!found && scanNext(rid, rec) == OK){
+		found = !strcmp(((AttrStatsDesc *)rec.data)->attrName, attrName.c_str());
+		if(found) memcpy(&desc, rec.data, sizeof(AttrStatsDesc));
+	}
+
+	status = endScan();
+	if(status != OK) return status;
+
+	return found ? OK : RECNOTFOUND;
+}
+
+
+/*
+ * Records the statistics of an attribute. Earlier statistics of the
+ * attribute are dropped first.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise
+ */
+const Status StatCatalog::addInfo(const AttrStatsDesc & desc)
+{
+	Status status;
+	RID rid;
+	Record rec;
+	bool found = false;
+
+	if(!desc.relName[0] || !desc.attrName[0]) return BADCATPARM;
+
+	status = startScan(0, MAXNAME, STRING, desc.relName, EQ);
+	if(status != OK) return status;
+
+	while(!found && scanNext(rid, rec) == OK)
+		found = !strcmp(((AttrStatsDesc *)rec.data)->attrName, desc.attrName);
+
+	status = endScan();
+	if(status != OK) return status;
+
+	if(found){
+		status = deleteRecord(rid);
+		if(status != OK) return status;
+	}
+
+	// inserts into the relation bring its statistics up to date from now on
+	{
+		HeapFile hf(desc.relName, status);
+		if(status != OK) return status;
+		hf.addCatalogFlags(STATSFLAG);
+	}
+
+	Record newRec = {(void *)&desc, sizeof(AttrStatsDesc)};
+	return insertRecord(newRec, rid);
+}
+
+
+/*
+ * Adds a tuple just inserted into relation rName to the statistics of
+ * each analyzed attribute of the relation; pageCnt is the new size of
+ * the relation. The entries are updated in place. Relations that have
+ * not been analyzed are left alone.
+ *
+ * Returns:
+ * 	OK on success
+ * 	an error code otherwise
+ */
+const Status StatCatalog::addTuple(const string & rName,
+				   const char* tuple,
+				   const int pageCnt)
+{
+	Status status;
+	RID rid;
+	Record rec;
+
+	if(rName.empty()) return BADCATPARM;
+
+	status = startScan(0, MAXNAME, STRING, rName.c_str(), EQ);
+	if(status != OK) return status;
+
+	while((status = scanNext(rid, rec)) == OK){
+		AttrStatsDesc *desc = (AttrStatsDesc *)rec.data;
+		addTupleStats(*desc, tuple);
+		desc->pageCnt = pageCnt;
+
+		status = markDirty(rid);
+		if(status != OK) break;
+	}
+	if(status == FILEEOF) status = OK;
+
+	const Status endStatus = endScan();
+	return status != OK ? status : endStatus;
+}
@@ -0,0 +1,165 @@
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "stats.h"
+#include "normkey.h"
+
+using namespace std;
+
+#define FNVOFFSET 14695981039346656037ull
+#define FNVPRIME  1099511628211ull
+
+
+void initStats(AttrStatsDesc & desc, const AttrDesc & attrDesc)
+{
+  memset(&desc, 0, sizeof(AttrStatsDesc));
+  strncpy(desc.relName, attrDesc.relName, MAXNAME);
+  strncpy(desc.attrName, attrDesc.attrName, MAXNAME);
+  desc.attrOffset = attrDesc.attrOffset;
+  desc.attrLen = attrDesc.attrLen;
+  desc.attrType = attrDesc.attrType;
+  desc.minKey = ~0ull;
+  desc.maxKey = 0;
+}
+
+
+// Hash the normalized value with FNV-1a and mix the bits with the
+// finalizer of MurmurHash3, as HyperLogLog takes the register from the
+// leading bits.
+
+static unsigned long long hashValue(const char* value, const Datatype type,
+				    const int length)
+{
+  vector<unsigned char> norm(length);
+  normalizeKey(value, type, length, &norm[0]);
+
+  unsigned long long h = FNVOFFSET;
+  for (int i = 0; i < length; i++) {
+    h ^= norm[i];
+    h *= FNVPRIME;
+  }
+
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+
+// The first HLLBITS bits of the hash pick a register, which keeps the
+// largest position of the first 1 bit in the rest of the hashes it saw.
+
+void addValue(AttrStatsDesc & desc, const char* tuple)
+{
+  const char* value = tuple + desc.attrOffset;
+  const Datatype type = static_cast<Datatype>(desc.attrType);
+
+  const unsigned long long key = keyPrefix(value, type, desc.attrLen);
+  if (key < desc.minKey) desc.minKey = key;
+  if (key > desc.maxKey) desc.maxKey = key;
+
+  const unsigned long long h = hashValue(value, type, desc.attrLen);
+  const int reg = h >> (64 - HLLBITS);
+  const unsigned long long rest = h << HLLBITS;
+  const unsigned char rank = rest ? __builtin_clzll(rest) + 1 : 64 - HLLBITS + 1;
+  if (rank > desc.hll[reg]) desc.hll[reg] = rank;
+}
+
+
+// The tuple goes to the first bucket whose upper bound is not below
+// its value; a value above all of them extends the last bucket.
+
+void addTupleStats(AttrStatsDesc & desc, const char* tuple)
+{
+  const unsigned long long key =
+    keyPrefix(tuple + desc.attrOffset, static_cast<Datatype>(desc.attrType), desc.attrLen);
+
+  addValue(desc, tuple);
+  desc.recCnt++;
+
+  if (desc.bucketCnt == 0) {
+    desc.bucketCnt = 1;
+    desc.bucketHi[0] = key;
+    desc.bucketRecs[0] = 0;
+  }
+
+  int b = 0;
+  while (b < desc.bucketCnt - 1 && desc.bucketHi[b] < key)
+    b++;
+  if (desc.bucketHi[b] < key) desc.bucketHi[b] = key;
+  desc.bucketRecs[b]++;
+}
+
+
+// The HyperLogLog estimate (the harmonic mean of 2^register over the
+// registers), with linear counting of the empty registers for small
+// cardinalities.
+
+double estimateDistinct(const AttrStatsDesc & desc)
+{
+  const double m = HLLREGS;
+  const double alpha = 0.7213 / (1 + 1.079 / m);
+
+  double sum = 0;
+  int zeros = 0;
+  for (int i = 0; i < HLLREGS; i++) {
+    sum += ldexp(1.0, -desc.hll[i]);
+    if (desc.hll[i] == 0) zeros++;
+  }
+
+  double estimate = alpha * m * m / sum;
+  if (estimate <= 2.5 * m && zeros > 0)
+    estimate = m * log(m / zeros);
+  return estimate;
+}
+
+
+// Bucket b holds the values above the upper bound of bucket b - 1 (the
+// first one those from the smallest value on) up to its own bound;
+// within a bucket the values are taken to be spread evenly. A value
+// equal to both bounds of a bucket fills the whole bucket (a frequent
+// value of an equi-depth histogram); other values get an equal share
+// of the tuples.
+
+double estimateSelectivity(const AttrStatsDesc & desc, const Operator op,
+			   const void* attrValue)
+{
+  const unsigned long long key =
+    keyPrefix((const char *)attrValue, static_cast<Datatype>(desc.attrType), desc.attrLen);
+
+  double total = 0, less = 0, filled = 0;
+  unsigned long long lo = desc.minKey;
+  for (int b = 0; b < desc.bucketCnt; b++) {
+    const unsigned long long hi = desc.bucketHi[b];
+    const double recs = desc.bucketRecs[b];
+
+    total += recs;
+    if (hi < key)
+      less += recs;
+    else if (lo < key)
+      less += recs * (double)(key - lo) / (double)(hi - lo);
+    if (lo == key && hi == key)
+      filled += recs;
+    lo = hi;
+  }
+  if (total <= 0) return 0;
+
+  double equal = 0;
+  if (key >= desc.minKey && key <= desc.maxKey)
+    equal = max(filled / total, 1 / max(estimateDistinct(desc), 1.0));
+  less = min(less / total, 1 - equal);
+
+  double sel;
+  switch (op) {
+  case EQ:  sel = equal; break;
+  case NE:  sel = 1 - equal; break;
+  case LT:  sel = less; break;
+  case LTE: sel = less + equal; break;
+  case GT:  sel = 1 - less - equal; break;
+  case GTE: sel = 1 - less; break;
+  default:  sel = 1; break;
+  }
+  return min(max(sel, 0.0), 1.0);
+}
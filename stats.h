@@ -0,0 +1,32 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "catalog.h"
+
+// ANALYZE builds the histograms from a sample of up to STATSAMPLE
+// tuples of the relation, drawn in the same scan (reservoir sampling).
+#define STATSAMPLE 2048
+
+
+// Estimates from the statistics of an attribute (see StatCatalog).
+
+// Empty statistics for the attribute: no tuples, no values.
+void initStats(AttrStatsDesc & desc, const AttrDesc & attrDesc);
+
+// Add the value of the attribute in a tuple to the HyperLogLog sketch
+// and the range of values.
+void addValue(AttrStatsDesc & desc, const char* tuple);
+
+// Add an inserted tuple: its value, and one tuple to the relation and
+// to the histogram bucket of the value.
+void addTupleStats(AttrStatsDesc & desc, const char* tuple);
+
+// The # of distinct values (from the HyperLogLog sketch).
+double estimateDistinct(const AttrStatsDesc & desc);
+
+// The fraction of the tuples whose attribute value satisfies
+// "value op attrValue" (from the histogram).
+double estimateSelectivity(const AttrStatsDesc & desc, const Operator op,
+			   const void* attrValue);
+
+#endif
@@ -0,0 +1,6 @@
+rm -rf checkDB
+./dbcreate checkDB
+./dbcheck checkDB/
+status=$?
+rm -rf checkDB
+exit $status
@@ -0,0 +1,180 @@
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "catalog.h"
+#include "query.h"
+#include "sort.h"
+
+// Global variables
+DB db;                 // a handle for the DB class
+Error error;           // a handle for the error class
+
+BufMgr *bufMgr;        // pointer to the buffer manager
+RelCatalog *relCat;    // pointer to the relation catalogs
+AttrCatalog *attrCat;  // pointer to the attribute catalogs
+
+#define CALL(c)    {Status s;if((s=c)!=OK){error.print(s);exit(1);}}
+
+#define ROUNDS     3                    // runs per method and N
+#define RESULTNAME "Tmp_TopN"           // the relation Operators::OrderBy fills
+
+static double now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+
+// The first n tuples in the order of the attribute as a SortedFile
+// gives them: the whole relation is sorted into runs first. The
+// values of the attribute are returned in keys.
+
+static void sortedFileTopN(const AttrDesc & attr, const int tupleLen, const int n,
+                           vector<char> & keys, int & runCnt)
+{
+  Status status;
+  const int pages = bufMgr->numUnpinnedPages() * 0.8;
+  const int maxItems = max(2, (int)(pages * PAGESIZE) / tupleLen);
+  const RunGenerator runGen = SortedFile::sortThreads() > 1 ? PARALLEL_RUNS : REPLACEMENT_SELECTION;
+  SortedFile sorted(attr.relName, attr.attrOffset, attr.attrLen,
+                    (Datatype)attr.attrType, maxItems, status, 0, runGen);
+  CALL(status);
+
+  keys.clear();
+  Record rec;
+  for(int i = 0; i < n && sorted.next(rec) == OK; i++)
+    keys.insert(keys.end(), (char *)rec.data + attr.attrOffset,
+                (char *)rec.data + attr.attrOffset + attr.attrLen);
+  runCnt = sorted.getStats().runCnt;
+}
+
+
+// The first n tuples as Operators::OrderBy with a limit gives them
+// (the top-N heap), all attributes projected into RESULTNAME.
+
+static void orderByTopN(const AttrDesc & attr, const int attrCnt, const AttrDesc attrs[],
+                        const int n, vector<char> & keys)
+{
+  vector<attrInfo> proj(attrCnt);
+  for(int i = 0; i < attrCnt; i++) {
+    memset(&proj[i], 0, sizeof(attrInfo));
+    strcpy(proj[i].relName, attrs[i].relName);
+    strcpy(proj[i].attrName, attrs[i].attrName);
+    proj[i].attrType = attrs[i].attrType;
+    proj[i].attrLen = attrs[i].attrLen;
+  }
+  attrInfo sortAttr = proj[0];
+  strcpy(sortAttr.attrName, attr.attrName);
+
+  for(int i = 0; i < attrCnt; i++)
+    strcpy(proj[i].relName, RESULTNAME);
+  CALL(relCat->createRel(RESULTNAME, attrCnt, &proj[0]));
+  for(int i = 0; i < attrCnt; i++)
+    strcpy(proj[i].relName, attrs[i].relName);
+
+  // keep the plan the operator prints out of the timings' way
+  streambuf *out = cout.rdbuf(NULL);
+  Status status = Operators::OrderBy(RESULTNAME, attrCnt, &proj[0], &sortAttr, n);
+  cout.rdbuf(out);
+  cout.clear();
+  CALL(status);
+
+  keys.clear();
+  {
+    HeapFileScan hfs(RESULTNAME, status);
+    CALL(status);
+    RID rid;
+    Record rec;
+    while (hfs.scanNext(rid, rec) == OK)
+      keys.insert(keys.end(), (char *)rec.data + attr.attrOffset,
+                  (char *)rec.data + attr.attrOffset + attr.attrLen);
+  }
+  CALL(relCat->destroyRel(RESULTNAME));
+}
+
+
+// Benchmark of ORDER BY ... LIMIT n: the top-N heap of
+// Operators::OrderBy against a SortedFile read for its first n tuples,
+// on an attribute of a relation of a database.
+int main(int argc, char *argv[])
+{
+  if (argc < 4) {
+    cerr << "Usage: " << argv[0] << " dbname relation attribute [N ...]" << endl;
+    return 1;
+  }
+
+  if (chdir(argv[1]) < 0) {
+    perror("chdir");
+    exit(1);
+  }
+
+  // create buffer manager
+  bufMgr = new BufMgr(32);
+
+  // open relation and attribute catalogs
+  Status status;
+
+  relCat = new RelCatalog(status);
+  if (status == OK)
+    attrCat = new AttrCatalog(status);
+  if (status != OK) {
+    error.print(status);
+    exit(1);
+  }
+
+  AttrDesc attr;
+  CALL(attrCat->getInfo(argv[2], argv[3], attr));
+
+  AttrDesc *attrs;
+  int attrCnt;
+  CALL(attrCat->getRelInfo(argv[2], attrCnt, attrs));
+  int tupleLen = 0;
+  for(int i = 0; i < attrCnt; i++)
+    tupleLen += attrs[i].attrLen;
+
+  vector<int> ns;
+  for(int i = 4; i < argc; i++)
+    ns.push_back(atoi(argv[i]));
+  if (ns.empty()) {
+    ns.push_back(1);
+    ns.push_back(10);
+    ns.push_back(100);
+  }
+
+  printf("%8s %12s %12s %6s %s\n", "N", "top-N ms", "sorted ms", "runs", "same");
+  for(unsigned int k = 0; k < ns.size(); k++) {
+    double heapBest = 0, sortBest = 0;
+    vector<char> heapKeys, sortKeys;
+    int runCnt = 0;
+
+    for(int r = 0; r < ROUNDS; r++) {
+      double start = now();
+      orderByTopN(attr, attrCnt, attrs, ns[k], heapKeys);
+      double t = now() - start;
+      if (r == 0 || t < heapBest)
+        heapBest = t;
+
+      start = now();
+      sortedFileTopN(attr, tupleLen, ns[k], sortKeys, runCnt);
+      t = now() - start;
+      if (r == 0 || t < sortBest)
+        sortBest = t;
+    }
+
+    // ties may be broken differently, but the keys are the same
+    printf("%8d %12.2f %12.2f %6d %s\n", ns[k], heapBest * 1000, sortBest * 1000,
+           runCnt, heapKeys == sortKeys ? "yes" : "NO");
+  }
+
+  delete [] attrs;
+  delete relCat;
+  delete attrCat;
+
+  delete bufMgr;
+
+  return 0;
+}
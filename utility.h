@@ -18,7 +18,18 @@ public:
 
    // A utility to print a relation
    static Status Print(string relation);
-   
+
+   // Collect the statistics of a relation for the optimizer (see StatCatalog)
+   static Status Analyze(const string & relation);
+
+   // Build a zone map on an attribute of a relation
+   static Status BuildZoneMap(const string & relation,
+                              const string & attrName);
+
+   // Rewrite a relation in the order of an attribute (CLUSTER)
+   static Status Cluster(const string & relation,
+                         const string & attrName);
+
    // Quit the database and perform any necessary cleanup
    static void Quit(void);
 
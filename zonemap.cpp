@@ -0,0 +1,29 @@
+#include "catalog.h"
+#include "utility.h"
+
+
+//
+// Builds a zone map on an attribute of the specified relation (see
+// ZoneMap in heapfile.h), so that filtered scans on it can skip the
+// pages that cannot match. A relation has at most MAXZONEMAPS of them.
+//
+// Returns:
+// 	OK on success
+// 	an error code otherwise
+//
+
+Status Utilities::BuildZoneMap(const string & relation, const string & attrName)
+{
+  Status status;
+  AttrDesc attr;
+
+  if ((status = attrCat->getInfo(relation, attrName, attr)) != OK)
+    return status;
+
+  HeapFileScan hfile(attr.relName, status);
+  if (status != OK)
+    return status;
+
+  return hfile.addZoneMap(attr.attrOffset, attr.attrLen,
+                          static_cast<Datatype>(attr.attrType));
+}